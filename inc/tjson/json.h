@@ -32,6 +32,7 @@ SOFTWARE.
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/uio.h>
 
 /*============================================================================
         Defines
@@ -41,6 +42,42 @@ SOFTWARE.
 #define EOK 0
 #endif
 
+/*! JSON_Hash flag: object members hash the same in any order */
+#define JSON_HASH_UNORDERED     ( 1 << 0 )
+
+/*! JSON_Hash flag: do not use or update the cached container hashes */
+#define JSON_HASH_NOCACHE       ( 1 << 1 )
+
+/*! JNode flag: the node is stored in memory it does not own */
+#define JSON_NODE_ARENA         ( 1 << 0 )
+
+/*! JNode flag: the node is the start of a single allocation holding
+    its whole subtree */
+#define JSON_NODE_BLOCK         ( 1 << 1 )
+
+/*! JNode flag: the node is stored inline in the allocation of the small
+    container it was parsed into */
+#define JSON_NODE_INLINE        ( 1 << 2 )
+
+/*! JNode flag: the node is a small container allocated together with
+    its inline members */
+#define JSON_NODE_SMALL         ( 1 << 3 )
+
+/*! JNode flag: the node was relocated into contiguous storage by
+    JSON_Compact */
+#define JSON_NODE_COMPACT       ( 1 << 4 )
+
+/*! JNode flag: the node is the root of a document parsed into its own
+    arena, which is freed with it */
+#define JSON_NODE_DOCUMENT      ( 1 << 5 )
+
+/*! JNode flag: the members of the container are shared by persistent
+    versions (see JSON_SetPathPersistent), so it is read-only */
+#define JSON_NODE_SHARED        ( 1 << 6 )
+
+/*! size of the description of a parse error */
+#define JSON_PARSE_MESSAGE_LEN  ( 128 )
+
 /*============================================================================
         Public Types
 ============================================================================*/
@@ -132,7 +169,10 @@ typedef enum _JType
     JSON_VAR = 3,
 
     /*! JSON Boolean */
-    JSON_BOOL = 4
+    JSON_BOOL = 4,
+
+    /*! JSON null */
+    JSON_NULL = 5
 } JType;
 
 /*! The JNode object is the first member of every JSON object.
@@ -141,13 +181,22 @@ typedef enum _JType
 typedef struct _JNode
 {
     /*! type of the JSON object */
-    JType type;
+    JType type : 8;
+
+    /*! JSON_NODE_xxx storage flags */
+    uint32_t flags : 24;
+
+    /*! number of references held in addition to the owner's reference */
+    uint32_t refcount;
 
     /*! name of the JSON object */
     char *name;
 
     /*! pointer to the next JSON object */
     struct _JNode *pNext;
+
+    /*! pointer to the previous JSON object */
+    struct _JNode *pPrev;
 } JNode;
 
 
@@ -168,6 +217,16 @@ typedef struct _JArray
     /*! pointer to the last JSON object in the JSON Array */
     JNode *pLast;
 
+    /*! cached unordered structural hash of the JSON Array */
+    uint64_t hash;
+
+    /*! modification epoch the cached hash is valid for */
+    uint64_t hashEpoch;
+
+    /*! node whose name and members are shared by this persistent version
+        of it, or NULL if this node owns them */
+    JNode *pShared;
+
 } JArray;
 
 
@@ -188,6 +247,22 @@ typedef struct _JObject
     /*! pointer to the last member of the JSON object */
     JNode *pLast;
 
+    /*! cached unordered structural hash of the JSON object */
+    uint64_t hash;
+
+    /*! modification epoch the cached hash is valid for */
+    uint64_t hashEpoch;
+
+    /*! node whose name and members are shared by this persistent version
+        of it, or NULL if this node owns them */
+    JNode *pShared;
+
+    /*! hash index of the members of a large JSON object, or NULL */
+    struct _JObjectIndex *pIndex;
+
+    /*! sorted key table of a frozen JSON object, or NULL */
+    struct _JObjectKeys *pKeys;
+
 } JObject;
 
 /*! A variable object */
@@ -216,6 +291,255 @@ typedef struct _JVar
 
 } JVar;
 
+/*! opaque handle for a JSON file watcher */
+typedef struct _JWatch JWatch;
+
+/*! The JSON_WatchFn callback is invoked by a JSON file watcher when
+    the watched file has changed.  pDoc is the newly parsed document
+    and pChanges is an array of JSON string values containing the
+    JSON Pointers (RFC 6901) of every value which was added, removed
+    or modified.  The first callback after the watcher starts reports
+    the whole document with the root pointer "".  Both pDoc and pChanges
+    are owned by the watcher and are only valid for the duration of the
+    callback */
+typedef void (*JSON_WatchFn)( JNode *pDoc, JArray *pChanges, void *arg );
+
+/*! opaque memory arena */
+typedef struct _JArena JArena;
+
+/*! opaque content addressed parse cache */
+typedef struct _JParseCache JParseCache;
+
+/*! The JParseCacheStats object is a snapshot of the counters
+    maintained by a parse cache */
+typedef struct _JParseCacheStats
+{
+    /*! number of inputs served from the cache */
+    uint64_t hits;
+
+    /*! number of inputs which had to be parsed */
+    uint64_t misses;
+
+    /*! number of documents evicted from the cache */
+    uint64_t evictions;
+
+    /*! number of documents currently cached */
+    size_t entries;
+
+    /*! total size of the currently cached inputs */
+    size_t bytes;
+
+} JParseCacheStats;
+
+/*! The JObjectIndexStats object is a snapshot of the counters
+    maintained for the hash indexes of large JSON objects */
+typedef struct _JObjectIndexStats
+{
+    /*! number of objects which switched to a hash index */
+    uint64_t promotions;
+
+    /*! number of objects which dropped their hash index */
+    uint64_t demotions;
+
+    /*! number of times a hash index was grown */
+    uint64_t resizes;
+
+} JObjectIndexStats;
+
+/*! The JParseStats object is a snapshot of the sizing decisions made
+    when parsing documents into their own arenas */
+typedef struct _JParseStats
+{
+    /*! number of documents parsed into arenas */
+    uint64_t documents;
+
+    /*! number of documents which did not fit in their first block */
+    uint64_t overflows;
+
+    /*! moving average of the arena bytes used per document */
+    size_t estimate;
+
+    /*! size of the first arena block of the last document */
+    size_t reserved;
+
+    /*! arena bytes used by the last document */
+    size_t used;
+
+    /*! number of arena blocks used by the last document */
+    size_t blocks;
+
+} JParseStats;
+
+/*! The JParseLimits object specifies the resources a single parse
+    of untrusted input may consume.  A limit of zero is unlimited. */
+typedef struct _JParseLimits
+{
+    /*! maximum number of bytes allocated for nodes, names and strings */
+    size_t maxBytes;
+
+    /*! maximum nesting depth of objects and arrays */
+    size_t maxDepth;
+
+    /*! maximum length of a name or string as it appears in the input */
+    size_t maxString;
+
+    /*! maximum number of members of a single object or array */
+    size_t maxMembers;
+
+    /*! maximum number of nodes in the document */
+    size_t maxNodes;
+
+} JParseLimits;
+
+/*! The JParseLimit enumeration identifies the parse limit which was
+    exceeded */
+typedef enum _JParseLimit
+{
+    /*! no limit was exceeded */
+    JSON_LIMIT_NONE = 0,
+
+    /*! too many bytes were allocated */
+    JSON_LIMIT_BYTES,
+
+    /*! objects or arrays were nested too deeply */
+    JSON_LIMIT_DEPTH,
+
+    /*! a name or string was too long */
+    JSON_LIMIT_STRING,
+
+    /*! an object or array had too many members */
+    JSON_LIMIT_MEMBERS,
+
+    /*! the document had too many nodes */
+    JSON_LIMIT_NODES
+
+} JParseLimit;
+
+/*! The JParseError object describes why a parse failed */
+typedef struct _JParseError
+{
+    /*! EOK, E2BIG if a limit was exceeded, EINVAL for invalid input or
+        ENOMEM if memory allocation failed */
+    int error;
+
+    /*! the limit which was exceeded when error is E2BIG */
+    JParseLimit limit;
+
+    /*! offset of the input at which the parse failed */
+    size_t offset;
+
+    /*! line number at which the parse failed */
+    size_t line;
+
+    /*! description of the error, naming the unexpected and expected
+        tokens of a syntax error */
+    char message[JSON_PARSE_MESSAGE_LEN];
+
+} JParseError;
+
+/*! The JStreamStats object counts the records of a stream of newline
+    delimited JSON processed by JSON_ProcessStream */
+typedef struct _JStreamStats
+{
+    /*! number of lines read */
+    uint64_t lines;
+
+    /*! number of records which were parsed */
+    uint64_t good;
+
+    /*! number of malformed records which were skipped */
+    uint64_t bad;
+
+    /*! number of bytes read */
+    uint64_t bytes;
+
+} JStreamStats;
+
+/*! The JSON_RecordFn callback is invoked by JSON_ProcessStream for
+    each record of a stream.  pRecord is the parsed record, which is
+    owned by the callback, or NULL if the record was malformed, in which
+    case pError describes the error.  Processing stops if the callback
+    does not return EOK */
+typedef int (*JSON_RecordFn)( JNode *pRecord, JParseError *pError, void *arg );
+
+/*! The JSON_ElementFn callback is invoked by JSON_StreamArray for each
+    element of a streamed array.  pElement is freed when the callback
+    returns, and idx is its position in the array.  The stream is
+    stopped if the callback does not return EOK */
+typedef int (*JSON_ElementFn)( JNode *pElement, size_t idx, void *arg );
+
+/*! The JSON_LoadFn callback is invoked by JSON_LoadMany for each file.
+    pDoc is the parsed document, which is owned by the callback, or NULL
+    if the file could not be loaded, in which case error is the reason.
+    The callback may be invoked concurrently from several threads */
+typedef void (*JSON_LoadFn)( size_t idx,
+                             char *path,
+                             JNode *pDoc,
+                             int error,
+                             void *arg );
+
+/*! opaque asynchronous JSON record writer */
+typedef struct _JAsyncSink JAsyncSink;
+
+/*! The JAsyncSinkConfig object configures an asynchronous JSON record
+    writer.  Zero sizes select the defaults. */
+typedef struct _JAsyncSinkConfig
+{
+    /*! size of each output buffer, and the largest record */
+    size_t bufferSize;
+
+    /*! number of output buffers, at least two */
+    size_t buffers;
+
+    /*! milliseconds after which a partly filled buffer is written,
+        or zero to write buffers only when they are full or flushed */
+    unsigned int flushInterval;
+
+    /*! true to drop records when every buffer is waiting to be written,
+        false to make the writers of records wait for a buffer */
+    bool drop;
+
+} JAsyncSinkConfig;
+
+/*! The JAsyncSinkStats object is a snapshot of the counters
+    maintained by an asynchronous JSON record writer */
+typedef struct _JAsyncSinkStats
+{
+    /*! number of records accepted */
+    uint64_t records;
+
+    /*! number of records dropped */
+    uint64_t dropped;
+
+    /*! number of bytes written */
+    uint64_t bytes;
+
+    /*! number of buffers written */
+    uint64_t writes;
+
+    /*! number of times a record writer waited for a buffer */
+    uint64_t waits;
+
+    /*! first error returned by write, or EOK */
+    int error;
+
+} JAsyncSinkStats;
+
+/*! The JCompression enumeration identifies the compression format of
+    a JSON input or output stream */
+typedef enum _JCompression
+{
+    /*! uncompressed */
+    JSON_COMPRESSION_NONE = 0,
+
+    /*! gzip, when built with zlib */
+    JSON_COMPRESSION_GZIP,
+
+    /*! zstd, when built with libzstd */
+    JSON_COMPRESSION_ZSTD
+
+} JCompression;
+
 /*============================================================================
         Public Function Declarations
 ============================================================================*/
@@ -224,6 +548,41 @@ JNode *JSON_Process( char *inputFile );
 
 JNode *JSON_ProcessBuffer( char *buf );
 
+JNode *JSON_ProcessIov( const struct iovec *iov, int cnt );
+
+JNode *JSON_ProcessBufferArena( char *buf );
+
+void JSON_GetParseStats( JParseStats *pStats );
+
+JNode *JSON_ProcessBufferLimited( char *buf,
+                                  JParseLimits *pLimits,
+                                  JParseError *pError );
+
+void JSON_GetParseError( JParseError *pError );
+
+int JSON_ProcessStream( FILE *fp,
+                        JParseLimits *pLimits,
+                        JSON_RecordFn fn,
+                        void *arg,
+                        JStreamStats *pStats );
+
+FILE *JSON_Decompress( FILE *fp );
+
+int JSON_StreamArray( char *inputFile, JSON_ElementFn fn, void *arg );
+
+int JSON_StreamArrayFd( int fd, JSON_ElementFn fn, void *arg );
+
+int JSON_LoadMany( char *paths[],
+                   size_t n,
+                   int nthreads,
+                   JSON_LoadFn fn,
+                   void *arg );
+
+JObject *JSON_LoadDirectory( char *dir,
+                             char *pattern,
+                             int nthreads,
+                             JObject **ppReport );
+
 int JSON_Parse( char *inputFile,
 				char *outputFile,
 				bool debug );
@@ -242,10 +601,34 @@ int JSON_ArrayAdd( JArray *pArray, JObject *pObject );
 
 int JSON_ObjectAdd( JObject *pObject, JNode *pNode );
 
+int JSON_Remove( JNode *pContainer, JNode *pNode );
+
+int JSON_ArrayInsertAt( JArray *pArray, size_t idx, JNode *pNode );
+
+int JSON_ObjectReplace( JObject *pObject, JNode *pNode );
+
 void JSON_Free( JNode *json );
 
+JNode *JSON_Retain( JNode *json );
+
+void JSON_Release( JNode *json );
+
 void JSON_Print( JNode *json, FILE *fp, bool comma );
 
+int JSON_PrintFd( JNode *json, int fd );
+
+FILE *JSON_Compress( FILE *fp, JCompression type, int level );
+
+JAsyncSink *JSON_AsyncSink( int fd, JAsyncSinkConfig *pConfig );
+
+int JSON_AsyncSinkWrite( JAsyncSink *pSink, JNode *json );
+
+int JSON_AsyncSinkFlush( JAsyncSink *pSink );
+
+int JSON_AsyncSinkStats( JAsyncSink *pSink, JAsyncSinkStats *pStats );
+
+int JSON_AsyncSinkStop( JAsyncSink *pSink );
+
 JArray *JSON_Array( char *name );
 
 JObject *JSON_Object( char *name );
@@ -260,6 +643,8 @@ JVar *JSON_Float( char *name, float num );
 
 JVar *JSON_Bool( char *name, int num );
 
+JVar *JSON_Null( char *name );
+
 JVar *JSON_Str( char *name, char *str );
 
 char *JSON_GetStr( JNode *pNode, char *name );
@@ -276,6 +661,56 @@ int JSON_GetFloat( JNode *pNode, char *name, float *pVal );
 
 int JSON_GetArraySize( JArray *pArray );
 
+int JSON_SetNum( JNode *pNode, char *name, int val );
+
+int JSON_SetI64( JNode *pNode, char *name, int64_t val );
+
+int JSON_SetFloat( JNode *pNode, char *name, float val );
+
+int JSON_SetStr( JNode *pNode, char *name, char *str );
+
+uint64_t JSON_Hash( JNode *pNode, uint32_t flags );
+
+bool JSON_Equal( JNode *a, JNode *b );
+
+void JSON_HashInvalidate( void );
+
+void JSON_SetObjectIndexThreshold( size_t threshold );
+
+void JSON_SetSmallContainerMax( size_t max );
+
+void JSON_GetObjectIndexStats( JObjectIndexStats *pStats );
+
+JArray *JSON_Diff( JNode *a, JNode *b );
+
+int JSON_ApplyPatch( JNode *doc, JArray *patch );
+
+int JSON_MergePatch( JNode *doc, JNode *merge );
+
+JNode *JSON_SetPathPersistent( JNode *root, char *path, JNode *value );
+
+JArena *JSON_ArenaCreate( size_t blockSize );
+
+void JSON_ArenaDestroy( JArena *pArena );
+
+JNode *JSON_Clone( JNode *pNode, JArena *pArena );
+
+JNode *JSON_CloneSorted( JNode *pNode, JArena *pArena );
+
+int JSON_Compact( JNode *json );
+
+JWatch *JSON_Watch( char *path, JSON_WatchFn fn, void *arg );
+
+void JSON_WatchStop( JWatch *pWatch );
+
+JParseCache *JSON_CacheCreate( size_t maxEntries, size_t maxBytes );
+
+JNode *JSON_CacheProcessBuffer( JParseCache *pCache, char *buf );
+
+int JSON_CacheStats( JParseCache *pCache, JParseCacheStats *pStats );
+
+void JSON_CacheDestroy( JParseCache *pCache );
+
 #endif /* JSON_H */
 
 
@@ -33,6 +33,10 @@ SOFTWARE.
 #include <string.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#include <unistd.h>
 #include <tjson/json.h>
 
 /*============================================================================
@@ -43,6 +47,31 @@ SOFTWARE.
 #define EOK 0
 #endif
 
+/*! default number of members at which a JSON object is indexed */
+#define JSON_INDEX_THRESHOLD    ( 16 )
+
+/*! smallest number of slots in a JSON object index */
+#define JSON_INDEX_MIN_SIZE     ( 64 )
+
+/*! default largest container whose scalar members are stored inline */
+#define JSON_SMALL_MAX          ( 8 )
+
+/*! largest container which can be packed, limited by the size of the
+    inline slot number */
+#define JSON_SMALL_LIMIT        ( 0xFF )
+
+/*! position of the inline slot number in the flags of an inline node */
+#define JSON_SMALL_SLOT_SHIFT   ( 8 )
+
+/*! smallest first block of a document arena */
+#define JSON_PARSE_MIN_BLOCK    ( 4096 )
+
+/*! weight of a new document in the document size average, as a shift */
+#define JSON_PARSE_EWMA_SHIFT   ( 3 )
+
+/*! headroom added to the average document size, as a shift */
+#define JSON_PARSE_HEADROOM     ( 2 )
+
 typedef struct yy_buffer_state * YY_BUFFER_STATE;
 
 /*============================================================================
@@ -61,23 +90,222 @@ extern int yyparse();
 /*! string scanning function */
 extern YY_BUFFER_STATE yy_scan_string( char *);
 
+/*! in place buffer scanning function */
+extern YY_BUFFER_STATE yy_scan_buffer( char *, size_t );
+
 /*! scanneri delete buffer */
 extern void yy_delete_buffer( YY_BUFFER_STATE );
 
 /*! scanner destroy function */
 extern int yylex_destroy( void );
 
+/*! scan input held in a list of fragments */
+extern void json_LexIov( const struct iovec *iov, int cnt );
+
+/*! look up a member in the sorted key table of a frozen object */
+extern JNode *json_KeysFind( struct _JObjectKeys *pKeys, char *name );
+
+/*! release a node stored in a compacted block */
+extern void json_CompactRelease( JNode *json, uint32_t flags );
+
+/*! allocate memory from an arena */
+extern void *json_ArenaAlloc( JArena *pArena, size_t size );
+
+/*! create the arena for a parsed document */
+extern JArena *json_ArenaDocument( size_t size, size_t blockSize );
+
+/*! install the root node of a parsed document */
+extern JNode *json_ArenaDocumentRoot( JArena *pArena, JNode *pRoot );
+
+/*! free a parsed document and its arena */
+extern void json_ArenaDocumentFree( JNode *pRoot );
+
+/*! get the number of bytes allocated from an arena */
+extern size_t json_ArenaUsed( JArena *pArena, size_t *pBlocks );
+
 /*! pointer to the root of the parsed JSON object */
 extern JNode *root;
 
+/*! number of input characters consumed by the scanner */
+extern size_t json_lexOffset;
+
+/*! line number of the scanner */
+extern int yylineno;
+
 /*============================================================================
         Public Types
 ============================================================================*/
 
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! JSON object index slot */
+typedef struct _JObjectIndexSlot
+{
+    /*! hash of the member name */
+    uint32_t hash;
+
+    /*! pointer to the member, or NULL if the slot is free */
+    JNode *pNode;
+
+} JObjectIndexSlot;
+
+/*! open addressing hash index of the members of a JSON object */
+typedef struct _JObjectIndex
+{
+    /*! number of slots (a power of 2) */
+    size_t size;
+
+    /*! number of occupied slots */
+    size_t count;
+
+    /*! linearly probed slots */
+    JObjectIndexSlot slots[];
+
+} JObjectIndex;
+
+/*! single allocation holding a small container and its scalar members */
+typedef struct _JSmallBlock
+{
+    /*! the container (a JArray uses the leading part of it) */
+    JObject container;
+
+    /*! number of nodes in the block which have not been freed */
+    uint32_t live;
+
+    /*! inline scalar members */
+    JVar members[];
+
+} JSmallBlock;
+
+/*! state of the parse being run by the calling thread */
+typedef struct _JParseContext
+{
+    /*! arena the document is parsed into, or NULL to use the heap */
+    JArena *pArena;
+
+    /*! limits applied to the parse, or NULL if it is unlimited */
+    JParseLimits *pLimits;
+
+    /*! number of bytes allocated so far */
+    size_t bytes;
+
+    /*! number of nodes allocated so far */
+    size_t nodes;
+
+    /*! current nesting depth */
+    size_t depth;
+
+    /*! first error which aborted the parse */
+    JParseError status;
+
+    /*! function receiving the elements of a streamed array, or NULL */
+    JSON_ElementFn fn;
+
+    /*! argument passed to the element function */
+    void *arg;
+
+    /*! index of the next streamed element */
+    size_t index;
+
+} JParseContext;
+
+/*============================================================================
+        Private File Scoped Variables
+============================================================================*/
+
+/*! the lex/yacc parser uses global state, so all parses are serialized */
+static pthread_mutex_t json_parseLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*! modification epoch used to validate cached container hashes */
+static uint64_t json_hashEpoch = 1;
+
+/*! number of members at which a JSON object is indexed */
+static size_t json_indexThreshold = JSON_INDEX_THRESHOLD;
+
+/*! largest container whose scalar members are stored inline */
+static size_t json_smallMax = JSON_SMALL_MAX;
+
+/*! JSON object index counters */
+static JObjectIndexStats json_indexStats;
+
+/*! context of the parse being run by the calling thread, or NULL */
+static __thread JParseContext *json_parseContext;
+
+/*! outcome of the last parse run by the calling thread */
+static __thread JParseError json_parseError;
+
+/*! descriptions of parse failures, indexed by the limit which was
+    exceeded, or JSON_LIMIT_NONE for an allocation failure */
+static const char *json_limitMessages[] =
+{
+    "memory exhausted",
+    "byte limit exceeded",
+    "depth limit exceeded",
+    "string length limit exceeded",
+    "member limit exceeded",
+    "node limit exceeded"
+};
+
+/*! document arena sizing state, protected by json_parseLock */
+static JParseStats json_parseStats;
+
 /*============================================================================
         Private Function Declarations
 ============================================================================*/
+static void *json_NodeAlloc( size_t size );
+char *json_StrDup( char *str, size_t len );
+void json_StrFree( char *str );
+static JArena *json_ParseArena( void );
+static int json_ParseCharge( JParseContext *pContext,
+                             size_t bytes,
+                             size_t nodes );
+static int json_ParseFail( JParseContext *pContext,
+                           int error,
+                           JParseLimit limit );
+void json_ParseSyntax( const char *msg, size_t offset, size_t line );
+void json_ParseInput( int error );
+static void json_ParseStart( JParseContext *pContext,
+                             JArena *pArena,
+                             JParseLimits *pLimits );
+static int json_ParseEnd( JParseContext *pContext, int rc );
+int json_ParseEnter( JType type );
+void json_ParseLeave( void );
+int json_ParseMember( JNode *pContainer );
+int json_ParseAppend( JNode *pArray, JNode *pElement );
+static int json_StreamFile( FILE *fp, JSON_ElementFn fn, void *arg );
+JNode *json_ProcessInPlace( char *buf, size_t len, uint64_t *pUsec );
+static void json_ParseSized( JArena *pArena, size_t reserved );
+static void json_FreeNode( JNode *json );
+void json_FreeStorage( JNode *json, uint32_t flags );
+JNode *json_SmallPack( JNode *pNode );
+static void json_SmallRelease( JNode *json, uint32_t flags );
+static bool json_SmallMember( JNode *pNode );
+static JNode *json_Nth( JObject *pContainer, size_t idx );
+static bool json_Contains( JObject *pContainer, JNode *pNode );
 static void json_PrintValue( JVar *pVar, FILE *fp );
+static uint64_t json_HashNode( JNode *pNode, uint32_t flags );
+static uint64_t json_HashStr( char *str );
+static uint64_t json_HashMix( uint64_t x );
+static bool json_VarEqual( JVarObject *a, JVarObject *b );
+static JNode *json_Namesake( JObject *pObject,
+                             JNode *pMember,
+                             JObject *pOther );
+static JNode *json_NextNamed( JNode *pNode, char *name );
+static int json_VarInt( JVarObject *pVar, int64_t *pVal );
+bool json_HashCached( JNode *pNode, uint64_t *pHash );
+static void json_HashModified( JObject *pContainer );
+static JVar *json_SetMember( JNode *pNode, char *name, int *pResult );
+static void json_SetVar( JObject *pObject, JVar *pVar, JVarObject *pValue );
+static bool json_IntFits( JVarType type, int64_t val );
+static JNode *json_IndexFind( JObjectIndex *pIndex, char *name );
+static void json_IndexAdd( JObject *pObject, JNode *pNode );
+static void json_IndexRemove( JObject *pObject, JNode *pNode );
+void json_IndexReplace( JObject *pObject, JNode *pOld, JNode *pNew );
+int json_IndexBuild( JObject *pObject );
+static void json_IndexInsert( JObjectIndex *pIndex, JNode *pNode );
+static size_t json_IndexSlot( JObjectIndex *pIndex, JNode *pNode );
 
 /*============================================================================
         Public Function Declarations
@@ -90,29 +318,66 @@ static void json_PrintValue( JVar *pVar, FILE *fp );
 
     The JSON_Process function processes a JSON object from a file
     and builds an in-memory JSON object, returning the root node
-    to the user
+    to the user.  A gzip or zstd compressed file is decompressed as
+    it is parsed, see JSON_Decompress.
 
     @param[in]
         inputFile
             name of the JSON input file
 
     @retval pointer to the parsed JSON object
-    @retval NULL if the JSON object is invalid
+    @retval NULL if the JSON object is invalid.  The reason is available
+            from JSON_GetParseError
 
 ============================================================================*/
 JNode *JSON_Process( char *inputFile )
 {
     JNode *node = NULL;
+    JParseContext context;
+    FILE *fp;
+    int rc;
 
     if ( inputFile != (char *)NULL )
     {
-        /* input file was specified */
-        if ((yyin = fopen(inputFile, "r")) != (FILE *)NULL)
+        pthread_mutex_lock( &json_parseLock );
+
+        /* input file was specified, and may be compressed */
+        fp = fopen( inputFile, "r" );
+        yyin = ( fp != NULL ) ? JSON_Decompress( fp ) : NULL;
+        if ( yyin != (FILE *)NULL )
         {
-            yyparse();
-            node = root;
+            json_ParseStart( &context, NULL, NULL );
+
+            root = NULL;
+            rc = yyparse();
+
             fclose( yyin );
+
+            /* reset the scanner so the next parse starts from a clean state */
+            yylex_destroy();
+
+            rc = json_ParseEnd( &context, rc );
+            if ( rc == 0 )
+            {
+                node = root;
+            }
+        }
+        else
+        {
+            memset( &json_parseError, 0, sizeof( json_parseError ) );
+            json_parseError.error = errno;
+            snprintf( json_parseError.message,
+                      sizeof( json_parseError.message ),
+                      "%s",
+                      strerror( errno ) );
+
+            if ( fp != NULL )
+            {
+                fclose( fp );
+            }
         }
+
+        pthread_mutex_unlock( &json_parseLock );
     }
 
     return node;
@@ -132,21 +397,30 @@ JNode *JSON_Process( char *inputFile )
             pointer to the input buffer
 
     @retval pointer to the parsed JSON object
-    @retval NULL if the JSON object is invalid
+    @retval NULL if the JSON object is invalid.  The reason is available
+            from JSON_GetParseError
 
 ============================================================================*/
 JNode *JSON_ProcessBuffer( char *buf )
 {
     JNode *node = NULL;
+    JParseContext context;
     int rc;
     YY_BUFFER_STATE buffer;
 
     if ( buf != NULL )
     {
+        pthread_mutex_lock( &json_parseLock );
+
+        json_ParseStart( &context, NULL, NULL );
+
+        root = NULL;
         buffer = yy_scan_string(buf);
 
         rc = yyparse();
 
+        rc = json_ParseEnd( &context, rc );
+
         if ( rc == 0 )
         {
             node = root;
@@ -155,348 +429,498 @@ JNode *JSON_ProcessBuffer( char *buf )
        yy_delete_buffer(buffer);
 
        yylex_destroy();
+
+       pthread_mutex_unlock( &json_parseLock );
     }
 
     return node;
 }
 
 /*==========================================================================*/
-/*  JSON_Parse                                                              */
+/*  JSON_ProcessIov                                                         */
 /*!
-    Parse a JSON object from a file
-
-    The JSON_Parse function parses a JSON object from a file
-    and builds an in-memory JSON object.
+    Process a JSON object from a list of buffer fragments
 
-    @param[in]
-        inputFile
-            name of the JSON input file
+    The JSON_ProcessIov function parses a JSON object whose text is
+    split across a list of fragments, such as a chain of network
+    buffers, without first joining them into a single string.  The
+    scanner reads the fragments directly, and tokens may straddle
+    fragment boundaries.
 
     @param[in]
-        outputFile
-            name of the output file
+        iov
+            pointer to the fragments holding the JSON text, in order
 
     @param[in]
-        debug
-            true - enable debugging
-            false - disabled debugging
+        cnt
+            number of fragments
 
-    @retval -1 parsing failed
-    @retval 0 parsing successful
+    @retval pointer to the parsed JSON object
+    @retval NULL if the JSON object is invalid.  The reason is available
+            from JSON_GetParseError
 
 ============================================================================*/
-int JSON_Parse( char *inputFile,
-				char *outputFile,
-				bool debug )
+JNode *JSON_ProcessIov( const struct iovec *iov, int cnt )
 {
-    FILE *fp;
-
-	if( debug == true )
-	{
-		yydebug = 1;
-	}
+    JNode *node = NULL;
+    JParseContext context;
+    int rc;
 
-    if ( inputFile != (char *)NULL )
+    if( ( iov != NULL ) &&
+        ( cnt > 0 ) )
     {
-        /* input file was specified */
-        if ((yyin = fopen(inputFile, "r")) == (FILE *)NULL)
-        {
-            fprintf(stderr, "file %s not found.\n", inputFile );
-            return -1;
-        }
-    }
+        pthread_mutex_lock( &json_parseLock );
 
-    if( outputFile != NULL )
-    {
-        fp = fopen( outputFile, "w" );
-        if( fp == (FILE *)NULL )
+        json_ParseStart( &context, NULL, NULL );
+        json_LexIov( iov, cnt );
+
+        root = NULL;
+        rc = yyparse();
+
+        /* reset the scanner so the next parse starts from a clean state */
+        json_LexIov( NULL, 0 );
+        yylex_destroy();
+
+        rc = json_ParseEnd( &context, rc );
+        if( rc == 0 )
         {
-            fprintf(stderr, "Unable to create file: %s\n", outputFile );
-            return -1;
+            node = root;
         }
-    }
-    else
-    {
-        fp = stdout;
-    }
-
-	/* parse the input file */
-    yyparse();
 
-	JSON_Print(root, stdout, false );
-	printf("\n");
-	fclose( fp );
+        pthread_mutex_unlock( &json_parseLock );
+    }
 
-    return 0;
+    return node;
 }
 
 /*==========================================================================*/
-/*  JSON_Iterate                                                            */
+/*  JSON_ProcessBufferArena                                                 */
 /*!
-    Iterate through a JSON array applying a function to each array element
-
-    The JSON_Iterate function iterates through the specified JSON Array
-    invoking the specified function to every element in the array.
-    If any function invocation does not return EOK, the return value
-    will indicate the error of the last failed function, but the
-    iterator will continue to apply the function to all members
-    of the array.
+    Process a JSON object from a string buffer into its own arena
 
-    @param[in]
-        pArray
-            pointer to the JSON Array to iterate over
+    The JSON_ProcessBufferArena function parses a JSON object from a
+    string buffer like JSON_ProcessBuffer, but allocates all of its
+    nodes, names and strings from an arena which belongs to the
+    document.  The arena's first block is sized from a moving average
+    of the size of recent documents, with some headroom, so a parse in
+    steady state makes a single allocation.  A larger document spills
+    into overflow blocks.  The sizing decisions are reported by
+    JSON_GetParseStats.
 
-    @param[in]
-        fn
-            the function to apply to each JSON object in the array
+    The document is read-only, like a clone, and is freed, arena and
+    all, by a single call to JSON_Free on its root.  A failed parse
+    releases everything it allocated with the arena.
 
     @param[in]
-        arg
-            the argument to pass to the function each time it is invoked
+        buf
+            pointer to the input buffer
 
-    @retval EOK processed all elements in the JSON array
-    @retval EINVAL invalid arguments
-    @retval ENOTSUP the JSON specified is not a JSON array
-    @retval other error as returned by the invoked function
+    @retval pointer to the parsed JSON object
+    @retval NULL if the JSON object is invalid or memory allocation
+            failed
 
 ============================================================================*/
-int JSON_Iterate( JArray *pArray,
-                  int (*fn)(JNode *pNode, void *arg ),
-                  void *arg )
+JNode *JSON_ProcessBufferArena( char *buf )
 {
-    int result = EINVAL;
+    JNode *node = NULL;
+    JArena *pArena;
+    JParseContext context;
+    YY_BUFFER_STATE buffer;
+    size_t reserved;
     int rc;
-    JNode *pNode;
 
-    if( ( pArray != NULL ) &&
-        ( fn != NULL ) )
+    if ( buf != NULL )
     {
-        if( pArray->node.type == JSON_ARRAY )
+        pthread_mutex_lock( &json_parseLock );
+
+        reserved = json_parseStats.estimate +
+                   ( json_parseStats.estimate >> JSON_PARSE_HEADROOM );
+        if( reserved < JSON_PARSE_MIN_BLOCK )
         {
-            result = EOK;
+            reserved = JSON_PARSE_MIN_BLOCK;
+        }
 
-            pNode = pArray->pFirst;
-            while( pNode != NULL )
+        pArena = json_ArenaDocument( reserved, reserved >> 1 );
+        if( pArena != NULL )
+        {
+            json_ParseStart( &context, pArena, NULL );
+
+            root = NULL;
+            buffer = yy_scan_string(buf);
+
+            rc = yyparse();
+
+            yy_delete_buffer(buffer);
+
+            yylex_destroy();
+
+            rc = json_ParseEnd( &context, rc );
+
+            if( ( rc == 0 ) && ( root != NULL ) )
             {
-                rc = fn( pNode, arg );
-                if( rc != EOK )
-                {
-                    result = rc;
-                }
-                pNode = pNode->pNext;
+                node = json_ArenaDocumentRoot( pArena, root );
+                json_ParseSized( pArena, reserved );
+            }
+            else
+            {
+                /* the partial document is released with its arena */
+                JSON_ArenaDestroy( pArena );
             }
         }
-        else
-        {
-            result = ENOTSUP;
-        }
+
+        pthread_mutex_unlock( &json_parseLock );
     }
 
-    return result;
+    return node;
 }
 
 /*==========================================================================*/
-/*  JSON_Attribute                                                          */
+/*  JSON_GetParseStats                                                      */
 /*!
-    Get the value of the JSON attribute with the specified name
+    Get document arena sizing statistics
 
-    The JSON_Attribute function gets the value of the JSON attribute
-    with the specified name inside the specified JSON object.
-
-    @param[in]
-        pObject
-            pointer to the JSON Object to search
-
-    @param[in]
-        attribute
-            the name of the attribute in the JSON object
+    The JSON_GetParseStats function gets the moving average document
+    size used to size the arenas of documents parsed by
+    JSON_ProcessBufferArena, and how the last document fitted in the
+    arena it was given.
 
-    @retval pointer to the named attribute
-    @retval NULL if the named attribute cannot be found
+    @param[out]
+        pStats
+            pointer to a location to store the statistics
 
 ============================================================================*/
-JNode *JSON_Attribute( JObject *pObject, char *attribute )
+void JSON_GetParseStats( JParseStats *pStats )
 {
-    JNode *pNode = NULL;
-
-    if( ( pObject != NULL ) &&
-        ( attribute != NULL ) )
+    if( pStats != NULL )
     {
-        if( pObject->node.type == JSON_OBJECT )
-        {
-            pNode = pObject->pFirst;
-            while( pNode != NULL )
-            {
-                if( pNode->name != NULL )
-                {
-                    if( strcmp( pNode->name, attribute ) == 0 )
-                    {
-                        break;
-                    }
-                }
-
-                pNode = pNode->pNext;
-            }
-        }
+        pthread_mutex_lock( &json_parseLock );
+        *pStats = json_parseStats;
+        pthread_mutex_unlock( &json_parseLock );
     }
-
-    return pNode;
 }
 
 /*==========================================================================*/
-/*  JSON_Index                                                              */
+/*  JSON_ProcessBufferLimited                                               */
 /*!
-    Get the value of the JSON array element at the specified index
+    Process a JSON object from an untrusted string buffer
 
-    The JSON_Index function gets the value of the JSON array
-    element at the specified index
+    The JSON_ProcessBufferLimited function parses a JSON object from a
+    string buffer like JSON_ProcessBuffer, but enforces limits on the
+    memory, nesting depth, string length, container size and number of
+    nodes the parse may consume.  The limits are checked as each node
+    and string is allocated and as each object or array is entered, so
+    the parse is aborted as soon as one is exceeded, and everything it
+    allocated is released.
 
     @param[in]
-        pArray
-            pointer to the JSON Array to index
+        buf
+            pointer to the input buffer
 
     @param[in]
-        idx
-            the index of the JSON array to retrieve
+        pLimits
+            pointer to the parse limits, or NULL for no limits
 
-    @retval pointer to the JSON element at the specified index
-    @retval NULL if the named attribute cannot be found
+    @param[out]
+        pError
+            optional pointer to a location to store the reason the
+            parse failed
+
+    @retval pointer to the parsed JSON object
+    @retval NULL if the JSON object is invalid, a limit was exceeded,
+            or memory allocation failed
 
 ============================================================================*/
-JNode *JSON_Index( JArray *pArray, size_t idx )
+JNode *JSON_ProcessBufferLimited( char *buf,
+                                  JParseLimits *pLimits,
+                                  JParseError *pError )
 {
-    JNode *pNode;
-    JNode *result = NULL;
-
-    size_t n = 0;
+    JNode *node = NULL;
+    JParseContext context;
+    YY_BUFFER_STATE buffer;
+    int rc;
 
-    if( pArray != NULL )
+    if ( buf != NULL )
     {
-        if( pArray->node.type == JSON_ARRAY )
-        {
-            pNode = pArray->pFirst;
-            while( pNode != NULL )
-            {
-                if( idx == n )
-                {
-                    result = pNode;
-                    break;
-                }
+        pthread_mutex_lock( &json_parseLock );
 
-                n++;
-                pNode = pNode->pNext;
-            }
+        json_ParseStart( &context, NULL, pLimits );
+
+        root = NULL;
+        buffer = yy_scan_string(buf);
+
+        rc = yyparse();
+
+        yy_delete_buffer(buffer);
+
+        yylex_destroy();
+
+        rc = json_ParseEnd( &context, rc );
+
+        if ( rc == 0 )
+        {
+            node = root;
         }
+
+        pthread_mutex_unlock( &json_parseLock );
+    }
+    else
+    {
+        memset( &context, 0, sizeof( context ) );
+        context.status.error = EINVAL;
     }
 
-    return result;
+    if( pError != NULL )
+    {
+        *pError = context.status;
+    }
+
+    return node;
 }
 
 /*==========================================================================*/
-/*  JSON_ArrayAdd                                                           */
+/*  JSON_GetParseError                                                      */
 /*!
-    Add a JSON item to a JSON array
+    Get the outcome of the last parse
 
-    The JSON_ArrayAdd function adds a JSON item to a JSON array
-    at the end of the array.
+    The JSON_GetParseError function gets the outcome of the last parse
+    run by the calling thread with one of the JSON_Process functions or
+    JSON_StreamArray.  When the parse failed it describes the error and
+    where it occurred.
+
+    @param[out]
+        pError
+            pointer to a location to store the parse outcome
+
+============================================================================*/
+void JSON_GetParseError( JParseError *pError )
+{
+    if( pError != NULL )
+    {
+        *pError = json_parseError;
+    }
+}
+
+/*==========================================================================*/
+/*  JSON_ProcessStream                                                      */
+/*!
+    Process a stream of newline delimited JSON records
+
+    The JSON_ProcessStream function parses a stream of newline delimited
+    JSON (NDJSON) records, one per line, and invokes the specified
+    function for each of them.  Blank lines are skipped.
+
+    Each line is scanned in place, so the scanner is not restarted
+    between records.  A malformed record is reported to the function,
+    with the offset in the stream and line at which it failed and the
+    reason, and parsing resumes with the next line.
 
     @param[in]
-        pArray
-            pointer to the JSON Array to add to
+        fp
+            the stream to read records from
 
     @param[in]
-        pObject
-            a JSON object to add
+        pLimits
+            pointer to limits to apply to each record, or NULL
 
-    @retval EOK the JSON item was added to the array
+    @param[in]
+        fn
+            the function to invoke for each record.  It is passed the
+            parsed record, which it owns, or NULL and a description of
+            the error if the record is malformed.  Processing stops
+            if it does not return EOK.
+
+    @param[in]
+        arg
+            the argument to pass to the function each time it is invoked
+
+    @param[out]
+        pStats
+            optional pointer to a location to store the record counts
+
+    @retval EOK the end of the stream was reached
     @retval EINVAL invalid arguments
-    @retval ENOTSUP the specified object is not an array
+    @retval ENOMEM memory allocation failure
+    @retval EIO error reading the stream
+    @retval other error as returned by the invoked function
 
 ============================================================================*/
-int JSON_ArrayAdd( JArray *pArray, JObject *pObject )
+int JSON_ProcessStream( FILE *fp,
+                        JParseLimits *pLimits,
+                        JSON_RecordFn fn,
+                        void *arg,
+                        JStreamStats *pStats )
 {
+    JStreamStats stats;
+    JParseContext context;
+    YY_BUFFER_STATE buffer;
+    JNode *pRecord;
+    char *line = NULL;
+    char *p;
+    size_t size = 0;
+    size_t len;
+    ssize_t n;
     int result = EINVAL;
+    int rc;
 
-    if( ( pArray != NULL ) &&
-        ( pObject != NULL ) )
+    memset( &stats, 0, sizeof( stats ) );
+
+    if( ( fp != NULL ) &&
+        ( fn != NULL ) )
     {
-        if( pArray->node.type == JSON_ARRAY )
+        result = EOK;
+
+        while( ( result == EOK ) &&
+               ( ( n = getline( &line, &size, fp ) ) > 0 ) )
         {
-            if( pArray->pFirst == NULL )
+            stats.lines++;
+
+            len = n;
+            if( line[len - 1] == '\n' )
             {
-                pArray->pFirst = (JNode *)pObject;
-                pArray->pLast = (JNode *)pObject;
-                pArray->n = 1;
-                result = EOK;
+                len--;
             }
-            else
+
+            /* the scanner requires the record to end with two NULs */
+            if( len + 2 > size )
             {
-                if( pArray->pLast != NULL )
+                p = realloc( line, len + 2 );
+                if( p != NULL )
                 {
-                    pArray->pLast->pNext = (JNode *)pObject;
-                    pArray->pLast = (JNode *)pObject;
-                    pArray->n++;
-                    result = EOK;
+                    line = p;
+                    size = len + 2;
+                }
+                else
+                {
+                    result = ENOMEM;
+                }
+            }
+
+            if( result == EOK )
+            {
+                line[len] = 0;
+                line[len + 1] = 0;
+            }
+
+            if( ( result == EOK ) &&
+                ( strspn( line, " \t\r" ) < len ) )
+            {
+                pthread_mutex_lock( &json_parseLock );
+
+                json_ParseStart( &context, NULL, pLimits );
+
+                root = NULL;
+                buffer = yy_scan_buffer( line, len + 2 );
+
+                rc = yyparse();
+
+                yy_delete_buffer( buffer );
+
+                rc = json_ParseEnd( &context, rc );
+
+                pRecord = ( rc == 0 ) ? root : NULL;
+
+                pthread_mutex_unlock( &json_parseLock );
+
+                /* the function is invoked without the parse lock held so
+                   that it may parse documents itself */
+                if( pRecord != NULL )
+                {
+                    stats.good++;
+                    result = fn( pRecord, NULL, arg );
+                }
+                else
+                {
+                    stats.bad++;
+                    context.status.offset += stats.bytes;
+                    context.status.line = stats.lines;
+                    result = fn( NULL, &context.status, arg );
                 }
             }
+
+            stats.bytes += n;
         }
-        else
+
+        if( ( result == EOK ) &&
+            ( ferror( fp ) != 0 ) )
         {
-            result = ENOTSUP;
+            result = EIO;
         }
+
+        /* release the scanner state left by the last record */
+        pthread_mutex_lock( &json_parseLock );
+        yylex_destroy();
+        pthread_mutex_unlock( &json_parseLock );
+
+        free( line );
+    }
+
+    if( pStats != NULL )
+    {
+        *pStats = stats;
     }
 
     return result;
 }
 
 /*==========================================================================*/
-/*  JSON_ObjectAdd                                                          */
+/*  JSON_StreamArray                                                        */
 /*!
-    Add a JSON item to a JSON object
+    Stream the elements of a JSON array from a file
 
-    The JSON_ObjectAdd function adds a JSON item to a JSON object.
+    The JSON_StreamArray function parses a file containing a top level
+    JSON array one element at a time.  Each element is built with the
+    usual node constructors, passed to the specified function, and
+    freed when the function returns, so the memory used is bounded by
+    the largest element rather than the whole file.  A function which
+    needs to keep an element may take a reference with JSON_Retain.
+    A gzip or zstd compressed file is decompressed as it is parsed.
+
+    The function is invoked while the parser is running, so it must not
+    parse other documents.  If it does not return EOK the parse is
+    stopped and its return value is returned.
 
     @param[in]
-        pObject
-            pointer to the JSON Object to add to
+        inputFile
+            name of the JSON input file
 
     @param[in]
-        pNode
-            a JSON item to add
+        fn
+            the function to invoke for each element of the array
 
-    @retval EOK the JSON item was added to the object
-    @retval EINVAL invalid arguments
-    @retval ENOTSUP the specified object is not a JSON object
+    @param[in]
+        arg
+            the argument to pass to the function each time it is invoked
+
+    @retval EOK every element of the array was processed
+    @retval EINVAL invalid arguments or invalid JSON.  The error is
+            available from JSON_GetParseError
+    @retval ENOTSUP the file does not contain a JSON array
+    @retval other error opening the file, or returned by the function
 
 ============================================================================*/
-int JSON_ObjectAdd( JObject *pObject, JNode *pNode )
+int JSON_StreamArray( char *inputFile, JSON_ElementFn fn, void *arg )
 {
     int result = EINVAL;
+    FILE *fp;
+    FILE *in;
 
-    if( ( pObject != NULL ) &&
-        ( pNode != NULL ) )
+    if( ( inputFile != NULL ) &&
+        ( fn != NULL ) )
     {
-        if( pObject->node.type == JSON_OBJECT )
+        fp = fopen( inputFile, "r" );
+        in = ( fp != NULL ) ? JSON_Decompress( fp ) : NULL;
+        if( in != NULL )
         {
-            if( pObject->pFirst == NULL )
-            {
-                pObject->pFirst = pNode;
-                pObject->pLast = pNode;
-                result = EOK;
-            }
-            else
-            {
-                if( pObject->pLast != NULL )
-                {
-                    pObject->pLast->pNext = pNode;
-                    pObject->pLast = pNode;
-                    result = EOK;
-                }
-            }
+            result = json_StreamFile( in, fn, arg );
+            fclose( in );
         }
         else
         {
-            result = ENOTSUP;
+            result = errno;
+            if( fp != NULL )
+            {
+                fclose( fp );
+            }
         }
     }
 
@@ -504,1089 +928,4426 @@ int JSON_ObjectAdd( JObject *pObject, JNode *pNode )
 }
 
 /*==========================================================================*/
-/*  JSON_Free                                                               */
+/*  JSON_StreamArrayFd                                                      */
 /*!
-    Free a JSON Node and all its children
+    Stream the elements of a JSON array from a file descriptor
 
-    The JSON_Free function frees the JSON object recursively
+    The JSON_StreamArrayFd function is the same as JSON_StreamArray, but
+    reads the array from an open file descriptor, such as a pipe or
+    socket.  The file descriptor is not closed.
 
     @param[in]
-        json
-            pointer to the JSON Object to free
+        fd
+            the file descriptor to read from
+
+    @param[in]
+        fn
+            the function to invoke for each element of the array
+
+    @param[in]
+        arg
+            the argument to pass to the function each time it is invoked
+
+    @retval EOK every element of the array was processed
+    @retval EINVAL invalid arguments or invalid JSON
+    @retval ENOTSUP the input is not a JSON array
+    @retval other error opening the stream, or returned by the function
 
 ============================================================================*/
-void JSON_Free( JNode *json )
+int JSON_StreamArrayFd( int fd, JSON_ElementFn fn, void *arg )
 {
-    JArray *pArray;
-    JVar *pVar;
-    JObject *pObject;
-    JNode *pNode;
-    JNode *pDelete;
+    int result = EINVAL;
+    FILE *fp = NULL;
+    int dupfd;
 
-    if ( json != NULL )
+    if( ( fd >= 0 ) &&
+        ( fn != NULL ) )
     {
-        if( json->name != NULL )
+        /* the stream is closed when done, so give it its own descriptor */
+        dupfd = dup( fd );
+        if( dupfd != -1 )
         {
-            free(json->name);
-            json->name = NULL;
+            fp = fdopen( dupfd, "r" );
+            if( fp == NULL )
+            {
+                close( dupfd );
+            }
         }
 
-        switch( json->type )
+        if( fp != NULL )
         {
-            case JSON_ARRAY:
-                pArray = (JArray *)json;
-                pNode = pArray->pFirst;
-                while( pNode != NULL )
-                {
-                    pDelete = pNode;
-                    pNode = pNode->pNext;
-                    JSON_Free( pDelete );
-                }
-                memset( pArray, 0, sizeof( JArray ) );
-                break;
-
-            case JSON_OBJECT:
-                pObject = (JObject *)json;
-                pNode = pObject->pFirst;
-                while( pNode != NULL )
-                {
-                    pDelete = pNode;
-                    pNode = pNode->pNext;
-                    JSON_Free( pDelete );
-                }
-                memset( pObject, 0, sizeof( JObject ) );
-                break;
-
-            case JSON_BOOL:
-            case JSON_VAR:
-                pVar = (JVar *)json;
-                if ( pVar->var.type == JVARTYPE_STR )
-                {
-                    if ( pVar->var.val.str != NULL )
-                    {
-                        free( pVar->var.val.str );
-                        pVar->var.val.str = NULL;
-                    }
-                }
-                memset( pVar, 0, sizeof( JVar ) );
-                break;
-
-            default:
-                break;
+            result = json_StreamFile( fp, fn, arg );
+            fclose( fp );
+        }
+        else
+        {
+            result = errno;
         }
-
-        free( json );
     }
+
+    return result;
 }
 
 /*==========================================================================*/
-/*  JSON_Print                                                              */
+/*  JSON_Parse                                                              */
 /*!
-    Output a JSON object to a file
+    Parse a JSON object from a file
 
-    The JSON_Print function outputs the JSON object recursively
-    to the specified output stream
+    The JSON_Parse function parses a JSON object from a file
+    and builds an in-memory JSON object.
 
     @param[in]
-        json
-            pointer to the JSON Object to output
+        inputFile
+            name of the JSON input file
 
     @param[in]
-        fp
-            pointer to the output stream
+        outputFile
+            name of the output file
 
     @param[in]
-        comma
-            true - output leading comma
-            false - no leading comma
+        debug
+            true - enable debugging
+            false - disabled debugging
+
+    @retval -1 parsing failed
+    @retval 0 parsing successful
 
 ============================================================================*/
-void JSON_Print( JNode *json, FILE *fp, bool comma )
+int JSON_Parse( char *inputFile,
+				char *outputFile,
+				bool debug )
 {
-    JArray *pArray;
-    JVar *pVar;
-    JObject *pObject;
-    JNode *pNode;
+    FILE *fp;
 
-    if( ( json != NULL ) &&
-        ( fp != NULL ) )
+	if( debug == true )
+	{
+		yydebug = 1;
+	}
+
+    if ( inputFile != (char *)NULL )
     {
-        if( comma == true )
+        /* input file was specified */
+        if ((yyin = fopen(inputFile, "r")) == (FILE *)NULL)
         {
-            fprintf(fp, "," );
-            comma = false;
+            fprintf(stderr, "file %s not found.\n", inputFile );
+            return -1;
         }
+    }
 
-        if( json->name != NULL )
+    if( outputFile != NULL )
+    {
+        fp = fopen( outputFile, "w" );
+        if( fp == (FILE *)NULL )
         {
-            fprintf(fp, "\"%s\" : ", json->name );
+            fprintf(stderr, "Unable to create file: %s\n", outputFile );
+            return -1;
         }
+    }
+    else
+    {
+        fp = stdout;
+    }
 
-        switch( json->type )
+	/* parse the input file */
+    pthread_mutex_lock( &json_parseLock );
+    yyparse();
+    yylex_destroy();
+
+	JSON_Print(root, stdout, false );
+	printf("\n");
+    pthread_mutex_unlock( &json_parseLock );
+	fclose( fp );
+
+    return 0;
+}
+
+/*==========================================================================*/
+/*  JSON_Iterate                                                            */
+/*!
+    Iterate through a JSON array applying a function to each array element
+
+    The JSON_Iterate function iterates through the specified JSON Array
+    invoking the specified function to every element in the array.
+    If any function invocation does not return EOK, the return value
+    will indicate the error of the last failed function, but the
+    iterator will continue to apply the function to all members
+    of the array.
+
+    @param[in]
+        pArray
+            pointer to the JSON Array to iterate over
+
+    @param[in]
+        fn
+            the function to apply to each JSON object in the array
+
+    @param[in]
+        arg
+            the argument to pass to the function each time it is invoked
+
+    @retval EOK processed all elements in the JSON array
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the JSON specified is not a JSON array
+    @retval other error as returned by the invoked function
+
+============================================================================*/
+int JSON_Iterate( JArray *pArray,
+                  int (*fn)(JNode *pNode, void *arg ),
+                  void *arg )
+{
+    int result = EINVAL;
+    int rc;
+    JNode *pNode;
+
+    if( ( pArray != NULL ) &&
+        ( fn != NULL ) )
+    {
+        if( pArray->node.type == JSON_ARRAY )
         {
-            case JSON_ARRAY:
-                pArray = (JArray *)json;
-                fprintf( fp, "[" );
-                pNode = pArray->pFirst;
-                while( pNode != NULL )
+            result = EOK;
+
+            pNode = pArray->pFirst;
+            while( pNode != NULL )
+            {
+                rc = fn( pNode, arg );
+                if( rc != EOK )
                 {
-                    JSON_Print( pNode, fp, comma );
-                    comma = true;
-                    pNode = pNode->pNext;
+                    result = rc;
                 }
-                fprintf( fp, "]" );
-                break;
+                pNode = pNode->pNext;
+            }
+        }
+        else
+        {
+            result = ENOTSUP;
+        }
+    }
 
-            case JSON_OBJECT:
-                pObject = (JObject *)json;
-                fprintf( fp, "{" );
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_Attribute                                                          */
+/*!
+    Get the value of the JSON attribute with the specified name
+
+    The JSON_Attribute function gets the value of the JSON attribute
+    with the specified name inside the specified JSON object.
+    Large objects are searched using their hash index, objects in a
+    sorted clone using their sorted key table, and small objects by
+    scanning their members.  Either way the first attribute with the
+    specified name is found.
+
+    @param[in]
+        pObject
+            pointer to the JSON Object to search
+
+    @param[in]
+        attribute
+            the name of the attribute in the JSON object
+
+    @retval pointer to the named attribute
+    @retval NULL if the named attribute cannot be found
+
+============================================================================*/
+JNode *JSON_Attribute( JObject *pObject, char *attribute )
+{
+    JNode *pNode = NULL;
+    JObject *pOwner;
+
+    if( ( pObject != NULL ) &&
+        ( attribute != NULL ) )
+    {
+        if( pObject->node.type == JSON_OBJECT )
+        {
+            /* a persistent version uses the index of the object which
+               owns its members */
+            pOwner = ( pObject->pShared != NULL )
+                     ? (JObject *)pObject->pShared
+                     : pObject;
+
+            if( pOwner->pKeys != NULL )
+            {
+                pNode = json_KeysFind( pOwner->pKeys, attribute );
+            }
+            else if( pOwner->pIndex != NULL )
+            {
+                pNode = json_IndexFind( pOwner->pIndex, attribute );
+            }
+            else
+            {
                 pNode = pObject->pFirst;
                 while( pNode != NULL )
                 {
-                    JSON_Print( pNode, fp, comma );
-                    comma = true;
+                    if( pNode->name != NULL )
+                    {
+                        if( strcmp( pNode->name, attribute ) == 0 )
+                        {
+                            break;
+                        }
+                    }
+
                     pNode = pNode->pNext;
                 }
-                fprintf( fp, "}" );
-                break;
+            }
+        }
+    }
+
+    return pNode;
+}
+
+/*==========================================================================*/
+/*  JSON_Index                                                              */
+/*!
+    Get the value of the JSON array element at the specified index
+
+    The JSON_Index function gets the value of the JSON array
+    element at the specified index
+
+    @param[in]
+        pArray
+            pointer to the JSON Array to index
+
+    @param[in]
+        idx
+            the index of the JSON array to retrieve
+
+    @retval pointer to the JSON element at the specified index
+    @retval NULL if the named attribute cannot be found
+
+============================================================================*/
+JNode *JSON_Index( JArray *pArray, size_t idx )
+{
+    JNode *result = NULL;
+
+    if( pArray != NULL )
+    {
+        if( ( pArray->node.type == JSON_ARRAY ) &&
+            ( idx < pArray->n ) )
+        {
+            result = json_Nth( (JObject *)pArray, idx );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_ArrayAdd                                                           */
+/*!
+    Add a JSON item to a JSON array
+
+    The JSON_ArrayAdd function adds a JSON item to a JSON array
+    at the end of the array.
+
+    @param[in]
+        pArray
+            pointer to the JSON Array to add to
+
+    @param[in]
+        pObject
+            a JSON object to add
+
+    @retval EOK the JSON item was added to the array
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the specified object is not an array
+    @retval EPERM the array is a persistent version sharing its members,
+            has members shared by one, or is part of a clone
+
+============================================================================*/
+int JSON_ArrayAdd( JArray *pArray, JObject *pObject )
+{
+    int result = EINVAL;
+
+    if( ( pArray != NULL ) &&
+        ( pObject != NULL ) )
+    {
+        if( ( pArray->node.type == JSON_ARRAY ) &&
+            ( ( pArray->pShared != NULL ) ||
+              ( ( pArray->node.flags & JSON_NODE_SHARED ) != 0 ) ||
+              ( ( ( pArray->node.flags & JSON_NODE_ARENA ) != 0 ) &&
+                ( json_ParseArena() == NULL ) ) ) )
+        {
+            result = EPERM;
+        }
+        else if( pArray->node.type == JSON_ARRAY )
+        {
+            json_HashModified( (JObject *)pArray );
+
+            if( pArray->pFirst == NULL )
+            {
+                pObject->node.pPrev = NULL;
+                pArray->pFirst = (JNode *)pObject;
+                pArray->pLast = (JNode *)pObject;
+                pArray->n = 1;
+                result = EOK;
+            }
+            else
+            {
+                if( pArray->pLast != NULL )
+                {
+                    pObject->node.pPrev = pArray->pLast;
+                    pArray->pLast->pNext = (JNode *)pObject;
+                    pArray->pLast = (JNode *)pObject;
+                    pArray->n++;
+                    result = EOK;
+                }
+            }
+        }
+        else
+        {
+            result = ENOTSUP;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_ObjectAdd                                                          */
+/*!
+    Add a JSON item to a JSON object
+
+    The JSON_ObjectAdd function adds a JSON item to a JSON object.
+
+    @param[in]
+        pObject
+            pointer to the JSON Object to add to
+
+    @param[in]
+        pNode
+            a JSON item to add
+
+    @retval EOK the JSON item was added to the object
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the specified object is not a JSON object
+    @retval EPERM the object is a persistent version sharing its members,
+            has members shared by one, or is part of a clone
+
+============================================================================*/
+int JSON_ObjectAdd( JObject *pObject, JNode *pNode )
+{
+    int result = EINVAL;
+
+    if( ( pObject != NULL ) &&
+        ( pNode != NULL ) )
+    {
+        if( ( pObject->node.type == JSON_OBJECT ) &&
+            ( ( pObject->pShared != NULL ) ||
+              ( ( pObject->node.flags & JSON_NODE_SHARED ) != 0 ) ||
+              ( ( ( pObject->node.flags & JSON_NODE_ARENA ) != 0 ) &&
+                ( json_ParseArena() == NULL ) ) ) )
+        {
+            result = EPERM;
+        }
+        else if( pObject->node.type == JSON_OBJECT )
+        {
+            json_HashModified( pObject );
+
+            if( pObject->pFirst == NULL )
+            {
+                pNode->pPrev = NULL;
+                pObject->pFirst = pNode;
+                pObject->pLast = pNode;
+                pObject->n = 1;
+                result = EOK;
+            }
+            else
+            {
+                if( pObject->pLast != NULL )
+                {
+                    pNode->pPrev = pObject->pLast;
+                    pObject->pLast->pNext = pNode;
+                    pObject->pLast = pNode;
+                    pObject->n++;
+                    result = EOK;
+                }
+            }
+
+            if( ( result == EOK ) &&
+                ( ( pObject->node.flags & JSON_NODE_ARENA ) == 0 ) )
+            {
+                json_IndexAdd( pObject, pNode );
+            }
+        }
+        else
+        {
+            result = ENOTSUP;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_Remove                                                             */
+/*!
+    Remove a member from a JSON array or object
+
+    The JSON_Remove function unlinks a member from the JSON array or
+    object which contains it in constant time, since members are doubly
+    linked.  The caller must pass a member of pContainer: membership
+    is checked only where that takes constant time (see json_Contains),
+    so removing a member of another container is detected if it is
+    the first or last member there, or if pContainer is an indexed
+    object, and is otherwise undefined.  The removed member is not
+    freed: it belongs to the caller, who may free it with JSON_Free or
+    add it to another container.
+
+    @param[in]
+        pContainer
+            pointer to the JSON array or object containing the member
+
+    @param[in]
+        pNode
+            pointer to the member to remove
+
+    @retval EOK the member was removed
+    @retval EINVAL invalid arguments, or pNode was found not to be a
+            member of pContainer
+    @retval EPERM the container is a persistent version sharing its
+            members, has members shared by one, or is part of a clone
+
+============================================================================*/
+int JSON_Remove( JNode *pContainer, JNode *pNode )
+{
+    int result = EINVAL;
+    JObject *pObject = (JObject *)pContainer;
+
+    if( ( pContainer != NULL ) &&
+        ( pNode != NULL ) &&
+        ( ( pContainer->type == JSON_ARRAY ) ||
+          ( pContainer->type == JSON_OBJECT ) ) )
+    {
+        if( ( pObject->pShared != NULL ) ||
+            ( ( pContainer->flags &
+                ( JSON_NODE_ARENA | JSON_NODE_SHARED ) ) != 0 ) )
+        {
+            result = EPERM;
+        }
+        else if( json_Contains( pObject, pNode ) == true )
+        {
+            json_HashModified( pObject );
+
+            if( pNode->pPrev == NULL )
+            {
+                pObject->pFirst = pNode->pNext;
+            }
+            else
+            {
+                pNode->pPrev->pNext = pNode->pNext;
+            }
+
+            if( pNode->pNext == NULL )
+            {
+                pObject->pLast = pNode->pPrev;
+            }
+            else
+            {
+                pNode->pNext->pPrev = pNode->pPrev;
+            }
+
+            pObject->n--;
+            pNode->pNext = NULL;
+            pNode->pPrev = NULL;
+
+            if( pContainer->type == JSON_OBJECT )
+            {
+                json_IndexRemove( pObject, pNode );
+            }
+
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_ArrayInsertAt                                                      */
+/*!
+    Insert an element into a JSON array
+
+    The JSON_ArrayInsertAt function inserts an element into a JSON array
+    in front of the element at the specified index, or at the end of
+    the array if the index is equal to the array size.  The insertion
+    point is found by walking from whichever end of the array is nearer.
+
+    @param[in]
+        pArray
+            pointer to the JSON array
+
+    @param[in]
+        idx
+            index the new element will have
+
+    @param[in]
+        pNode
+            pointer to the element to insert
+
+    @retval EOK the element was inserted
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the specified object is not an array
+    @retval ERANGE the index is larger than the array size
+    @retval EPERM the array is a persistent version sharing its members,
+            has members shared by one, or is part of a clone
+
+============================================================================*/
+int JSON_ArrayInsertAt( JArray *pArray, size_t idx, JNode *pNode )
+{
+    int result = EINVAL;
+    JNode *pNext;
+
+    if( ( pArray != NULL ) &&
+        ( pNode != NULL ) )
+    {
+        if( pArray->node.type != JSON_ARRAY )
+        {
+            result = ENOTSUP;
+        }
+        else if( idx > pArray->n )
+        {
+            result = ERANGE;
+        }
+        else if( idx == pArray->n )
+        {
+            result = JSON_ArrayAdd( pArray, (JObject *)pNode );
+        }
+        else if( ( pArray->pShared != NULL ) ||
+                 ( ( pArray->node.flags &
+                     ( JSON_NODE_ARENA | JSON_NODE_SHARED ) ) != 0 ) )
+        {
+            result = EPERM;
+        }
+        else
+        {
+            json_HashModified( (JObject *)pArray );
+
+            /* link in front of the element at the insertion index */
+            pNext = json_Nth( (JObject *)pArray, idx );
+            pNode->pPrev = pNext->pPrev;
+            pNode->pNext = pNext;
+            if( pNext->pPrev == NULL )
+            {
+                pArray->pFirst = pNode;
+            }
+            else
+            {
+                pNext->pPrev->pNext = pNode;
+            }
+
+            pNext->pPrev = pNode;
+            pArray->n++;
+
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_ObjectReplace                                                      */
+/*!
+    Replace an attribute of a JSON object
+
+    The JSON_ObjectReplace function replaces the attribute of a JSON
+    object which has the same name as the specified node, keeping its
+    position in the object, and frees the attribute it replaces.  If
+    there is no such attribute, the node is added to the object.
+
+    @param[in]
+        pObject
+            pointer to the JSON object
+
+    @param[in]
+        pNode
+            pointer to the named attribute to store in the object
+
+    @retval EOK the attribute was replaced or added
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the specified object is not a JSON object
+    @retval EPERM the object is a persistent version sharing its members,
+            has members shared by one, or is part of a clone
+
+============================================================================*/
+int JSON_ObjectReplace( JObject *pObject, JNode *pNode )
+{
+    int result = EINVAL;
+    JNode *pOld;
+
+    if( ( pObject != NULL ) &&
+        ( pNode != NULL ) &&
+        ( pNode->name != NULL ) )
+    {
+        if( pObject->node.type != JSON_OBJECT )
+        {
+            result = ENOTSUP;
+        }
+        else if( ( pObject->pShared != NULL ) ||
+                 ( ( pObject->node.flags &
+                     ( JSON_NODE_ARENA | JSON_NODE_SHARED ) ) != 0 ) )
+        {
+            result = EPERM;
+        }
+        else
+        {
+            pOld = JSON_Attribute( pObject, pNode->name );
+            if( pOld == NULL )
+            {
+                result = JSON_ObjectAdd( pObject, pNode );
+            }
+            else
+            {
+                json_HashModified( pObject );
+
+                pNode->pPrev = pOld->pPrev;
+                pNode->pNext = pOld->pNext;
+                if( pOld->pPrev == NULL )
+                {
+                    pObject->pFirst = pNode;
+                }
+                else
+                {
+                    pOld->pPrev->pNext = pNode;
+                }
+
+                if( pOld->pNext == NULL )
+                {
+                    pObject->pLast = pNode;
+                }
+                else
+                {
+                    pOld->pNext->pPrev = pNode;
+                }
+
+                json_IndexReplace( pObject, pOld, pNode );
+
+                pOld->pNext = NULL;
+                pOld->pPrev = NULL;
+                JSON_Free( pOld );
+
+                result = EOK;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_Free                                                               */
+/*!
+    Free a JSON Node and all its children
+
+    The JSON_Free function frees the JSON object recursively.
+
+    If references to the JSON object have been taken with JSON_Retain,
+    JSON_Free releases the caller's reference and the object is only
+    freed when the last reference is released.  A retained child outlives
+    its parent: it is detached from its siblings when the parent is
+    freed.
+
+    A copy made by JSON_Clone is freed with a single call, or not at all
+    if it was allocated from an arena, which frees it when the arena is
+    destroyed.
+
+    @param[in]
+        json
+            pointer to the JSON Object to free
+
+============================================================================*/
+void JSON_Free( JNode *json )
+{
+    if( ( json != NULL ) &&
+        ( ( __atomic_load_n( &json->refcount, __ATOMIC_ACQUIRE ) == 0 ) ||
+          ( __atomic_fetch_sub( &json->refcount,
+                                1,
+                                __ATOMIC_ACQ_REL ) == 0 ) ) )
+    {
+        if( ( json->flags & JSON_NODE_BLOCK ) != 0 )
+        {
+            /* a clone is freed with a single call */
+            free( json );
+        }
+        else if( ( json->flags & JSON_NODE_DOCUMENT ) != 0 )
+        {
+            /* so is a document parsed into its own arena */
+            json_ArenaDocumentFree( json );
+        }
+        else if( ( json->flags & JSON_NODE_ARENA ) == 0 )
+        {
+            json_FreeNode( json );
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  JSON_Retain                                                             */
+/*!
+    Take a reference to a JSON object
+
+    The JSON_Retain function atomically takes an additional reference to
+    a JSON object so that it can be shared between threads or held
+    beyond the lifetime of its parent document without copying it.
+    Each reference must be released with JSON_Release (or JSON_Free).
+
+    A JSON object which has been shared with JSON_Retain is immutable:
+    none of the holders of a reference may modify it or any of its
+    children.
+
+    @param[in]
+        json
+            pointer to the JSON object to retain
+
+    @retval pointer to the retained JSON object
+
+============================================================================*/
+JNode *JSON_Retain( JNode *json )
+{
+    if( json != NULL )
+    {
+        __atomic_add_fetch( &json->refcount, 1, __ATOMIC_RELAXED );
+    }
+
+    return json;
+}
+
+/*==========================================================================*/
+/*  JSON_Release                                                            */
+/*!
+    Release a reference to a JSON object
+
+    The JSON_Release function atomically releases a reference to a JSON
+    object.  The last release frees the JSON object and all of its
+    children.
+
+    @param[in]
+        json
+            pointer to the JSON object to release
+
+============================================================================*/
+void JSON_Release( JNode *json )
+{
+    JSON_Free( json );
+}
+
+/*==========================================================================*/
+/*  json_NodeAlloc                                                          */
+/*!
+    Allocate a JSON node
+
+    The json_NodeAlloc function allocates zeroed storage for a JSON
+    node.  While the calling thread is parsing a document into an arena
+    the node is allocated from the arena and marked JSON_NODE_ARENA,
+    otherwise it is allocated from the heap.  The node is charged
+    against the limits of the parse, if any.
+
+    @param[in]
+        size
+            size of the node structure
+
+    @retval pointer to the node storage
+    @retval NULL memory allocation failure or a parse limit was exceeded
+
+============================================================================*/
+static void *json_NodeAlloc( size_t size )
+{
+    JParseContext *pContext = json_parseContext;
+    JNode *pNode = NULL;
+
+    if( pContext == NULL )
+    {
+        pNode = calloc( 1, size );
+    }
+    else if( json_ParseCharge( pContext, size, 1 ) == EOK )
+    {
+        if( pContext->pArena == NULL )
+        {
+            pNode = calloc( 1, size );
+        }
+        else
+        {
+            pNode = json_ArenaAlloc( pContext->pArena, size );
+            if( pNode != NULL )
+            {
+                memset( pNode, 0, size );
+                pNode->flags = JSON_NODE_ARENA;
+            }
+        }
+
+        if( pNode == NULL )
+        {
+            json_ParseFail( pContext, ENOMEM, JSON_LIMIT_NONE );
+        }
+    }
+
+    return pNode;
+}
+
+/*==========================================================================*/
+/*  json_StrDup                                                             */
+/*!
+    Duplicate a string for a JSON node
+
+    The json_StrDup function is used by the parser to store names and
+    string values.  The copy is allocated from the arena the calling
+    thread is parsing into, if any, and from the heap otherwise, and is
+    charged against the limits of the parse.
+
+    @param[in]
+        str
+            pointer to the characters to copy
+
+    @param[in]
+        len
+            number of characters to copy
+
+    @retval pointer to the NUL terminated copy
+    @retval NULL memory allocation failure or a parse limit was exceeded
+
+============================================================================*/
+char *json_StrDup( char *str, size_t len )
+{
+    JParseContext *pContext = json_parseContext;
+    char *copy = NULL;
+    int rc = EOK;
+
+    if( pContext != NULL )
+    {
+        if( ( pContext->pLimits != NULL ) &&
+            ( pContext->pLimits->maxString != 0 ) &&
+            ( len > pContext->pLimits->maxString ) )
+        {
+            rc = json_ParseFail( pContext, E2BIG, JSON_LIMIT_STRING );
+        }
+        else
+        {
+            rc = json_ParseCharge( pContext, len + 1, 0 );
+        }
+    }
+
+    if( rc == EOK )
+    {
+        if( ( pContext == NULL ) || ( pContext->pArena == NULL ) )
+        {
+            copy = malloc( len + 1 );
+        }
+        else
+        {
+            copy = json_ArenaAlloc( pContext->pArena, len + 1 );
+        }
+
+        if( copy != NULL )
+        {
+            memcpy( copy, str, len );
+            copy[len] = 0;
+        }
+        else if( pContext != NULL )
+        {
+            json_ParseFail( pContext, ENOMEM, JSON_LIMIT_NONE );
+        }
+    }
+
+    return copy;
+}
+
+/*==========================================================================*/
+/*  json_StrFree                                                            */
+/*!
+    Free a string duplicated by json_StrDup
+
+    The json_StrFree function is used by the parser to discard a name
+    which was not attached to a node.  A string allocated from the arena
+    of the document being parsed is released with the arena.
+
+    @param[in]
+        str
+            pointer to the string to free
+
+============================================================================*/
+void json_StrFree( char *str )
+{
+    if( json_ParseArena() == NULL )
+    {
+        free( str );
+    }
+}
+
+/*==========================================================================*/
+/*  json_ParseArena                                                         */
+/*!
+    Get the arena the calling thread is parsing into
+
+    @retval pointer to the arena of the document being parsed
+    @retval NULL the calling thread is not parsing into an arena
+
+============================================================================*/
+static JArena *json_ParseArena( void )
+{
+    return ( json_parseContext != NULL ) ? json_parseContext->pArena : NULL;
+}
+
+/*==========================================================================*/
+/*  json_ParseCharge                                                        */
+/*!
+    Charge an allocation against the limits of a parse
+
+    The json_ParseCharge function accounts for memory about to be
+    allocated by a parse, and fails once the parse has allocated more
+    bytes or nodes than its limits allow.
+
+    @param[in]
+        pContext
+            pointer to the parse context
+
+    @param[in]
+        bytes
+            number of bytes to be allocated
+
+    @param[in]
+        nodes
+            number of nodes to be allocated
+
+    @retval EOK the allocation may proceed
+    @retval E2BIG a parse limit was exceeded
+
+============================================================================*/
+static int json_ParseCharge( JParseContext *pContext,
+                             size_t bytes,
+                             size_t nodes )
+{
+    JParseLimits *pLimits = pContext->pLimits;
+    int result = EOK;
+
+    pContext->bytes += bytes;
+    pContext->nodes += nodes;
+
+    if( pLimits != NULL )
+    {
+        if( ( pLimits->maxBytes != 0 ) &&
+            ( pContext->bytes > pLimits->maxBytes ) )
+        {
+            result = json_ParseFail( pContext, E2BIG, JSON_LIMIT_BYTES );
+        }
+        else if( ( pLimits->maxNodes != 0 ) &&
+                 ( pContext->nodes > pLimits->maxNodes ) )
+        {
+            result = json_ParseFail( pContext, E2BIG, JSON_LIMIT_NODES );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_ParseFail                                                          */
+/*!
+    Record the reason a parse is being aborted
+
+    The json_ParseFail function records the first error which aborts a
+    parse, and the position of the scanner when it occurred, so that
+    they can be reported to the caller.
+
+    @param[in]
+        pContext
+            pointer to the parse context
+
+    @param[in]
+        error
+            the error which aborts the parse
+
+    @param[in]
+        limit
+            the limit which was exceeded, if error is E2BIG
+
+    @retval the error
+
+============================================================================*/
+static int json_ParseFail( JParseContext *pContext,
+                           int error,
+                           JParseLimit limit )
+{
+    JParseError *pStatus = &pContext->status;
+
+    if( pStatus->error == EOK )
+    {
+        pStatus->error = error;
+        pStatus->limit = limit;
+        pStatus->offset = json_lexOffset;
+        pStatus->line = yylineno;
+        strcpy( pStatus->message,
+                ( ( error == E2BIG ) || ( error == ENOMEM ) )
+                    ? json_limitMessages[limit]
+                    : "parse aborted" );
+    }
+
+    return error;
+}
+
+/*==========================================================================*/
+/*  json_ParseInput                                                         */
+/*!
+    Record an input error
+
+    The json_ParseInput function is called by the scanner when its input
+    cannot be read, for example when compressed input is corrupt or
+    truncated.  The scanner treats the error as the end of the input,
+    and the error is reported instead of the resulting syntax error.
+
+    @param[in]
+        error
+            the error returned by the read
+
+============================================================================*/
+void json_ParseInput( int error )
+{
+    JParseContext *pContext = json_parseContext;
+
+    if( ( pContext != NULL ) &&
+        ( pContext->status.error == EOK ) )
+    {
+        json_ParseFail( pContext,
+                        ( error != EOK ) ? error : EIO,
+                        JSON_LIMIT_NONE );
+        snprintf( pContext->status.message,
+                  sizeof( pContext->status.message ),
+                  "%s",
+                  strerror( pContext->status.error ) );
+    }
+}
+
+/*==========================================================================*/
+/*  json_ParseSyntax                                                        */
+/*!
+    Record a syntax error
+
+    The json_ParseSyntax function is called by the parser when the input
+    does not match the JSON grammar.  It records the error description,
+    which names the unexpected and expected tokens, and the position of
+    the offending token.  Nothing is output.
+
+    @param[in]
+        msg
+            description of the syntax error
+
+    @param[in]
+        offset
+            offset of the offending token in the input
+
+    @param[in]
+        line
+            line number of the offending token
+
+============================================================================*/
+void json_ParseSyntax( const char *msg, size_t offset, size_t line )
+{
+    JParseContext *pContext = json_parseContext;
+    JParseError *pStatus;
+
+    if( pContext != NULL )
+    {
+        pStatus = &pContext->status;
+        if( pStatus->error == EOK )
+        {
+            pStatus->error = EINVAL;
+            pStatus->limit = JSON_LIMIT_NONE;
+            pStatus->offset = offset;
+            pStatus->line = line;
+            snprintf( pStatus->message, sizeof( pStatus->message ), "%s", msg );
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  json_ParseStart                                                         */
+/*!
+    Start a parse on the calling thread
+
+    The json_ParseStart function is called with json_parseLock held to
+    initialize the context of a parse and make it the calling thread's
+    current parse.
+
+    @param[in]
+        pContext
+            pointer to the parse context to initialize
+
+    @param[in]
+        pArena
+            arena to parse the document into, or NULL to use the heap
+
+    @param[in]
+        pLimits
+            limits to apply to the parse, or NULL for no limits
+
+============================================================================*/
+static void json_ParseStart( JParseContext *pContext,
+                             JArena *pArena,
+                             JParseLimits *pLimits )
+{
+    memset( pContext, 0, sizeof( JParseContext ) );
+    pContext->pArena = pArena;
+    pContext->pLimits = pLimits;
+
+    json_parseContext = pContext;
+}
+
+/*==========================================================================*/
+/*  json_ParseEnd                                                           */
+/*!
+    End a parse on the calling thread
+
+    The json_ParseEnd function is called when yyparse returns.  It
+    releases the document of a failed parse, and records the outcome of
+    the parse as the calling thread's last parse error, for
+    JSON_GetParseError.  A parse which built a complete document is
+    still failed if an error was recorded, such as corrupt compressed
+    input which the scanner treated as the end of the input.
+
+    @param[in]
+        pContext
+            pointer to the parse context
+
+    @param[in]
+        rc
+            return code of yyparse
+
+    @retval 0 the parse succeeded and root is the document
+    @retval other the parse failed and root has been released
+
+============================================================================*/
+static int json_ParseEnd( JParseContext *pContext, int rc )
+{
+    json_parseContext = NULL;
+
+    if( ( rc == 0 ) && ( pContext->status.error != EOK ) )
+    {
+        rc = 1;
+    }
+
+    if( rc == 2 )
+    {
+        /* the nesting outgrew the parser stack, which bison reports
+           as a syntax error */
+        pContext->status.error = EOK;
+        json_ParseFail( pContext, E2BIG, JSON_LIMIT_DEPTH );
+    }
+    else if( ( rc != 0 ) && ( pContext->status.error == EOK ) )
+    {
+        json_ParseSyntax( "syntax error", json_lexOffset, yylineno );
+    }
+
+    if( ( rc != 0 ) && ( root != NULL ) )
+    {
+        /* input which continues after a complete document is rejected
+           after the document has been built, so it is released here */
+        JSON_Free( root );
+        root = NULL;
+    }
+
+    json_parseError = pContext->status;
+
+    return rc;
+}
+
+/*==========================================================================*/
+/*  json_ParseEnter                                                         */
+/*!
+    Enter a nested object or array
+
+    The json_ParseEnter function is called by the parser at the start
+    of each object or array, and fails if the maximum nesting depth of
+    the parse is exceeded, or if a document being streamed is not an
+    array.
+
+    @param[in]
+        type
+            JSON_OBJECT or JSON_ARRAY
+
+    @retval EOK the object or array may be parsed
+    @retval E2BIG the maximum nesting depth was exceeded
+    @retval ENOTSUP the document being streamed is not an array
+
+============================================================================*/
+int json_ParseEnter( JType type )
+{
+    JParseContext *pContext = json_parseContext;
+    int result = EOK;
+
+    if( pContext != NULL )
+    {
+        pContext->depth++;
+
+        if( ( pContext->fn != NULL ) &&
+            ( pContext->depth == 1 ) &&
+            ( type != JSON_ARRAY ) )
+        {
+            result = json_ParseFail( pContext, ENOTSUP, JSON_LIMIT_NONE );
+            strcpy( pContext->status.message, "document is not an array" );
+        }
+        else if( ( pContext->pLimits != NULL ) &&
+            ( pContext->pLimits->maxDepth != 0 ) &&
+            ( pContext->depth > pContext->pLimits->maxDepth ) )
+        {
+            result = json_ParseFail( pContext, E2BIG, JSON_LIMIT_DEPTH );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_ParseLeave                                                         */
+/*!
+    Leave a nested object or array
+
+    The json_ParseLeave function is called by the parser at the end of
+    each object or array.
+
+============================================================================*/
+void json_ParseLeave( void )
+{
+    if( json_parseContext != NULL )
+    {
+        json_parseContext->depth--;
+    }
+}
+
+/*==========================================================================*/
+/*  json_ParseMember                                                        */
+/*!
+    Check that a member may be added to a container
+
+    The json_ParseMember function is called by the parser before it
+    adds a member to an object or array, and fails if the container
+    already holds the maximum number of members allowed by the parse.
+
+    @param[in]
+        pContainer
+            pointer to the object or array being parsed
+
+    @retval EOK the member may be added
+    @retval E2BIG the container is full
+
+============================================================================*/
+int json_ParseMember( JNode *pContainer )
+{
+    JParseContext *pContext = json_parseContext;
+    int result = EOK;
+
+    if( ( pContext != NULL ) &&
+        ( pContext->pLimits != NULL ) &&
+        ( pContext->pLimits->maxMembers != 0 ) &&
+        ( ((JObject *)pContainer)->n >= pContext->pLimits->maxMembers ) )
+    {
+        result = json_ParseFail( pContext, E2BIG, JSON_LIMIT_MEMBERS );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_ParseAppend                                                        */
+/*!
+    Append a parsed element to an array
+
+    The json_ParseAppend function is called by the parser for each
+    element of an array.  Elements of the top level array of a document
+    being streamed are passed to the stream's element function and
+    freed, otherwise the element is added to the array.  The element is
+    freed if it cannot be added.
+
+    @param[in]
+        pArray
+            pointer to the array being parsed
+
+    @param[in]
+        pElement
+            pointer to the parsed element
+
+    @retval EOK the element was consumed
+    @retval E2BIG the array is full
+    @retval other error returned by the element function
+
+============================================================================*/
+int json_ParseAppend( JNode *pArray, JNode *pElement )
+{
+    JParseContext *pContext = json_parseContext;
+    int result;
+
+    result = json_ParseMember( pArray );
+    if( result != EOK )
+    {
+        JSON_Free( pElement );
+    }
+    else if( ( pContext != NULL ) &&
+             ( pContext->fn != NULL ) &&
+             ( pContext->depth == 1 ) )
+    {
+        result = pContext->fn( pElement, pContext->index++, pContext->arg );
+        JSON_Free( pElement );
+
+        if( result != EOK )
+        {
+            json_ParseFail( pContext, result, JSON_LIMIT_NONE );
+        }
+    }
+    else
+    {
+        JSON_ArrayAdd( (JArray *)pArray, (JObject *)pElement );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_StreamFile                                                         */
+/*!
+    Stream the elements of a JSON array from an open file
+
+    The json_StreamFile function parses the top level array read from
+    the specified file, passing each of its elements to the specified
+    function as it is parsed.
+
+    @param[in]
+        fp
+            the file to read from
+
+    @param[in]
+        fn
+            the function to invoke for each element of the array
+
+    @param[in]
+        arg
+            the argument to pass to the function each time it is invoked
+
+    @retval EOK every element of the array was processed
+    @retval other the error which stopped the parse
+
+============================================================================*/
+static int json_StreamFile( FILE *fp, JSON_ElementFn fn, void *arg )
+{
+    JParseContext context;
+    int rc;
+
+    pthread_mutex_lock( &json_parseLock );
+
+    json_ParseStart( &context, NULL, NULL );
+    context.fn = fn;
+    context.arg = arg;
+
+    yyin = fp;
+    root = NULL;
+
+    rc = yyparse();
+
+    /* reset the scanner so the next parse starts from a clean state */
+    yylex_destroy();
+
+    rc = json_ParseEnd( &context, rc );
+
+    if( rc == 0 )
+    {
+        /* the elements have been consumed, leaving an empty array */
+        JSON_Free( root );
+        root = NULL;
+    }
+
+    pthread_mutex_unlock( &json_parseLock );
+
+    return context.status.error;
+}
+
+/*==========================================================================*/
+/*  json_ProcessInPlace                                                     */
+/*!
+    Process a JSON object from a buffer without copying it
+
+    The json_ProcessInPlace function parses a JSON object from a buffer
+    which the scanner reads in place, rather than from a copy as
+    JSON_ProcessBuffer does.  The buffer must be followed by two NUL
+    characters, and may be modified by the scanner.
+
+    @param[in]
+        buf
+            pointer to the input buffer
+
+    @param[in]
+        len
+            length of the input, not including the two NULs
+
+    @param[out]
+        pUsec
+            optional location to store the parse time in microseconds,
+            measured while the parser is held so that it does not
+            include waiting for other threads
+
+    @retval pointer to the parsed JSON object
+    @retval NULL if the JSON object is invalid.  The reason is available
+            from JSON_GetParseError
+
+============================================================================*/
+JNode *json_ProcessInPlace( char *buf, size_t len, uint64_t *pUsec )
+{
+    JNode *node = NULL;
+    JParseContext context;
+    YY_BUFFER_STATE buffer;
+    int rc;
+    struct timespec start;
+    struct timespec end;
+
+    pthread_mutex_lock( &json_parseLock );
+
+    if( pUsec != NULL )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &start );
+    }
+
+    json_ParseStart( &context, NULL, NULL );
+
+    root = NULL;
+    buffer = yy_scan_buffer( buf, len + 2 );
+
+    rc = yyparse();
+
+    yy_delete_buffer( buffer );
+
+    yylex_destroy();
+
+    rc = json_ParseEnd( &context, rc );
+
+    if ( rc == 0 )
+    {
+        node = root;
+    }
+
+    if( pUsec != NULL )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &end );
+        *pUsec = ( end.tv_sec - start.tv_sec ) * 1000000 +
+                 ( end.tv_nsec - start.tv_nsec ) / 1000;
+    }
+
+    pthread_mutex_unlock( &json_parseLock );
+
+    return node;
+}
+
+/*==========================================================================*/
+/*  json_ParseSized                                                         */
+/*!
+    Update the document arena size estimate
+
+    The json_ParseSized function is called with json_parseLock held
+    after a document has been parsed into an arena.  It folds the
+    number of bytes the document used into an exponentially weighted
+    moving average, which sizes the first block of the next document's
+    arena, and records how the document fitted in its arena.
+
+    @param[in]
+        pArena
+            pointer to the document arena
+
+    @param[in]
+        reserved
+            size of the arena's first block
+
+============================================================================*/
+static void json_ParseSized( JArena *pArena, size_t reserved )
+{
+    JParseStats *pStats = &json_parseStats;
+    size_t used;
+    size_t blocks;
+
+    used = json_ArenaUsed( pArena, &blocks );
+
+    if( pStats->documents == 0 )
+    {
+        pStats->estimate = used;
+    }
+    else if( used > pStats->estimate )
+    {
+        pStats->estimate += ( used - pStats->estimate ) >>
+                            JSON_PARSE_EWMA_SHIFT;
+    }
+    else
+    {
+        pStats->estimate -= ( pStats->estimate - used ) >>
+                            JSON_PARSE_EWMA_SHIFT;
+    }
+
+    pStats->documents++;
+    if( blocks > 1 )
+    {
+        pStats->overflows++;
+    }
+
+    pStats->reserved = reserved;
+    pStats->used = used;
+    pStats->blocks = blocks;
+}
+
+/*==========================================================================*/
+/*  json_FreeNode                                                           */
+/*!
+    Free a heap allocated JSON Node and all its children
+
+    The json_FreeNode function frees a JSON node which was allocated
+    by one of the JSON node constructors, along with its name, its
+    string value, and (via JSON_Free) its children.
+
+    @param[in]
+        json
+            pointer to the JSON node to free
+
+============================================================================*/
+static void json_FreeNode( JNode *json )
+{
+    JArray *pArray;
+    JVar *pVar;
+    JObject *pObject;
+    JNode *pNode;
+    JNode *pDelete;
+    JNode *pShared = NULL;
+    uint32_t flags = json->flags;
+
+    if( ( json->type == JSON_ARRAY ) ||
+        ( json->type == JSON_OBJECT ) )
+    {
+        /* a persistent version borrows its name and members */
+        pShared = ((JObject *)json)->pShared;
+    }
+
+    if( ( json->name != NULL ) &&
+        ( pShared == NULL ) )
+    {
+        free(json->name);
+        json->name = NULL;
+    }
+
+    switch( json->type )
+    {
+        case JSON_ARRAY:
+            pArray = (JArray *)json;
+            pNode = ( pShared == NULL ) ? pArray->pFirst : NULL;
+            while( pNode != NULL )
+            {
+                pDelete = pNode;
+                pNode = pNode->pNext;
+                pDelete->pNext = NULL;
+                pDelete->pPrev = NULL;
+                JSON_Free( pDelete );
+            }
+            memset( pArray, 0, sizeof( JArray ) );
+            break;
+
+        case JSON_OBJECT:
+            pObject = (JObject *)json;
+            pNode = ( pShared == NULL ) ? pObject->pFirst : NULL;
+            while( pNode != NULL )
+            {
+                pDelete = pNode;
+                pNode = pNode->pNext;
+                pDelete->pNext = NULL;
+                pDelete->pPrev = NULL;
+                JSON_Free( pDelete );
+            }
+            free( pObject->pIndex );
+            memset( pObject, 0, sizeof( JObject ) );
+            break;
+
+        case JSON_NULL:
+        case JSON_BOOL:
+        case JSON_VAR:
+            pVar = (JVar *)json;
+            if ( pVar->var.type == JVARTYPE_STR )
+            {
+                if ( pVar->var.val.str != NULL )
+                {
+                    free( pVar->var.val.str );
+                    pVar->var.val.str = NULL;
+                }
+            }
+            memset( pVar, 0, sizeof( JVar ) );
+            break;
+
+        default:
+            break;
+    }
+
+    json_FreeStorage( json, flags );
+
+    JSON_Release( pShared );
+}
+
+/*==========================================================================*/
+/*  json_FreeStorage                                                        */
+/*!
+    Free the storage of a JSON node
+
+    The json_FreeStorage function releases the memory holding a JSON
+    node structure, without touching its name, value or children.  The
+    node was either allocated individually by one of the JSON node
+    constructors, or packed into a small container allocation by the
+    parser, or relocated into a compacted block by JSON_Compact.
+
+    @param[in]
+        json
+            pointer to the JSON node
+
+    @param[in]
+        flags
+            the node's flags (which may have been cleared from the node)
+
+============================================================================*/
+void json_FreeStorage( JNode *json, uint32_t flags )
+{
+    if( ( flags & ( JSON_NODE_INLINE | JSON_NODE_SMALL ) ) != 0 )
+    {
+        json_SmallRelease( json, flags );
+    }
+    else if( ( flags & JSON_NODE_COMPACT ) != 0 )
+    {
+        json_CompactRelease( json, flags );
+    }
+    else
+    {
+        free( json );
+    }
+}
+
+/*==========================================================================*/
+/*  json_SmallPack                                                          */
+/*!
+    Pack a small container into a single allocation
+
+    The json_SmallPack function is called by the parser when it has
+    parsed a JSON array or object.  If the container has no more than
+    JSON_SMALL_MAX members (see JSON_SetSmallContainerMax), it is moved
+    into a single allocation together with its scalar members, so a
+    short record is one contiguous block instead of one heap node per
+    member.  Members which are themselves arrays or objects stay where
+    they are.  The member order is unchanged.
+
+    The packed container and its members remain fully mutable.  The
+    allocation is released when the container and every inline member
+    has been freed, so an inline member removed from the container
+    stays valid.
+
+    @param[in]
+        pNode
+            pointer to the parsed container
+
+    @retval pointer to the packed container
+    @retval pNode if the container was not packed
+
+============================================================================*/
+JNode *json_SmallPack( JNode *pNode )
+{
+    JNode *result = pNode;
+    JObject *pContainer = (JObject *)pNode;
+    JSmallBlock *pBlock;
+    JNode *pChild;
+    JNode *pNext;
+    JNode *pPrev = NULL;
+    JVar *pVar;
+    uint32_t count = 0;
+
+    if( ( ( pNode->type == JSON_ARRAY ) ||
+          ( ( pNode->type == JSON_OBJECT ) &&
+            ( pContainer->pIndex == NULL ) ) ) &&
+        ( pNode->flags == 0 ) &&
+        ( pNode->refcount == 0 ) &&
+        ( pContainer->pShared == NULL ) &&
+        ( pContainer->n <= __atomic_load_n( &json_smallMax,
+                                            __ATOMIC_RELAXED ) ) )
+    {
+        for( pChild = pContainer->pFirst;
+             pChild != NULL;
+             pChild = pChild->pNext )
+        {
+            if( json_SmallMember( pChild ) == true )
+            {
+                count++;
+            }
+        }
+    }
+
+    if( count > 0 )
+    {
+        pBlock = calloc( 1, sizeof( JSmallBlock ) +
+                            ( count * sizeof( JVar ) ) );
+        if( pBlock != NULL )
+        {
+            memcpy( &pBlock->container,
+                    pContainer,
+                    ( pNode->type == JSON_OBJECT ) ? sizeof( JObject )
+                                                   : sizeof( JArray ) );
+            pBlock->container.node.flags = JSON_NODE_SMALL;
+            pBlock->live = count + 1;
+
+            /* relink the members, moving the scalars into the block */
+            count = 0;
+            for( pChild = pContainer->pFirst; pChild != NULL; pChild = pNext )
+            {
+                pNext = pChild->pNext;
+
+                if( json_SmallMember( pChild ) == true )
+                {
+                    pVar = &pBlock->members[count];
+                    *pVar = *(JVar *)pChild;
+                    pVar->node.flags = JSON_NODE_INLINE |
+                                       ( count << JSON_SMALL_SLOT_SHIFT );
+                    free( pChild );
+                    pChild = &pVar->node;
+                    count++;
+                }
+
+                pChild->pPrev = pPrev;
+                pChild->pNext = NULL;
+                if( pPrev == NULL )
+                {
+                    pBlock->container.pFirst = pChild;
+                }
+                else
+                {
+                    pPrev->pNext = pChild;
+                }
+
+                pPrev = pChild;
+            }
+
+            pBlock->container.pLast = pPrev;
+
+            free( pContainer );
+            result = &pBlock->container.node;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_SmallRelease                                                       */
+/*!
+    Release a node stored in a small container allocation
+
+    The json_SmallRelease function is called when a small container or
+    one of its inline members has been freed.  The allocation is freed
+    when the last of the nodes stored in it has been released.
+
+    @param[in]
+        json
+            pointer to the freed node
+
+    @param[in]
+        flags
+            the node's flags before it was freed
+
+============================================================================*/
+static void json_SmallRelease( JNode *json, uint32_t flags )
+{
+    JSmallBlock *pBlock = (JSmallBlock *)json;
+    size_t slot;
+
+    if( ( flags & JSON_NODE_INLINE ) != 0 )
+    {
+        /* find the start of the block from the member's slot number */
+        slot = ( flags >> JSON_SMALL_SLOT_SHIFT ) & 0xFF;
+        pBlock = (JSmallBlock *)( (char *)( (JVar *)json - slot ) -
+                                  offsetof( JSmallBlock, members ) );
+    }
+
+    if( __atomic_sub_fetch( &pBlock->live, 1, __ATOMIC_ACQ_REL ) == 0 )
+    {
+        free( pBlock );
+    }
+}
+
+/*==========================================================================*/
+/*  json_SmallMember                                                        */
+/*!
+    Check if a container member can be stored inline
+
+    The json_SmallMember function checks if a member of a container
+    being packed by json_SmallPack is a scalar in its own unshared
+    heap allocation.
+
+    @param[in]
+        pNode
+            pointer to the container member
+
+    @retval true the member can be moved into the container's allocation
+    @retval false the member must stay where it is
+
+============================================================================*/
+static bool json_SmallMember( JNode *pNode )
+{
+    return ( ( pNode->type == JSON_VAR ) ||
+             ( pNode->type == JSON_BOOL ) ||
+             ( pNode->type == JSON_NULL ) ) &&
+           ( pNode->flags == 0 ) &&
+           ( pNode->refcount == 0 );
+}
+
+/*==========================================================================*/
+/*  JSON_Print                                                              */
+/*!
+    Output a JSON object to a file
+
+    The JSON_Print function outputs the JSON object recursively
+    to the specified output stream
+
+    @param[in]
+        json
+            pointer to the JSON Object to output
+
+    @param[in]
+        fp
+            pointer to the output stream
+
+    @param[in]
+        comma
+            true - output leading comma
+            false - no leading comma
+
+============================================================================*/
+void JSON_Print( JNode *json, FILE *fp, bool comma )
+{
+    JArray *pArray;
+    JVar *pVar;
+    JObject *pObject;
+    JNode *pNode;
+
+    if( ( json != NULL ) &&
+        ( fp != NULL ) )
+    {
+        if( comma == true )
+        {
+            fprintf(fp, "," );
+            comma = false;
+        }
+
+        if( json->name != NULL )
+        {
+            fprintf(fp, "\"%s\" : ", json->name );
+        }
+
+        switch( json->type )
+        {
+            case JSON_ARRAY:
+                pArray = (JArray *)json;
+                fprintf( fp, "[" );
+                pNode = pArray->pFirst;
+                while( pNode != NULL )
+                {
+                    JSON_Print( pNode, fp, comma );
+                    comma = true;
+                    pNode = pNode->pNext;
+                }
+                fprintf( fp, "]" );
+                break;
+
+            case JSON_OBJECT:
+                pObject = (JObject *)json;
+                fprintf( fp, "{" );
+                pNode = pObject->pFirst;
+                while( pNode != NULL )
+                {
+                    JSON_Print( pNode, fp, comma );
+                    comma = true;
+                    pNode = pNode->pNext;
+                }
+                fprintf( fp, "}" );
+                break;
+
+            case JSON_NULL:
+                fprintf( fp, "null" );
+                break;
+
+            case JSON_BOOL:
+            case JSON_VAR:
+                pVar = (JVar *)json;
+                json_PrintValue( pVar, fp );
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  json_Nth                                                                */
+/*!
+    Get a member of a container by position
+
+    The json_Nth function gets the member at the specified position of
+    a JSON array or object, walking from whichever end is nearer.
+
+    @param[in]
+        pContainer
+            pointer to the JSON array or object
+
+    @param[in]
+        idx
+            position of the member, which must be less than the number
+            of members
+
+    @retval pointer to the member
+
+============================================================================*/
+static JNode *json_Nth( JObject *pContainer, size_t idx )
+{
+    JNode *pNode;
+    size_t i;
+
+    if( idx < ( pContainer->n / 2 ) )
+    {
+        pNode = pContainer->pFirst;
+        for( i = 0; i < idx; i++ )
+        {
+            pNode = pNode->pNext;
+        }
+    }
+    else
+    {
+        pNode = pContainer->pLast;
+        for( i = pContainer->n - 1; i > idx; i-- )
+        {
+            pNode = pNode->pPrev;
+        }
+    }
+
+    return pNode;
+}
+
+/*==========================================================================*/
+/*  json_Contains                                                           */
+/*!
+    Check in constant time if a node may be a member of a container
+
+    The json_Contains function checks if a node is a member of a JSON
+    array or object without walking the member list.  An indexed object
+    looks the node up in its hash index.  Otherwise a node at either
+    end of a list must be the same end of the container, and a node
+    in the middle of a list is assumed to be a member.
+
+    @param[in]
+        pContainer
+            pointer to the JSON array or object
+
+    @param[in]
+        pNode
+            pointer to the node to check
+
+    @retval true the node is, or is assumed to be, a member of the
+            container
+    @retval false the node is not a member of the container
+
+============================================================================*/
+static bool json_Contains( JObject *pContainer, JNode *pNode )
+{
+    bool result = true;
+
+    if( ( pContainer->node.type == JSON_OBJECT ) &&
+        ( pContainer->pIndex != NULL ) )
+    {
+        result = ( json_IndexSlot( pContainer->pIndex, pNode ) <
+                   pContainer->pIndex->size );
+    }
+    else if( pNode->pPrev == NULL )
+    {
+        result = ( pNode == pContainer->pFirst );
+    }
+    else if( pNode->pNext == NULL )
+    {
+        result = ( pNode == pContainer->pLast );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PrintValue                                                         */
+/*!
+    Output a JSON value to a file
+
+    The json_PrintValue function outputs the JSON value
+    to the specified output stream
+
+    @param[in]
+        pVar
+            pointer to the JSON Variable to output
+
+    @param[in]
+        fp
+            pointer to the output stream
+
+============================================================================*/
+static void json_PrintValue( JVar *pVar, FILE *fp )
+{
+    if( ( pVar != NULL ) &&
+        ( fp != NULL ) )
+    {
+        if( pVar->node.type == JSON_BOOL )
+        {
+            fprintf( fp, "%s", (pVar->var.val.ui > 0 ) ? "true" : "false " );
+        }
+        else
+        {
+            switch( pVar->var.type )
+            {
+                case JVARTYPE_UINT16:
+                    fprintf( fp, "%d", pVar->var.val.ui );
+                    break;
+
+                case JVARTYPE_INT16:
+                    fprintf( fp, "%d", pVar->var.val.i );
+                    break;
+
+                case JVARTYPE_UINT32:
+                    fprintf( fp, "%d", pVar->var.val.ul );
+                    break;
+
+                case JVARTYPE_INT32:
+                    fprintf( fp, "%d", pVar->var.val.l );
+                    break;
+
+                case JVARTYPE_UINT64:
+                    fprintf( fp, "%" PRIu64, pVar->var.val.ull );
+                    break;
+
+                case JVARTYPE_INT64:
+                    fprintf( fp, "%" PRId64, pVar->var.val.ll );
+                    break;
+
+                case JVARTYPE_FLOAT:
+                    fprintf( fp, "%f", pVar->var.val.f );
+                    break;
+
+                case JVARTYPE_STR:
+                    fprintf( fp, "\"%s\"", pVar->var.val.str );
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  JSON_Find                                                               */
+/*!
+    Find the specified element in the JSON object
+
+    The JSON_Find function recursively searches through the specified JSON
+    object looking for the attribute with the specified key name
+
+    @param[in]
+        json
+            pointer to the JSON object to search in
+
+    @param[in]
+        key
+            name of the element to search for in the JSON object
+
+    @retval pointer to the JSON node found
+    @retval NULL if the JSON node was not found
+
+============================================================================*/
+JNode *JSON_Find( JNode *json, char *key )
+{
+    JNode *found = NULL;
+    JArray *pArray;
+    JObject *pObject;
+
+    if( ( key != NULL ) &&
+        ( json != NULL ) )
+    {
+        switch( json->type )
+        {
+            case JSON_ARRAY:
+                if( json->name != NULL )
+                {
+                    /* see if this array is the one we are looking for */
+                    if( strcmp( key, json->name ) == 0 )
+                    {
+                        found = json;
+                    }
+                }
+
+                if( found == NULL )
+                {
+                    /* look for the name inside the array */
+                    pArray = (JArray *)json;
+                    found = JSON_Find( pArray->pFirst, key );
+                }
+                break;
+
+            case JSON_OBJECT:
+                if( json->name != NULL )
+                {
+                    /* see if this object is the one we are looking for */
+                    if( strcmp( key, json->name ) == 0 )
+                    {
+                        found = json;
+                    }
+                }
+
+                if( found == NULL )
+                {
+                    /* look for the name inside the object */
+                    pObject = (JObject *)json;
+                    found = JSON_Find( pObject->pFirst, key );
+                }
+                break;
+
+            case JSON_NULL:
+            case JSON_BOOL:
+            case JSON_VAR:
+                if( json->name != NULL )
+                {
+                    if( strcmp( key, json->name ) == 0 )
+                    {
+                        found = json;
+                    }
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        if( found == NULL )
+        {
+            /* look at the next element in the object or array */
+            found = JSON_Find( json->pNext, key );
+        }
+    }
+
+    return found;
+}
+
+/*==========================================================================*/
+/*  JSON_Array                                                              */
+/*!
+    Create a JSON array
+
+    The JSON_Array function creates a new JSON array
+
+    @param[in]
+        name
+            pointer to the name of the JSON object.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @retval pointer to a new JSON array
+    @retval NULL if the JSON array could not be created
+
+============================================================================*/
+JArray *JSON_Array( char *name )
+{
+    JArray *pArray = json_NodeAlloc( sizeof( JArray ) );
+    if( pArray != NULL )
+    {
+        pArray->node.name = name;
+        pArray->node.type = JSON_ARRAY;
+    }
+
+    return pArray;
+}
+
+/*==========================================================================*/
+/*  JSON_Object                                                             */
+/*!
+    Create a JSON object
+
+    The JSON_Object function creates a new JSON object
+
+    @param[in]
+        name
+            pointer to the name of the JSON object.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @retval pointer to a new JSON array object
+    @retval NULL if the JSON array object could not be created
+
+============================================================================*/
+JObject *JSON_Object( char *name )
+{
+    JObject *pObject = json_NodeAlloc( sizeof( JObject ) );
+    if( pObject != NULL )
+    {
+        pObject->node.name = name;
+        pObject->node.type = JSON_OBJECT;
+    }
+
+    return pObject;
+}
+
+/*==========================================================================*/
+/*  JSON_Var                                                                */
+/*!
+    Create a JSON object
+
+    The JSON_Var function creates a new JSON variable
+
+    @param[in]
+        name
+            pointer to the JSON string object name.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @retval pointer to a new JSON variable
+    @retval NULL if the JSON variable could not be created
+
+============================================================================*/
+JVar *JSON_Var( char *name )
+{
+    JVar *pVar = json_NodeAlloc( sizeof( JVar ) );
+    if( pVar != NULL )
+    {
+        pVar->node.name = name;
+        pVar->node.type = JSON_VAR;
+    }
+
+    return pVar;
+}
+
+/*==========================================================================*/
+/*  JSON_Num                                                                */
+/*!
+    Create a JSON object
+
+    The JSON_Num function creates a new JSON number variable
+
+    @param[in]
+        name
+            pointer to the JSON string object name.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @param[in]
+        num
+            value of the JSON Number
+
+    @retval pointer to a new JSON variable
+    @retval NULL if the JSON variable could not be created
+
+============================================================================*/
+JVar *JSON_Num( char *name, int num )
+{
+    JVar *pVar = JSON_Var( name );
+    if( pVar != NULL )
+    {
+        pVar->var.type = JVARTYPE_UINT32;
+        pVar->var.len = sizeof( uint32_t );
+        pVar->var.val.ul = num;
+    }
+
+    return pVar;
+}
+
+/*==========================================================================*/
+/*  JSON_ParseNumber                                                        */
+/*!
+    Create a JSON Number variable
+
+    The JSON_ParseNumber function creates a new JSON number variable of
+    the appropriate type given the number text.  It will parse the number
+    into one of the following variable types depending on the value
+    of the number:
+
+    - JVARTYPE_UINT16
+    - JVARTYPE_INT16
+    - JVARTYPE_UINT32
+    - JVARTYPE_INT32
+    - JVARTYPE_UINT64
+    - JVARTYPE_INT64
+
+    @param[in]
+        name
+            pointer to the JSON string object name.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @param[in]
+        numstr
+            pointer to the number value string
+
+    @retval pointer to a new JSON variable
+    @retval NULL if the JSON variable could not be created
+
+============================================================================*/
+JVar *JSON_ParseNumber( char *name, char *numstr )
+{
+    int64_t lli;
+    uint64_t llu;
+
+    JVar *pVar = JSON_Var( name );
+    if ( ( pVar != NULL ) && ( numstr != NULL ) )
+    {
+        /* check if number is negative */
+        if( numstr[0] == '-' )
+        {
+            lli = strtoll( numstr, NULL, 10 );
+            if ( ( lli > -32768 ) && ( lli < 32767 ) )
+            {
+                pVar->var.type = JVARTYPE_INT16;
+                pVar->var.len = sizeof( int16_t );
+                pVar->var.val.i = (int16_t)lli;
+            }
+            else if ( ( lli > -2147483648 ) && ( lli < 2147483647 ) )
+            {
+                pVar->var.type = JVARTYPE_INT32;
+                pVar->var.len = sizeof( int32_t );
+                pVar->var.val.l = (int32_t)lli;
+            }
+            else
+            {
+                pVar->var.type = JVARTYPE_INT64;
+                pVar->var.len = sizeof( int64_t );
+                pVar->var.val.ll = (int64_t)lli;
+            }
+        }
+        else
+        {
+            llu = strtoull( numstr, NULL, 10 );
+            if ( llu < 65535 )
+            {
+                pVar->var.type = JVARTYPE_UINT16;
+                pVar->var.len = sizeof( uint16_t );
+                pVar->var.val.ui = (uint16_t)llu;
+            }
+            else if ( llu < 4294967295 )
+            {
+                pVar->var.type = JVARTYPE_UINT32;
+                pVar->var.len = sizeof( uint32_t );
+                pVar->var.val.ul = (uint32_t)llu;
+            }
+            else
+            {
+                pVar->var.type = JVARTYPE_UINT64;
+                pVar->var.len = sizeof( uint64_t );
+                pVar->var.val.ull = llu;
+            }
+        }
+    }
+
+    return pVar;
+}
+
+/*==========================================================================*/
+/*  JSON_Float                                                              */
+/*!
+    Create a JSON float object
+
+    The JSON_Float function creates a new JSON float variable
+
+    @param[in]
+        name
+            pointer to the JSON string object name.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @param[in]
+        num
+            value of the JSON Number
+
+    @retval pointer to a new JSON float variable
+    @retval NULL if the JSON float variable could not be created
+
+============================================================================*/
+JVar *JSON_Float( char *name, float num )
+{
+    JVar *pVar = NULL;
+
+    pVar = JSON_Var( name );
+    if( pVar != NULL )
+    {
+        pVar->var.type = JVARTYPE_FLOAT;
+        pVar->var.val.f = num;
+        pVar->var.len = sizeof( float );
+    }
+
+    return pVar;
+}
+
+/*==========================================================================*/
+/*  JSON_Bool                                                               */
+/*!
+    Create a JSON bool object
+
+    The JSON_Bool function creates a new JSON bool variable
+
+    @param[in]
+        name
+            pointer to the JSON string object name.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @param[in]
+        num
+            value of the JSON Number: 0=False, 1=True
+
+    @retval pointer to a new JSON bool variable
+    @retval NULL if the JSON bool variable could not be created
+
+============================================================================*/
+JVar *JSON_Bool( char *name, int num )
+{
+    JVar *pVar = NULL;
+
+    pVar = JSON_Var( name );
+    if( pVar != NULL )
+    {
+        pVar->node.type = JSON_BOOL;
+        pVar->var.type = JVARTYPE_UINT16;
+        pVar->var.len = sizeof( uint16_t );
+        pVar->var.val.ui = ( num > 0 ) ? 1 : 0;
+    }
+
+    return pVar;
+}
+
+/*==========================================================================*/
+/*  JSON_Null                                                               */
+/*!
+    Create a JSON null object
+
+    The JSON_Null function creates a new JSON null variable
+
+    @param[in]
+        name
+            pointer to the JSON null object name.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @retval pointer to a new JSON null variable
+    @retval NULL if the JSON null variable could not be created
+
+============================================================================*/
+JVar *JSON_Null( char *name )
+{
+    JVar *pVar = NULL;
+
+    pVar = JSON_Var( name );
+    if( pVar != NULL )
+    {
+        pVar->node.type = JSON_NULL;
+    }
+
+    return pVar;
+}
+
+/*==========================================================================*/
+/*  JSON_Str                                                                */
+/*!
+    Create a JSON string object
+
+    The JSON_Str function creates a new JSON string variable
+
+    @param[in]
+        name
+            pointer to the JSON string object name.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @param[in]
+        str
+            pointer to the JSON string object value.  This value
+            must be on the heap.  This function takes a reference
+            to it.
+
+    @retval pointer to a new JSON string variable
+    @retval NULL if the JSON string variable could not be created
+
+============================================================================*/
+JVar *JSON_Str( char *name, char *str )
+{
+    JVar *pVar = NULL;
+
+    pVar = JSON_Var( name );
+    if( ( pVar != NULL ) &&
+        ( str != NULL ) )
+    {
+        pVar->var.type = JVARTYPE_STR;
+        pVar->var.val.str = str;
+        pVar->var.len = strlen( str );
+    }
+
+    return pVar;
+}
+
+/*============================================================================*/
+/*  JSON_GetStr                                                               */
+/*!
+    Get a JSON string attribute from the specified node
+
+    The JSON_GetStr function checks that the specified node is a JSON object,
+    and looks up the object attribute with the specified name and
+    returns a pointer to the string value associated with the name.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to get the value from
+
+    @param[in]
+        name
+            pointer to the name of the JSON object attribute to search for
+
+    @retval pointer to the value associated with the specified JSON attribute
+    @retval NULL unable to retrieve the JSON attribute value
+
+==============================================================================*/
+char *JSON_GetStr( JNode *pNode, char *name )
+{
+    JObject *pObject;
+    JVar *pValue;
+    char *result = NULL;
+
+    /* check that the node is an object */
+    if ( ( pNode != NULL ) &&
+         ( pNode->type == JSON_OBJECT ) &&
+         ( name != NULL ) )
+    {
+        /* look up the attribute of the object */
+        pObject = (JObject *)pNode;
+        pNode = JSON_Attribute( pObject, name );
+        if( pNode != NULL )
+        {
+            if( pNode->type == JSON_VAR )
+            {
+                pValue = (JVar *)pNode;
+                if( pValue->var.type == JVARTYPE_STR )
+                {
+                    result = pValue->var.val.str;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_GetBool                                                              */
+/*!
+    Get a boolean value attribute from the specified node
+
+    The JSON_GetBool function checks that the specified node is a JSON object,
+    and looks up the object attribute with the specified name and
+    returns a pointer to the boolean value associated with the name.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to get the value from
+
+    @param[in]
+        name
+            pointer to the name of the JSON object attribute to search for
+
+    @retval true the value is present and is true
+    @retval false the value is present and is false or the value is not present
+
+==============================================================================*/
+bool JSON_GetBool( JNode *pNode, char *name )
+{
+    JObject *pObject;
+    JVar *pValue;
+    bool result = false;
+
+    /* check that the node is an object */
+    if ( ( pNode != NULL ) &&
+         ( pNode->type == JSON_OBJECT ) &&
+         ( name != NULL ) )
+    {
+        /* look up the attribute of the object */
+        pObject = (JObject *)pNode;
+        pNode = JSON_Attribute( pObject, name );
+        if( pNode != NULL )
+        {
+            if( pNode->type == JSON_BOOL )
+            {
+                pValue = (JVar *)pNode;
+                if( pValue->var.type == JVARTYPE_UINT16 )
+                {
+                    result = ( pValue->var.val.ui == 0 ) ? false : true;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_GetNum                                                               */
+/*!
+    Get an integer value attribute from the specified node
+
+    The JSON_GetNum function checks that the specified node is a JSON object,
+    and looks up the object attribute with the specified name and
+    returns the integer value associated with the name.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to get the value from
+
+    @param[in]
+        name
+            pointer to the name of the JSON object attribute to search for
+
+    @param[in]
+        pVal
+            pointer to a location to store the retrieved value
+
+    @retval 0 the number was found and returned
+    @retval -1 the number could not be retrieved
+
+==============================================================================*/
+int JSON_GetNum( JNode *pNode, char *name, int *pVal )
+{
+    JObject *pObject;
+    JVar *pValue;
+    int result = -1;
+
+    /* check that the node is an object */
+    if ( ( pNode != NULL ) &&
+         ( pNode->type == JSON_OBJECT ) &&
+         ( name != NULL ) &&
+         ( pVal != NULL ) )
+    {
+        /* look up the attribute of the object */
+        pObject = (JObject *)pNode;
+        pNode = JSON_Attribute( pObject, name );
+        if( pNode != NULL )
+        {
+            if( pNode->type == JSON_VAR )
+            {
+                result = 0;
+                pValue = (JVar *)pNode;
+                switch( pValue->var.type )
+                {
+                    case JVARTYPE_UINT16:
+                        *pVal = pValue->var.val.ui;
+                        break;
+
+                    case JVARTYPE_INT16:
+                        *pVal = pValue->var.val.i;
+                        break;
+
+                    case JVARTYPE_UINT32:
+                        *pVal = pValue->var.val.ul;
+                        break;
+
+                    case JVARTYPE_INT32:
+                        *pVal = pValue->var.val.l;
+                        break;
+
+                    case JVARTYPE_UINT64:
+                        *pVal = pValue->var.val.ull;
+                        break;
+
+                    case JVARTYPE_INT64:
+                        *pVal = pValue->var.val.ll;
+                        break;
+
+                    default:
+                        result = -1;
+                        break;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_GetI64                                                               */
+/*!
+    Get an i64 integer value attribute from the specified node
+
+    The JSON_GetI64 function checks that the specified node is a JSON object,
+    and looks up the object attribute with the specified name and
+    returns the i64 integer value associated with the name.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to get the value from
+
+    @param[in]
+        name
+            pointer to the name of the JSON object attribute to search for
+
+    @param[in]
+        pVal
+            pointer to a location to store the retrieved value
+
+    @retval 0 the number was found and returned
+    @retval -1 the number could not be retrieved
+
+==============================================================================*/
+int JSON_GetI64( JNode *pNode, char *name, int64_t *pVal )
+{
+    JObject *pObject;
+    JVar *pValue;
+    int result = -1;
+
+    /* check that the node is an object */
+    if ( ( pNode != NULL ) &&
+         ( pNode->type == JSON_OBJECT ) &&
+         ( name != NULL ) &&
+         ( pVal != NULL ) )
+    {
+        /* look up the attribute of the object */
+        pObject = (JObject *)pNode;
+        pNode = JSON_Attribute( pObject, name );
+        if( pNode != NULL )
+        {
+            if( pNode->type == JSON_VAR )
+            {
+                result = 0;
+                pValue = (JVar *)pNode;
+                switch( pValue->var.type )
+                {
+                    case JVARTYPE_UINT16:
+                        *pVal = pValue->var.val.ui;
+                        break;
+
+                    case JVARTYPE_INT16:
+                        *pVal = pValue->var.val.i;
+                        break;
+
+                    case JVARTYPE_UINT32:
+                        *pVal = pValue->var.val.ul;
+                        break;
+
+                    case JVARTYPE_INT32:
+                        *pVal = pValue->var.val.l;
+                        break;
+
+                    case JVARTYPE_UINT64:
+                        *pVal = pValue->var.val.ull;
+                        break;
+
+                    case JVARTYPE_INT64:
+                        *pVal = pValue->var.val.ll;
+                        break;
+
+                    default:
+                        result = -1;
+                        break;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_GetVar                                                               */
+/*!
+    Get a variable object value attribute from the specified node
+
+    The JSON_GetVar function checks that the specified node is a JSON object,
+    and looks up the object attribute with the specified name and
+    returns the variable object associated with that name.
+    Note that the variable object returned is a reference to the JSON object
+    value and should not be modified by the caller.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to get the value from
+
+    @param[in]
+        name
+            pointer to the name of the JSON object attribute to search for
+
+    @retval pointer to the VarObject associated with the specified name
+    @retval NULL if the VarObject was not found
+
+==============================================================================*/
+JVarObject *JSON_GetVar( JNode *pNode, char *name )
+{
+    JObject *pObject;
+    JVar *pValue;
+    int result = -1;
+    JVarObject *pVar = NULL;
+
+    /* check that the node is an object */
+    if ( ( pNode != NULL ) &&
+         ( pNode->type == JSON_OBJECT ) &&
+         ( name != NULL ) )
+    {
+        /* look up the attribute of the object */
+        pObject = (JObject *)pNode;
+        pNode = JSON_Attribute( pObject, name );
+        if( pNode != NULL )
+        {
+            if( pNode->type == JSON_VAR )
+            {
+                pValue = (JVar *)pNode;
+                pVar = &(pValue->var);
+            }
+        }
+    }
+
+    return pVar;
+}
+
+/*============================================================================*/
+/*  JSON_GetFloat                                                             */
+/*!
+    Get a floating point value attribute from the specified node
+
+    The JSON_GetFloat function checks that the specified node is a JSON object,
+    and looks up the object attribute with the specified name and
+    returns the floating point value associated with the name.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to get the value from
+
+    @param[in]
+        name
+            pointer to the name of the JSON object attribute to search for
+
+    @param[in]
+        pVal
+            pointer to a location to store the retrieved value
+
+    @retval 0 the number was found and returned
+    @retval -1 the number could not be retrieved
+
+==============================================================================*/
+int JSON_GetFloat( JNode *pNode, char *name, float *pVal )
+{
+    JObject *pObject;
+    JVar *pValue;
+    int result = -1;
+
+    /* check that the node is an object */
+    if ( ( pNode != NULL ) &&
+         ( pNode->type == JSON_OBJECT ) &&
+         ( name != NULL ) &&
+         ( pVal != NULL ) )
+    {
+        /* look up the attribute of the object */
+        pObject = (JObject *)pNode;
+        pNode = JSON_Attribute( pObject, name );
+        if( pNode != NULL )
+        {
+            if( pNode->type == JSON_VAR )
+            {
+                pValue = (JVar *)pNode;
+                if( pValue->var.type == JVARTYPE_FLOAT )
+                {
+                    *pVal = pValue->var.val.f;
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_GetArraySize                                                         */
+/*!
+    Get the length of the JSON Array
+
+    The JSON_GetArraySize function returns the length of the JSON array.
+
+    @param[in]
+        pArray
+            pointer to the JSON array object
+
+    @retval -1 the input pointer does not point to a JSON Array
+    @retval the size of the JSON array
+
+==============================================================================*/
+int JSON_GetArraySize( JArray *pArray )
+{
+    int n = -1;
+
+    if ( pArray != NULL )
+    {
+        if( pArray->node.type == JSON_ARRAY )
+        {
+            n = pArray->n;
+        }
+    }
+
+    return n;
+}
+/*============================================================================*/
+/*  JSON_SetNum                                                               */
+/*!
+    Set an integer attribute of a JSON object
+
+    The JSON_SetNum function sets the value of the specified attribute
+    of a JSON object to an integer.  See JSON_SetI64.
+
+    @param[in]
+        pNode
+            pointer to the JSON object
+
+    @param[in]
+        name
+            name of the attribute to set
+
+    @param[in]
+        val
+            new value of the attribute
+
+    @retval EOK the attribute was set
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the attribute is an object or array
+    @retval EPERM the JSON object is read-only
+    @retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int JSON_SetNum( JNode *pNode, char *name, int val )
+{
+    return JSON_SetI64( pNode, name, val );
+}
+
+/*============================================================================*/
+/*  JSON_SetI64                                                               */
+/*!
+    Set a 64-bit integer attribute of a JSON object
+
+    The JSON_SetI64 function sets the value of the specified attribute
+    of a JSON object to an integer, reusing the existing attribute node
+    if there is one and adding the attribute otherwise.  An existing
+    integer keeps its type if the new value fits in it, and is otherwise
+    widened to the smallest type which can hold the new value.
+
+    @param[in]
+        pNode
+            pointer to the JSON object
+
+    @param[in]
+        name
+            name of the attribute to set
+
+    @param[in]
+        val
+            new value of the attribute
+
+    @retval EOK the attribute was set
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the attribute is an object or array
+    @retval EPERM the JSON object is read-only
+    @retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int JSON_SetI64( JNode *pNode, char *name, int64_t val )
+{
+    int result;
+    JVar *pVar;
+    JVarObject var;
+
+    pVar = json_SetMember( pNode, name, &result );
+    if( pVar != NULL )
+    {
+        var.type = pVar->var.type;
+        if( json_IntFits( var.type, val ) == false )
+        {
+            if( val < 0 )
+            {
+                var.type = ( val >= INT16_MIN ) ? JVARTYPE_INT16
+                         : ( val >= INT32_MIN ) ? JVARTYPE_INT32
+                         : JVARTYPE_INT64;
+            }
+            else
+            {
+                var.type = ( val <= UINT16_MAX ) ? JVARTYPE_UINT16
+                         : ( val <= UINT32_MAX ) ? JVARTYPE_UINT32
+                         : JVARTYPE_UINT64;
+            }
+        }
+
+        switch( var.type )
+        {
+            case JVARTYPE_UINT16:
+                var.len = sizeof( uint16_t );
+                var.val.ui = (uint16_t)val;
+                break;
+
+            case JVARTYPE_INT16:
+                var.len = sizeof( int16_t );
+                var.val.i = (int16_t)val;
+                break;
+
+            case JVARTYPE_UINT32:
+                var.len = sizeof( uint32_t );
+                var.val.ul = (uint32_t)val;
+                break;
+
+            case JVARTYPE_INT32:
+                var.len = sizeof( int32_t );
+                var.val.l = (int32_t)val;
+                break;
+
+            case JVARTYPE_UINT64:
+                var.len = sizeof( uint64_t );
+                var.val.ull = (uint64_t)val;
+                break;
+
+            default:
+                var.len = sizeof( int64_t );
+                var.val.ll = val;
+                break;
+        }
+
+        json_SetVar( (JObject *)pNode, pVar, &var );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_SetFloat                                                             */
+/*!
+    Set a floating point attribute of a JSON object
+
+    The JSON_SetFloat function sets the value of the specified attribute
+    of a JSON object to a floating point number, reusing the existing
+    attribute node if there is one and adding the attribute otherwise.
+
+    @param[in]
+        pNode
+            pointer to the JSON object
+
+    @param[in]
+        name
+            name of the attribute to set
+
+    @param[in]
+        val
+            new value of the attribute
+
+    @retval EOK the attribute was set
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the attribute is an object or array
+    @retval EPERM the JSON object is read-only
+    @retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int JSON_SetFloat( JNode *pNode, char *name, float val )
+{
+    int result;
+    JVar *pVar;
+    JVarObject var;
+
+    pVar = json_SetMember( pNode, name, &result );
+    if( pVar != NULL )
+    {
+        var.type = JVARTYPE_FLOAT;
+        var.len = sizeof( float );
+        var.val.ull = 0;
+        var.val.f = val;
+
+        json_SetVar( (JObject *)pNode, pVar, &var );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_SetStr                                                               */
+/*!
+    Set a string attribute of a JSON object
+
+    The JSON_SetStr function sets the value of the specified attribute
+    of a JSON object to a copy of the specified string, reusing the
+    existing attribute node if there is one and adding the attribute
+    otherwise.  If the attribute already holds a string, its storage
+    is resized with realloc, which can usually grow or shrink it in
+    place.
+
+    @param[in]
+        pNode
+            pointer to the JSON object
+
+    @param[in]
+        name
+            name of the attribute to set
+
+    @param[in]
+        str
+            pointer to the NUL terminated string to copy
+
+    @retval EOK the attribute was set
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the attribute is an object or array
+    @retval EPERM the JSON object is read-only
+    @retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int JSON_SetStr( JNode *pNode, char *name, char *str )
+{
+    int result = EINVAL;
+    JVar *pVar = NULL;
+    char *old = NULL;
+    char *copy;
+    size_t len;
+
+    if( str != NULL )
+    {
+        pVar = json_SetMember( pNode, name, &result );
+    }
+
+    if( pVar != NULL )
+    {
+        len = strlen( str );
+
+        if( pVar->var.type == JVARTYPE_STR )
+        {
+            old = pVar->var.val.str;
+        }
+
+        if( ( old != NULL ) && ( strcmp( old, str ) == 0 ) )
+        {
+            /* unchanged */
+        }
+        else if( ( old != NULL ) &&
+                 ( ( str < old ) || ( str > ( old + strlen( old ) ) ) ) )
+        {
+            /* resize the existing storage, usually in place.  A new
+               value taken from the old one is copied instead, since
+               realloc may move it */
+            copy = realloc( old, len + 1 );
+            if( copy != NULL )
+            {
+                memcpy( copy, str, len + 1 );
+                pVar->var.len = len;
+                pVar->var.val.str = copy;
+                json_HashModified( (JObject *)pNode );
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+        else
+        {
+            str = strdup( str );
+            if( str != NULL )
+            {
+                free( old );
+                pVar->node.type = JSON_VAR;
+                pVar->var.type = JVARTYPE_STR;
+                pVar->var.len = len;
+                pVar->var.val.str = str;
+                json_HashModified( (JObject *)pNode );
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+    }
+
+    return result;
+}
+
+
+/*============================================================================*/
+/*  JSON_Hash                                                                 */
+/*!
+    Compute the structural hash of a JSON value
+
+    The JSON_Hash function computes a 64-bit hash of a JSON value and all
+    of its children.  Equal values (as determined by JSON_Equal) have the
+    same hash.  Integers hash by value irrespective of the width chosen to
+    store them, and the name of the value itself is not included, though
+    the names of object members are.
+
+    If the JSON_HASH_UNORDERED flag is specified, the members of an object
+    hash the same irrespective of their order.  Unordered hashes of
+    objects and arrays are cached in the container and re-used until the
+    document is modified through the library (or JSON_HashInvalidate is
+    called), unless the JSON_HASH_NOCACHE flag is specified.
+
+    @param[in]
+        pNode
+            pointer to the JSON value to hash
+
+    @param[in]
+        flags
+            JSON_HASH_UNORDERED - ignore the order of object members
+            JSON_HASH_NOCACHE - do not use or update cached hashes
+
+    @retval the structural hash of the JSON value
+    @retval 0 if pNode is NULL
+
+==============================================================================*/
+uint64_t JSON_Hash( JNode *pNode, uint32_t flags )
+{
+    uint64_t hash = 0;
+
+    if( pNode != NULL )
+    {
+        hash = json_HashNode( pNode, flags );
+    }
+
+    return hash;
+}
+
+/*============================================================================*/
+/*  JSON_Equal                                                                */
+/*!
+    Compare two JSON values
+
+    The JSON_Equal function checks if two JSON values are structurally
+    equal.  Object members are compared irrespective of their order,
+    except that members which share a name are compared in order,
+    integers are compared by value, and the names of the two values
+    themselves are ignored.
+
+    The unordered structural hashes of containers are compared first,
+    so containers which differ are usually rejected without visiting
+    their children, and containers are only compared member by member
+    when their hashes match.
+
+    @param[in]
+        a
+            pointer to the first JSON value
+
+    @param[in]
+        b
+            pointer to the second JSON value
+
+    @retval true the values are equal
+    @retval false the values are different
+
+==============================================================================*/
+bool JSON_Equal( JNode *a, JNode *b )
+{
+    bool result = false;
+    JNode *pA;
+    JNode *pB;
+
+    if( a == b )
+    {
+        result = true;
+    }
+    else if( ( a != NULL ) &&
+             ( b != NULL ) &&
+             ( a->type == b->type ) )
+    {
+        switch( a->type )
+        {
+            case JSON_OBJECT:
+                if( ( ((JObject *)a)->n == ((JObject *)b)->n ) &&
+                    ( json_HashNode( a, JSON_HASH_UNORDERED ) ==
+                      json_HashNode( b, JSON_HASH_UNORDERED ) ) )
+                {
+                    /* confirm the match member by member */
+                    result = true;
+                    pA = ((JObject *)a)->pFirst;
+                    while( ( pA != NULL ) && ( result == true ) )
+                    {
+                        pB = json_Namesake( (JObject *)a,
+                                            pA,
+                                            (JObject *)b );
+                        result = JSON_Equal( pA, pB );
+                        pA = pA->pNext;
+                    }
+                }
+                break;
+
+            case JSON_ARRAY:
+                if( ( ((JArray *)a)->n == ((JArray *)b)->n ) &&
+                    ( json_HashNode( a, JSON_HASH_UNORDERED ) ==
+                      json_HashNode( b, JSON_HASH_UNORDERED ) ) )
+                {
+                    /* confirm the match element by element */
+                    result = true;
+                    pA = ((JArray *)a)->pFirst;
+                    pB = ((JArray *)b)->pFirst;
+                    while( ( pA != NULL ) && ( result == true ) )
+                    {
+                        result = JSON_Equal( pA, pB );
+                        pA = pA->pNext;
+                        pB = ( pB != NULL ) ? pB->pNext : NULL;
+                    }
+                }
+                break;
+
+            case JSON_NULL:
+                result = true;
+                break;
+
+            case JSON_BOOL:
+            case JSON_VAR:
+                result = json_VarEqual( &((JVar *)a)->var, &((JVar *)b)->var );
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  JSON_HashInvalidate                                                       */
+/*!
+    Invalidate all cached structural hashes
+
+    The JSON_HashInvalidate function invalidates every cached container
+    hash.  The library calls it whenever it modifies a container which
+    may have a cached hash.  Applications which modify JSON nodes
+    directly must call it before hashing or comparing them again.
+
+==============================================================================*/
+void JSON_HashInvalidate( void )
+{
+    __atomic_add_fetch( &json_hashEpoch, 1, __ATOMIC_RELEASE );
+}
+
+/*============================================================================*/
+/*  JSON_SetObjectIndexThreshold                                              */
+/*!
+    Set the size at which JSON objects are indexed
+
+    The JSON_SetObjectIndexThreshold function sets the number of members
+    at which a JSON object switches from a linear scan of its member
+    list to an open addressing hash index of its members.  Objects with
+    fewer than half the threshold members go back to a linear scan.
+    Existing objects adapt the next time a member is added or removed.
+    The member list, and therefore the iteration order, is unaffected.
+
+    @param[in]
+        threshold
+            number of members at which objects are indexed,
+            or 0 to disable indexing
+
+==============================================================================*/
+void JSON_SetObjectIndexThreshold( size_t threshold )
+{
+    __atomic_store_n( &json_indexThreshold, threshold, __ATOMIC_RELAXED );
+}
+
+/*============================================================================*/
+/*  JSON_SetSmallContainerMax                                                 */
+/*!
+    Set the size up to which parsed containers are packed
+
+    The JSON_SetSmallContainerMax function sets the largest number of
+    members a parsed JSON array or object may have for it to be packed
+    into a single allocation together with its scalar members.  It
+    applies to documents parsed afterwards, and is limited to 255.
+
+    @param[in]
+        max
+            largest number of members of a packed container,
+            or 0 to disable packing
+
+==============================================================================*/
+void JSON_SetSmallContainerMax( size_t max )
+{
+    __atomic_store_n( &json_smallMax,
+                      ( max < JSON_SMALL_LIMIT ) ? max : JSON_SMALL_LIMIT,
+                      __ATOMIC_RELAXED );
+}
+
+/*============================================================================*/
+/*  JSON_GetObjectIndexStats                                                  */
+/*!
+    Get JSON object index statistics
+
+    The JSON_GetObjectIndexStats function gets the number of JSON
+    objects which have been promoted to, and demoted from, a hash
+    index, and the number of times an index has been resized.
+
+    @param[out]
+        pStats
+            pointer to a location to store the statistics
+
+==============================================================================*/
+void JSON_GetObjectIndexStats( JObjectIndexStats *pStats )
+{
+    if( pStats != NULL )
+    {
+        pStats->promotions = __atomic_load_n( &json_indexStats.promotions,
+                                              __ATOMIC_RELAXED );
+        pStats->demotions = __atomic_load_n( &json_indexStats.demotions,
+                                             __ATOMIC_RELAXED );
+        pStats->resizes = __atomic_load_n( &json_indexStats.resizes,
+                                           __ATOMIC_RELAXED );
+    }
+}
 
-            case JSON_BOOL:
-            case JSON_VAR:
-                pVar = (JVar *)json;
-                json_PrintValue( pVar, fp );
-                break;
+/*============================================================================*/
+/*  json_HashCached                                                           */
+/*!
+    Get the cached structural hash of a container
 
-            default:
-                break;
+    The json_HashCached function retrieves the cached unordered structural
+    hash of a JSON object or array without computing it.  It is used by
+    other parts of the library to short-circuit unchanged subtrees.
+
+    @param[in]
+        pNode
+            pointer to the JSON value
+
+    @param[out]
+        pHash
+            pointer to a location to store the cached hash
+
+    @retval true a valid cached hash was retrieved
+    @retval false the value has no valid cached hash
+
+==============================================================================*/
+bool json_HashCached( JNode *pNode, uint64_t *pHash )
+{
+    bool result = false;
+    JObject *pContainer;
+
+    if( ( pNode != NULL ) &&
+        ( ( pNode->type == JSON_OBJECT ) || ( pNode->type == JSON_ARRAY ) ) )
+    {
+        /* JArray and JObject share the same layout */
+        pContainer = (JObject *)pNode;
+        if( __atomic_load_n( &pContainer->hashEpoch, __ATOMIC_ACQUIRE ) ==
+            __atomic_load_n( &json_hashEpoch, __ATOMIC_ACQUIRE ) )
+        {
+            *pHash = pContainer->hash;
+            result = true;
         }
     }
+
+    return result;
 }
 
-/*==========================================================================*/
-/*  json_PrintValue                                                         */
+/*============================================================================*/
+/*  json_HashNode                                                             */
 /*!
-    Output a JSON value to a file
+    Compute the structural hash of a JSON value
 
-    The json_PrintValue function outputs the JSON value
-    to the specified output stream
+    The json_HashNode function recursively computes the structural hash
+    of a JSON value, using and updating the container hash cache for
+    unordered hashes.
 
     @param[in]
-        pVar
-            pointer to the JSON Variable to output
+        pNode
+            pointer to the JSON value to hash
 
     @param[in]
-        fp
-            pointer to the output stream
+        flags
+            JSON_HASH_UNORDERED and/or JSON_HASH_NOCACHE
 
-============================================================================*/
-static void json_PrintValue( JVar *pVar, FILE *fp )
+    @retval the structural hash of the JSON value
+
+==============================================================================*/
+static uint64_t json_HashNode( JNode *pNode, uint32_t flags )
 {
-    if( ( pVar != NULL ) &&
-        ( fp != NULL ) )
+    uint64_t hash = 0;
+    uint64_t sum = 0;
+    uint64_t epoch;
+    uint64_t member;
+    bool cache;
+    JObject *pContainer;
+    JVarObject *pVar;
+    JNode *pChild;
+    int64_t ll;
+    float f;
+    uint32_t bits;
+
+    cache = ( ( flags & JSON_HASH_UNORDERED ) != 0 ) &&
+            ( ( flags & JSON_HASH_NOCACHE ) == 0 );
+
+    switch( pNode->type )
     {
-        if( pVar->node.type == JSON_BOOL )
-        {
-            fprintf( fp, "%s", (pVar->var.val.ui > 0 ) ? "true" : "false " );
-        }
-        else
-        {
-            switch( pVar->var.type )
+        case JSON_OBJECT:
+        case JSON_ARRAY:
+            /* JArray and JObject share the same layout */
+            pContainer = (JObject *)pNode;
+            if( ( cache == true ) &&
+                ( json_HashCached( pNode, &hash ) == true ) )
             {
-                case JVARTYPE_UINT16:
-                    fprintf( fp, "%d", pVar->var.val.ui );
-                    break;
+                break;
+            }
 
-                case JVARTYPE_INT16:
-                    fprintf( fp, "%d", pVar->var.val.i );
-                    break;
+            /* sample the epoch first so a concurrent modification
+               leaves the cache entry stale rather than wrong */
+            epoch = __atomic_load_n( &json_hashEpoch, __ATOMIC_ACQUIRE );
 
-                case JVARTYPE_UINT32:
-                    fprintf( fp, "%d", pVar->var.val.ul );
-                    break;
+            hash = json_HashMix( pNode->type );
+            for( pChild = pContainer->pFirst;
+                 pChild != NULL;
+                 pChild = pChild->pNext )
+            {
+                member = json_HashNode( pChild, flags );
+                if( pNode->type == JSON_OBJECT )
+                {
+                    member = json_HashMix( member ^
+                                           json_HashStr( pChild->name ) );
+                    if( ( flags & JSON_HASH_UNORDERED ) != 0 )
+                    {
+                        /* order independent combination */
+                        sum += member;
+                        continue;
+                    }
+                }
 
-                case JVARTYPE_INT32:
-                    fprintf( fp, "%d", pVar->var.val.l );
-                    break;
+                hash = json_HashMix( hash ^ member );
+            }
 
-                case JVARTYPE_UINT64:
-                    fprintf( fp, "%" PRIu64, pVar->var.val.ull );
-                    break;
+            hash = json_HashMix( hash ^ sum );
 
-                case JVARTYPE_INT64:
-                    fprintf( fp, "%" PRId64, pVar->var.val.ll );
-                    break;
+            if( cache == true )
+            {
+                pContainer->hash = hash;
+                __atomic_store_n( &pContainer->hashEpoch,
+                                  epoch,
+                                  __ATOMIC_RELEASE );
+            }
+            break;
 
-                case JVARTYPE_FLOAT:
-                    fprintf( fp, "%f", pVar->var.val.f );
-                    break;
+        case JSON_NULL:
+            hash = json_HashMix( JSON_NULL );
+            break;
 
-                case JVARTYPE_STR:
-                    fprintf( fp, "\"%s\"", pVar->var.val.str );
-                    break;
+        case JSON_BOOL:
+            hash = json_HashMix( ( JSON_BOOL << 8 ) |
+                                 ( ((JVar *)pNode)->var.val.ui != 0 ) );
+            break;
 
-                default:
-                    break;
+        case JSON_VAR:
+            pVar = &((JVar *)pNode)->var;
+            if( json_VarInt( pVar, &ll ) == EOK )
+            {
+                hash = json_HashMix( JVARTYPE_INT64 ) ^ (uint64_t)ll;
             }
-        }
+            else if( pVar->type == JVARTYPE_UINT64 )
+            {
+                hash = json_HashMix( JVARTYPE_INT64 ) ^ pVar->val.ull;
+            }
+            else if( pVar->type == JVARTYPE_FLOAT )
+            {
+                /* +0.0 and -0.0 compare equal so must hash the same */
+                f = ( pVar->val.f == 0.0f ) ? 0.0f : pVar->val.f;
+                memcpy( &bits, &f, sizeof( bits ) );
+                hash = json_HashMix( JVARTYPE_FLOAT ) ^ bits;
+            }
+            else if( ( pVar->type == JVARTYPE_STR ) &&
+                     ( pVar->val.str != NULL ) )
+            {
+                hash = json_HashMix( JVARTYPE_STR ) ^
+                       json_HashStr( pVar->val.str );
+            }
+            else
+            {
+                hash = pVar->type;
+            }
+
+            hash = json_HashMix( hash );
+            break;
+
+        default:
+            break;
     }
+
+    return hash;
 }
 
-/*==========================================================================*/
-/*  JSON_Find                                                               */
+/*============================================================================*/
+/*  json_HashStr                                                              */
 /*!
-    Find the specified element in the JSON object
-
-    The JSON_Find function recursively searches through the specified JSON
-    object looking for the attribute with the specified key name
+    Hash a character string
 
-    @param[in]
-        json
-            pointer to the JSON object to search in
+    The json_HashStr function computes the 64-bit FNV-1a hash of a NUL
+    terminated character string.
 
     @param[in]
-        key
-            name of the element to search for in the JSON object
+        str
+            pointer to the NUL terminated string, or NULL
 
-    @retval pointer to the JSON node found
-    @retval NULL if the JSON node was not found
+    @retval hash of the string
 
-============================================================================*/
-JNode *JSON_Find( JNode *json, char *key )
+==============================================================================*/
+static uint64_t json_HashStr( char *str )
 {
-    JNode *found = NULL;
-    JArray *pArray;
-    JObject *pObject;
+    uint64_t hash = 14695981039346656037ULL;
 
-    if( ( key != NULL ) &&
-        ( json != NULL ) )
+    if( str != NULL )
     {
-        switch( json->type )
+        while( *str != 0 )
         {
-            case JSON_ARRAY:
-                if( json->name != NULL )
-                {
-                    /* see if this array is the one we are looking for */
-                    if( strcmp( key, json->name ) == 0 )
-                    {
-                        found = json;
-                    }
-                }
-
-                if( found == NULL )
-                {
-                    /* look for the name inside the array */
-                    pArray = (JArray *)json;
-                    found = JSON_Find( pArray->pFirst, key );
-                }
-                break;
+            hash ^= (uint8_t)*str++;
+            hash *= 1099511628211ULL;
+        }
+    }
 
-            case JSON_OBJECT:
-                if( json->name != NULL )
-                {
-                    /* see if this object is the one we are looking for */
-                    if( strcmp( key, json->name ) == 0 )
-                    {
-                        found = json;
-                    }
-                }
+    return hash;
+}
 
-                if( found == NULL )
-                {
-                    /* look for the name inside the object */
-                    pObject = (JObject *)json;
-                    found = JSON_Find( pObject->pFirst, key );
-                }
-                break;
+/*============================================================================*/
+/*  json_HashMix                                                              */
+/*!
+    Mix the bits of a 64-bit value
 
-            case JSON_BOOL:
-            case JSON_VAR:
-                if( json->name != NULL )
-                {
-                    if( strcmp( key, json->name ) == 0 )
-                    {
-                        found = json;
-                    }
-                }
-                break;
+    The json_HashMix function applies the splitmix64 finalizer so that
+    every input bit affects every output bit.
 
-            default:
-                break;
-        }
+    @param[in]
+        x
+            value to mix
 
-        if( found == NULL )
-        {
-            /* look at the next element in the object or array */
-            found = JSON_Find( json->pNext, key );
-        }
-    }
+    @retval mixed value
 
-    return found;
+==============================================================================*/
+static uint64_t json_HashMix( uint64_t x )
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = ( x ^ ( x >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    x = ( x ^ ( x >> 27 ) ) * 0x94D049BB133111EBULL;
+    return x ^ ( x >> 31 );
 }
 
 /*==========================================================================*/
-/*  JSON_Array                                                              */
+/*  json_Namesake                                                           */
 /*!
-    Create a JSON array
+    Find the corresponding member of another JSON object
 
-    The JSON_Array function creates a new JSON array
+    The json_Namesake function finds the member of another JSON object
+    with the same name as a member of a JSON object.  If the name is
+    repeated, the member in the same position among the members with
+    that name is found, so that repeated names are matched in order.
 
     @param[in]
-        name
-            pointer to the name of the JSON object.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+        pObject
+            pointer to the JSON object containing the member
 
-    @retval pointer to a new JSON array
-    @retval NULL if the JSON array could not be created
+    @param[in]
+        pMember
+            pointer to the member
+
+    @param[in]
+        pOther
+            pointer to the JSON object to search
+
+    @retval pointer to the corresponding member
+    @retval NULL there is no corresponding member
 
 ============================================================================*/
-JArray *JSON_Array( char *name )
+static JNode *json_Namesake( JObject *pObject, JNode *pMember, JObject *pOther )
 {
-    JArray *pArray = calloc( 1, sizeof( JArray ) );
-    if( pArray != NULL )
+    JNode *pNode;
+    JNode *pMatch;
+
+    pNode = JSON_Attribute( pObject, pMember->name );
+    pMatch = JSON_Attribute( pOther, pMember->name );
+
+    while( ( pNode != pMember ) &&
+           ( pNode != NULL ) &&
+           ( pMatch != NULL ) )
     {
-        pArray->node.name = name;
-        pArray->node.type = JSON_ARRAY;
+        pNode = json_NextNamed( pNode, pMember->name );
+        pMatch = json_NextNamed( pMatch, pMember->name );
     }
 
-    return pArray;
+    return ( pNode == pMember ) ? pMatch : NULL;
 }
 
 /*==========================================================================*/
-/*  JSON_Object                                                             */
+/*  json_NextNamed                                                          */
 /*!
-    Create a JSON object
+    Find the next member with a name
 
-    The JSON_Object function creates a new JSON object
+    @param[in]
+        pNode
+            pointer to the member to search after
 
     @param[in]
         name
-            pointer to the name of the JSON object.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+            name of the member to find
 
-    @retval pointer to a new JSON array object
-    @retval NULL if the JSON array object could not be created
+    @retval pointer to the next member with the name
+    @retval NULL there are no more members with the name
 
 ============================================================================*/
-JObject *JSON_Object( char *name )
+static JNode *json_NextNamed( JNode *pNode, char *name )
 {
-    JObject *pObject = calloc( 1, sizeof( JObject ) );
-    if( pObject != NULL )
+    pNode = pNode->pNext;
+    while( ( pNode != NULL ) &&
+           ( ( pNode->name == NULL ) ||
+             ( strcmp( pNode->name, name ) != 0 ) ) )
     {
-        pObject->node.name = name;
-        pObject->node.type = JSON_OBJECT;
+        pNode = pNode->pNext;
     }
 
-    return pObject;
+    return pNode;
 }
 
-/*==========================================================================*/
-/*  JSON_Var                                                                */
+/*============================================================================*/
+/*  json_VarEqual                                                             */
 /*!
-    Create a JSON object
+    Compare two variable values
 
-    The JSON_Var function creates a new JSON variable
+    The json_VarEqual function compares two variable values.  Integer
+    values are compared numerically so the storage width chosen for
+    them does not affect the comparison.
 
     @param[in]
-        name
-            pointer to the JSON string object name.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+        a
+            pointer to the first variable
 
-    @retval pointer to a new JSON variable
-    @retval NULL if the JSON variable could not be created
+    @param[in]
+        b
+            pointer to the second variable
 
-============================================================================*/
-JVar *JSON_Var( char *name )
+    @retval true the values are equal
+    @retval false the values are different
+
+==============================================================================*/
+static bool json_VarEqual( JVarObject *a, JVarObject *b )
 {
-    JVar *pVar = calloc( 1, sizeof( JVar ) );
-    if( pVar != NULL )
+    bool result = false;
+    int64_t ia;
+    int64_t ib;
+
+    if( ( json_VarInt( a, &ia ) == EOK ) &&
+        ( json_VarInt( b, &ib ) == EOK ) )
     {
-        pVar->node.name = name;
-        pVar->node.type = JSON_VAR;
+        /* both signed-representable integers */
+        result = ( ia == ib );
+    }
+    else if( a->type == b->type )
+    {
+        switch( a->type )
+        {
+            case JVARTYPE_UINT64:
+                result = ( a->val.ull == b->val.ull );
+                break;
+
+            case JVARTYPE_FLOAT:
+                result = ( a->val.f == b->val.f );
+                break;
+
+            case JVARTYPE_STR:
+                if( ( a->val.str != NULL ) &&
+                    ( b->val.str != NULL ) )
+                {
+                    result = ( strcmp( a->val.str, b->val.str ) == 0 );
+                }
+                else
+                {
+                    result = ( a->val.str == b->val.str );
+                }
+                break;
+
+            default:
+                result = ( a->val.ull == b->val.ull );
+                break;
+        }
     }
 
-    return pVar;
+    return result;
 }
 
-/*==========================================================================*/
-/*  JSON_Num                                                                */
+/*============================================================================*/
+/*  json_VarInt                                                               */
 /*!
-    Create a JSON object
+    Get a signed integer value
 
-    The JSON_Num function creates a new JSON number variable
+    The json_VarInt function widens an integer variable to a signed
+    64-bit value if it can be represented as one.
 
     @param[in]
-        name
-            pointer to the JSON string object name.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+        pVar
+            pointer to the variable
 
-    @param[in]
-        num
-            value of the JSON Number
+    @param[out]
+        pVal
+            pointer to a location to store the widened value
 
-    @retval pointer to a new JSON variable
-    @retval NULL if the JSON variable could not be created
+    @retval EOK the value was retrieved
+    @retval ENOTSUP the variable is not a signed-representable integer
 
-============================================================================*/
-JVar *JSON_Num( char *name, int num )
+==============================================================================*/
+static int json_VarInt( JVarObject *pVar, int64_t *pVal )
 {
-    JVar *pVar = JSON_Var( name );
-    if( pVar != NULL )
+    int result = EOK;
+
+    switch( pVar->type )
     {
-        pVar->var.type = JVARTYPE_UINT32;
-        pVar->var.len = sizeof( uint32_t );
-        pVar->var.val.ul = num;
+        case JVARTYPE_UINT16:
+            *pVal = pVar->val.ui;
+            break;
+
+        case JVARTYPE_INT16:
+            *pVal = pVar->val.i;
+            break;
+
+        case JVARTYPE_UINT32:
+            *pVal = pVar->val.ul;
+            break;
+
+        case JVARTYPE_INT32:
+            *pVal = pVar->val.l;
+            break;
+
+        case JVARTYPE_INT64:
+            *pVal = pVar->val.ll;
+            break;
+
+        case JVARTYPE_UINT64:
+            if( pVar->val.ull <= INT64_MAX )
+            {
+                *pVal = (int64_t)pVar->val.ull;
+            }
+            else
+            {
+                result = ENOTSUP;
+            }
+            break;
+
+        default:
+            result = ENOTSUP;
+            break;
     }
 
-    return pVar;
+    return result;
 }
 
-/*==========================================================================*/
-/*  JSON_ParseNumber                                                        */
+/*============================================================================*/
+/*  json_SetMember                                                            */
 /*!
-    Create a JSON Number variable
+    Get the scalar attribute of a JSON object to update
 
-    The JSON_ParseNumber function creates a new JSON number variable of
-    the appropriate type given the number text.  It will parse the number
-    into one of the following variable types depending on the value
-    of the number:
+    The json_SetMember function finds the named attribute of a JSON
+    object so that its value can be updated in place.  If the attribute
+    does not exist it is added to the object.
 
-    - JVARTYPE_UINT16
-    - JVARTYPE_INT16
-    - JVARTYPE_UINT32
-    - JVARTYPE_INT32
-    - JVARTYPE_UINT64
-    - JVARTYPE_INT64
+    @param[in]
+        pNode
+            pointer to the JSON object
 
     @param[in]
         name
-            pointer to the JSON string object name.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+            name of the attribute
 
-    @param[in]
-        numstr
-            pointer to the number value string
+    @param[out]
+        pResult
+            location to store the result code
 
-    @retval pointer to a new JSON variable
-    @retval NULL if the JSON variable could not be created
+    @retval pointer to the attribute to update
+    @retval NULL the attribute cannot be updated (see pResult)
 
-============================================================================*/
-JVar *JSON_ParseNumber( char *name, char *numstr )
+==============================================================================*/
+static JVar *json_SetMember( JNode *pNode, char *name, int *pResult )
 {
-    int64_t lli;
-    uint64_t llu;
+    JVar *pVar = NULL;
+    JNode *pMember = NULL;
+    JObject *pObject = (JObject *)pNode;
+    char *copyname;
+    int result = EINVAL;
 
-    JVar *pVar = JSON_Var( name );
-    if ( ( pVar != NULL ) && ( numstr != NULL ) )
+    if( ( pNode != NULL ) &&
+        ( pNode->type == JSON_OBJECT ) &&
+        ( name != NULL ) )
     {
-        /* check if number is negative */
-        if( numstr[0] == '-' )
+        if( ( ( pNode->flags &
+                ( JSON_NODE_ARENA | JSON_NODE_SHARED ) ) != 0 ) ||
+            ( pObject->pShared != NULL ) )
         {
-            lli = strtoll( numstr, NULL, 10 );
-            if ( ( lli > -32768 ) && ( lli < 32767 ) )
-            {
-                pVar->var.type = JVARTYPE_INT16;
-                pVar->var.len = sizeof( int16_t );
-                pVar->var.val.i = (int16_t)lli;
-            }
-            else if ( ( lli > -2147483648 ) && ( lli < 2147483647 ) )
-            {
-                pVar->var.type = JVARTYPE_INT32;
-                pVar->var.len = sizeof( int32_t );
-                pVar->var.val.l = (int32_t)lli;
-            }
-            else
-            {
-                pVar->var.type = JVARTYPE_INT64;
-                pVar->var.len = sizeof( int64_t );
-                pVar->var.val.ll = (int64_t)lli;
-            }
+            result = EPERM;
         }
         else
         {
-            llu = strtoull( numstr, NULL, 10 );
-            if ( llu < 65535 )
-            {
-                pVar->var.type = JVARTYPE_UINT16;
-                pVar->var.len = sizeof( uint16_t );
-                pVar->var.val.ui = (uint16_t)llu;
-            }
-            else if ( llu < 4294967295 )
+            pMember = JSON_Attribute( pObject, name );
+            result = EOK;
+        }
+    }
+
+    if( ( result == EOK ) && ( pMember == NULL ) )
+    {
+        /* add a new attribute */
+        result = ENOMEM;
+        copyname = strdup( name );
+        if( copyname != NULL )
+        {
+            pMember = (JNode *)JSON_Var( copyname );
+            if( pMember != NULL )
             {
-                pVar->var.type = JVARTYPE_UINT32;
-                pVar->var.len = sizeof( uint32_t );
-                pVar->var.val.ul = (uint32_t)llu;
+                result = JSON_ObjectAdd( pObject, pMember );
             }
             else
             {
-                pVar->var.type = JVARTYPE_UINT64;
-                pVar->var.len = sizeof( uint64_t );
-                pVar->var.val.ull = llu;
+                free( copyname );
             }
         }
     }
 
+    if( result == EOK )
+    {
+        if( ( pMember->type == JSON_VAR ) ||
+            ( pMember->type == JSON_BOOL ) ||
+            ( pMember->type == JSON_NULL ) )
+        {
+            pVar = (JVar *)pMember;
+        }
+        else
+        {
+            result = ENOTSUP;
+        }
+    }
+
+    *pResult = result;
+
     return pVar;
 }
 
-/*==========================================================================*/
-/*  JSON_Float                                                              */
+/*============================================================================*/
+/*  json_SetVar                                                               */
 /*!
-    Create a JSON float object
+    Update the value of a scalar JSON node
 
-    The JSON_Float function creates a new JSON float variable
+    The json_SetVar function replaces the value of a scalar JSON node,
+    freeing any string it previously held.  The cached hashes of the
+    containing object are only invalidated if the value actually
+    changed.
 
     @param[in]
-        name
-            pointer to the JSON string object name.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+        pObject
+            pointer to the JSON object containing the node
 
     @param[in]
-        num
-            value of the JSON Number
+        pVar
+            pointer to the scalar JSON node to update
 
-    @retval pointer to a new JSON float variable
-    @retval NULL if the JSON float variable could not be created
+    @param[in]
+        pValue
+            pointer to the new (non string) value
 
-============================================================================*/
-JVar *JSON_Float( char *name, float num )
+==============================================================================*/
+static void json_SetVar( JObject *pObject, JVar *pVar, JVarObject *pValue )
 {
-    JVar *pVar = NULL;
-
-    pVar = JSON_Var( name );
-    if( pVar != NULL )
+    if( ( pVar->node.type != JSON_VAR ) ||
+        ( json_VarEqual( &pVar->var, pValue ) == false ) )
     {
-        pVar->var.type = JVARTYPE_FLOAT;
-        pVar->var.val.f = num;
-        pVar->var.len = sizeof( float );
-    }
+        if( pVar->var.type == JVARTYPE_STR )
+        {
+            free( pVar->var.val.str );
+        }
 
-    return pVar;
+        pVar->node.type = JSON_VAR;
+        pVar->var = *pValue;
+
+        json_HashModified( pObject );
+    }
 }
 
-/*==========================================================================*/
-/*  JSON_Bool                                                               */
+/*============================================================================*/
+/*  json_IntFits                                                              */
 /*!
-    Create a JSON bool object
-
-    The JSON_Bool function creates a new JSON bool variable
+    Check if an integer fits in a variable type
 
     @param[in]
-        name
-            pointer to the JSON string object name.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+        type
+            variable type
 
     @param[in]
-        num
-            value of the JSON Number: 0=False, 1=True
+        val
+            integer value
 
-    @retval pointer to a new JSON bool variable
-    @retval NULL if the JSON bool variable could not be created
+    @retval true the value can be stored in the type without loss
+    @retval false the type is not an integer type or is too narrow
 
-============================================================================*/
-JVar *JSON_Bool( char *name, int num )
+==============================================================================*/
+static bool json_IntFits( JVarType type, int64_t val )
 {
-    JVar *pVar = NULL;
+    bool result;
 
-    pVar = JSON_Var( name );
-    if( pVar != NULL )
+    switch( type )
     {
-        pVar->node.type = JSON_BOOL;
-        pVar->var.type = JVARTYPE_UINT16;
-        pVar->var.len = sizeof( uint16_t );
-        pVar->var.val.ui = ( num > 0 ) ? 1 : 0;
-    }
-
-    return pVar;
-}
-
-/*==========================================================================*/
-/*  JSON_Str                                                                */
-/*!
-    Create a JSON string object
+        case JVARTYPE_UINT16:
+            result = ( val >= 0 ) && ( val <= UINT16_MAX );
+            break;
 
-    The JSON_Str function creates a new JSON string variable
+        case JVARTYPE_INT16:
+            result = ( val >= INT16_MIN ) && ( val <= INT16_MAX );
+            break;
 
-    @param[in]
-        name
-            pointer to the JSON string object name.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+        case JVARTYPE_UINT32:
+            result = ( val >= 0 ) && ( val <= UINT32_MAX );
+            break;
 
-    @param[in]
-        str
-            pointer to the JSON string object value.  This value
-            must be on the heap.  This function takes a reference
-            to it.
+        case JVARTYPE_INT32:
+            result = ( val >= INT32_MIN ) && ( val <= INT32_MAX );
+            break;
 
-    @retval pointer to a new JSON string variable
-    @retval NULL if the JSON string variable could not be created
+        case JVARTYPE_UINT64:
+            result = ( val >= 0 );
+            break;
 
-============================================================================*/
-JVar *JSON_Str( char *name, char *str )
-{
-    JVar *pVar = NULL;
+        case JVARTYPE_INT64:
+            result = true;
+            break;
 
-    pVar = JSON_Var( name );
-    if( ( pVar != NULL ) &&
-        ( str != NULL ) )
-    {
-        pVar->var.type = JVARTYPE_STR;
-        pVar->var.val.str = str;
-        pVar->var.len = strlen( str );
+        default:
+            result = false;
+            break;
     }
 
-    return pVar;
+    return result;
 }
 
 /*============================================================================*/
-/*  JSON_GetStr                                                               */
+/*  json_HashModified                                                         */
 /*!
-    Get a JSON string attribute from the specified node
-
-    The JSON_GetStr function checks that the specified node is a JSON object,
-    and looks up the object attribute with the specified name and
-    returns a pointer to the string value associated with the name.
-
-    @param[in]
-        pNode
-            pointer to the JSON object to get the value from
-
-    @param[in]
-        name
-            pointer to the name of the JSON object attribute to search for
-
-    @retval pointer to the value associated with the specified JSON attribute
-    @retval NULL unable to retrieve the JSON attribute value
+    Invalidate cached hashes before modifying a container
 
-==============================================================================*/
-char *JSON_GetStr( JNode *pNode, char *name )
-{
-    JObject *pObject;
-    JVar *pValue;
-    char *result = NULL;
+    The json_HashModified function is called before a container is
+    modified.  A container which has never had its hash cached cannot
+    have an ancestor with a cached hash either (hashing an ancestor
+    caches the hashes of all of its descendants), so the global
+    invalidation is only needed for containers which have been hashed.
+    This keeps building new documents free of shared writes.
 
-    /* check that the node is an object */
-    if ( ( pNode != NULL ) &&
-         ( pNode->type == JSON_OBJECT ) &&
-         ( name != NULL ) )
-    {
-        /* get a pointer to the first attribute of the object */
-        pObject = (JObject *)pNode;
-        pNode = pObject->pFirst;
-        while( pNode != NULL )
-        {
-            if( strcmp( pNode->name, name ) == 0 )
-            {
-                if( pNode->type == JSON_VAR )
-                {
-                    pValue = (JVar *)pNode;
-                    if( pValue->var.type == JVARTYPE_STR )
-                    {
-                        result = pValue->var.val.str;
-                        break;
-                    }
-                }
-            }
+    @param[in]
+        pContainer
+            pointer to the JSON object or array being modified
 
-            /* move to the next attribute in the object */
-            pNode = pNode->pNext;
-        }
+==============================================================================*/
+static void json_HashModified( JObject *pContainer )
+{
+    if( pContainer->hashEpoch != 0 )
+    {
+        pContainer->hashEpoch = 0;
+        JSON_HashInvalidate();
     }
-
-    return result;
 }
 
 /*============================================================================*/
-/*  JSON_GetBool                                                              */
+/*  json_IndexFind                                                            */
 /*!
-    Get a boolean value attribute from the specified node
+    Look up a member in a JSON object index
 
-    The JSON_GetBool function checks that the specified node is a JSON object,
-    and looks up the object attribute with the specified name and
-    returns a pointer to the boolean value associated with the name.
+    The json_IndexFind function looks up the first member of a JSON
+    object with the specified name using the object's hash index.
 
     @param[in]
-        pNode
-            pointer to the JSON object to get the value from
+        pIndex
+            pointer to the object index
 
     @param[in]
         name
-            pointer to the name of the JSON object attribute to search for
+            name of the member to find
 
-    @retval true the value is present and is true
-    @retval false the value is present and is false or the value is not present
+    @retval pointer to the member
+    @retval NULL the object has no member with the specified name
 
 ==============================================================================*/
-bool JSON_GetBool( JNode *pNode, char *name )
+static JNode *json_IndexFind( JObjectIndex *pIndex, char *name )
 {
-    JObject *pObject;
-    JVar *pValue;
-    bool result = false;
+    JNode *pNode = NULL;
+    uint32_t hash = (uint32_t)json_HashStr( name );
+    size_t mask = pIndex->size - 1;
+    size_t i;
 
-    /* check that the node is an object */
-    if ( ( pNode != NULL ) &&
-         ( pNode->type == JSON_OBJECT ) &&
-         ( name != NULL ) )
+    for( i = hash & mask; pIndex->slots[i].pNode != NULL; i = ( i + 1 ) & mask )
     {
-        /* get a pointer to the first attribute of the object */
-        pObject = (JObject *)pNode;
-        pNode = pObject->pFirst;
-        while( pNode != NULL )
+        if( ( pIndex->slots[i].hash == hash ) &&
+            ( strcmp( pIndex->slots[i].pNode->name, name ) == 0 ) )
         {
-            if( strcmp( pNode->name, name ) == 0 )
-            {
-                if( pNode->type == JSON_BOOL )
-                {
-                    pValue = (JVar *)pNode;
-                    if( pValue->var.type == JVARTYPE_UINT16 )
-                    {
-                        result = ( pValue->var.val.ui == 0 ) ? false : true;
-                        break;
-                    }
-                }
-            }
-
-            /* move to the next attribute in the object */
-            pNode = pNode->pNext;
+            pNode = pIndex->slots[i].pNode;
+            break;
         }
     }
 
-    return result;
+    return pNode;
 }
 
 /*============================================================================*/
-/*  JSON_GetNum                                                               */
+/*  json_IndexAdd                                                             */
 /*!
-    Get an integer value attribute from the specified node
-
-    The JSON_GetNum function checks that the specified node is a JSON object,
-    and looks up the object attribute with the specified name and
-    returns the integer value associated with the name.
+    Add a member to a JSON object index
 
-    @param[in]
-        pNode
-            pointer to the JSON object to get the value from
+    The json_IndexAdd function is called after a member has been
+    appended to a JSON object.  It adds the member to the object's
+    index, growing the index as required, or promotes the object to an
+    indexed object once it reaches the index threshold.  If memory for
+    the index cannot be allocated the object is left unindexed.
 
     @param[in]
-        name
-            pointer to the name of the JSON object attribute to search for
+        pObject
+            pointer to the JSON object
 
     @param[in]
-        pVal
-            pointer to a location to store the retrieved value
-
-    @retval 0 the number was found and returned
-    @retval -1 the number could not be retrieved
+        pNode
+            pointer to the member which was appended
 
 ==============================================================================*/
-int JSON_GetNum( JNode *pNode, char *name, int *pVal )
+static void json_IndexAdd( JObject *pObject, JNode *pNode )
 {
-    JObject *pObject;
-    JVar *pValue;
-    int result = -1;
+    size_t threshold;
 
-    /* check that the node is an object */
-    if ( ( pNode != NULL ) &&
-         ( pNode->type == JSON_OBJECT ) &&
-         ( name != NULL ) &&
-         ( pVal != NULL ) )
+    if( pObject->pIndex == NULL )
     {
-        /* get a pointer to the first attribute of the object */
-        pObject = (JObject *)pNode;
-        pNode = pObject->pFirst;
-        while( pNode != NULL )
+        threshold = __atomic_load_n( &json_indexThreshold, __ATOMIC_RELAXED );
+        if( ( threshold > 0 ) &&
+            ( pObject->n >= threshold ) &&
+            ( json_IndexBuild( pObject ) == EOK ) )
         {
-            if( strcmp( pNode->name, name ) == 0 )
-            {
-                if( pNode->type == JSON_VAR )
-                {
-                    result = 0;
-                    pValue = (JVar *)pNode;
-                    switch( pValue->var.type )
-                    {
-                        case JVARTYPE_UINT16:
-                            *pVal = pValue->var.val.ui;
-                            break;
+            __atomic_add_fetch( &json_indexStats.promotions,
+                                1,
+                                __ATOMIC_RELAXED );
+        }
+    }
+    else if( ( pObject->pIndex->count + 1 ) * 2 > pObject->pIndex->size )
+    {
+        if( json_IndexBuild( pObject ) == EOK )
+        {
+            __atomic_add_fetch( &json_indexStats.resizes,
+                                1,
+                                __ATOMIC_RELAXED );
+        }
+    }
+    else
+    {
+        json_IndexInsert( pObject->pIndex, pNode );
+    }
+}
 
-                        case JVARTYPE_INT16:
-                            *pVal = pValue->var.val.i;
-                            break;
+/*============================================================================*/
+/*  json_IndexRemove                                                          */
+/*!
+    Remove a member from a JSON object index
 
-                        case JVARTYPE_UINT32:
-                            *pVal = pValue->var.val.ul;
-                            break;
+    The json_IndexRemove function is called after a member has been
+    unlinked from a JSON object.  It removes the member from the
+    object's index using backward shift deletion, so no tombstones are
+    left behind, and drops the index once the object has shrunk below
+    half the index threshold.
 
-                        case JVARTYPE_INT32:
-                            *pVal = pValue->var.val.l;
-                            break;
+    @param[in]
+        pObject
+            pointer to the JSON object
 
-                        case JVARTYPE_UINT64:
-                            *pVal = pValue->var.val.ull;
-                            break;
+    @param[in]
+        pNode
+            pointer to the member which was unlinked
 
-                        case JVARTYPE_INT64:
-                            *pVal = pValue->var.val.ll;
-                            break;
+==============================================================================*/
+static void json_IndexRemove( JObject *pObject, JNode *pNode )
+{
+    JObjectIndex *pIndex = pObject->pIndex;
+    size_t threshold;
+    size_t mask;
+    size_t home;
+    size_t i;
+    size_t j;
+
+    if( pIndex != NULL )
+    {
+        mask = pIndex->size - 1;
 
-                        default:
-                            result = -1;
-                            break;
-                    }
+        i = json_IndexSlot( pIndex, pNode );
+        if( i < pIndex->size )
+        {
+            /* shift later members of the probe sequence back */
+            for( j = ( i + 1 ) & mask;
+                 pIndex->slots[j].pNode != NULL;
+                 j = ( j + 1 ) & mask )
+            {
+                home = pIndex->slots[j].hash & mask;
+                if( ( ( j - home ) & mask ) >= ( ( j - i ) & mask ) )
+                {
+                    pIndex->slots[i] = pIndex->slots[j];
+                    i = j;
                 }
             }
 
-            /* move to the next attribute in the object */
-            pNode = pNode->pNext;
+            pIndex->slots[i].pNode = NULL;
+            pIndex->count--;
         }
-    }
 
-    return result;
+        threshold = __atomic_load_n( &json_indexThreshold, __ATOMIC_RELAXED );
+        if( ( pObject->n < ( threshold / 2 ) ) || ( threshold == 0 ) )
+        {
+            free( pIndex );
+            pObject->pIndex = NULL;
+            __atomic_add_fetch( &json_indexStats.demotions,
+                                1,
+                                __ATOMIC_RELAXED );
+        }
+    }
 }
 
 /*============================================================================*/
-/*  JSON_GetI64                                                               */
+/*  json_IndexReplace                                                         */
 /*!
-    Get an i64 integer value attribute from the specified node
+    Replace a member in a JSON object index
 
-    The JSON_GetI64 function checks that the specified node is a JSON object,
-    and looks up the object attribute with the specified name and
-    returns the i64 integer value associated with the name.
+    The json_IndexReplace function is called when a member of a JSON
+    object has been replaced in place by a member with the same name.
 
     @param[in]
-        pNode
-            pointer to the JSON object to get the value from
+        pObject
+            pointer to the JSON object
 
     @param[in]
-        name
-            pointer to the name of the JSON object attribute to search for
+        pOld
+            pointer to the member which was replaced
 
     @param[in]
-        pVal
-            pointer to a location to store the retrieved value
-
-    @retval 0 the number was found and returned
-    @retval -1 the number could not be retrieved
+        pNew
+            pointer to the member which replaced it
 
 ==============================================================================*/
-int JSON_GetI64( JNode *pNode, char *name, int64_t *pVal )
+void json_IndexReplace( JObject *pObject, JNode *pOld, JNode *pNew )
 {
-    JObject *pObject;
-    JVar *pValue;
-    int result = -1;
+    size_t i;
 
-    /* check that the node is an object */
-    if ( ( pNode != NULL ) &&
-         ( pNode->type == JSON_OBJECT ) &&
-         ( name != NULL ) &&
-         ( pVal != NULL ) )
+    if( pObject->pIndex != NULL )
     {
-        /* get a pointer to the first attribute of the object */
-        pObject = (JObject *)pNode;
-        pNode = pObject->pFirst;
-        while( pNode != NULL )
+        i = json_IndexSlot( pObject->pIndex, pOld );
+        if( i < pObject->pIndex->size )
         {
-            if( strcmp( pNode->name, name ) == 0 )
-            {
-                if( pNode->type == JSON_VAR )
-                {
-                    result = 0;
-                    pValue = (JVar *)pNode;
-                    switch( pValue->var.type )
-                    {
-                        case JVARTYPE_UINT16:
-                            *pVal = pValue->var.val.ui;
-                            break;
-
-                        case JVARTYPE_INT16:
-                            *pVal = pValue->var.val.i;
-                            break;
-
-                        case JVARTYPE_UINT32:
-                            *pVal = pValue->var.val.ul;
-                            break;
-
-                        case JVARTYPE_INT32:
-                            *pVal = pValue->var.val.l;
-                            break;
-
-                        case JVARTYPE_UINT64:
-                            *pVal = pValue->var.val.ull;
-                            break;
-
-                        case JVARTYPE_INT64:
-                            *pVal = pValue->var.val.ll;
-                            break;
-
-                        default:
-                            result = -1;
-                            break;
-                    }
-                }
-            }
-
-            /* move to the next attribute in the object */
-            pNode = pNode->pNext;
+            pObject->pIndex->slots[i].pNode = pNew;
         }
     }
-
-    return result;
 }
 
 /*============================================================================*/
-/*  JSON_GetVar                                                               */
+/*  json_IndexBuild                                                           */
 /*!
-    Get a variable object value attribute from the specified node
-
-    The JSON_GetVar function checks that the specified node is a JSON object,
-    and looks up the object attribute with the specified name and
-    returns the variable object associated with that name.
-    Note that the variable object returned is a reference to the JSON object
-    value and should not be modified by the caller.
+    Build a JSON object index
 
-    @param[in]
-        pNode
-            pointer to the JSON object to get the value from
+    The json_IndexBuild function (re)builds the hash index of a JSON
+    object from its member list, sized so that it is at most a quarter
+    full.
 
     @param[in]
-        name
-            pointer to the name of the JSON object attribute to search for
+        pObject
+            pointer to the JSON object
 
-    @retval pointer to the VarObject associated with the specified name
-    @retval NULL if the VarObject was not found
+    @retval EOK the index was built
+    @retval ENOMEM memory allocation failure
 
 ==============================================================================*/
-JVarObject *JSON_GetVar( JNode *pNode, char *name )
+int json_IndexBuild( JObject *pObject )
 {
-    JObject *pObject;
-    JVar *pValue;
-    int result = -1;
-    JVarObject *pVar = NULL;
+    int result = ENOMEM;
+    JObjectIndex *pIndex;
+    JNode *pNode;
+    size_t size = JSON_INDEX_MIN_SIZE;
 
-    /* check that the node is an object */
-    if ( ( pNode != NULL ) &&
-         ( pNode->type == JSON_OBJECT ) &&
-         ( name != NULL ) )
+    while( size < ( pObject->n * 4 ) )
     {
-        /* get a pointer to the first attribute of the object */
-        pObject = (JObject *)pNode;
-        pNode = pObject->pFirst;
-        while( pNode != NULL )
-        {
-            if( strcmp( pNode->name, name ) == 0 )
-            {
-                if( pNode->type == JSON_VAR )
-                {
-                    pValue = (JVar *)pNode;
-                    pVar = &(pValue->var);
-                    break;
-                }
-            }
+        size <<= 1;
+    }
 
-            /* move to the next attribute in the object */
-            pNode = pNode->pNext;
+    pIndex = calloc( 1, sizeof( JObjectIndex ) +
+                        ( size * sizeof( JObjectIndexSlot ) ) );
+    if( pIndex != NULL )
+    {
+        pIndex->size = size;
+
+        for( pNode = pObject->pFirst; pNode != NULL; pNode = pNode->pNext )
+        {
+            json_IndexInsert( pIndex, pNode );
         }
+
+        free( pObject->pIndex );
+        pObject->pIndex = pIndex;
+
+        result = EOK;
     }
 
-    return pVar;
+    return result;
 }
 
 /*============================================================================*/
-/*  JSON_GetFloat                                                             */
+/*  json_IndexInsert                                                          */
 /*!
-    Get a floating point value attribute from the specified node
+    Insert a member into a JSON object index
 
-    The JSON_GetFloat function checks that the specified node is a JSON object,
-    and looks up the object attribute with the specified name and
-    returns the floating point value associated with the name.
-
-    @param[in]
-        pNode
-            pointer to the JSON object to get the value from
+    The json_IndexInsert function inserts a member at the end of its
+    probe sequence, so members with the same name are found in the
+    order they were added.  The index must have a free slot.
 
     @param[in]
-        name
-            pointer to the name of the JSON object attribute to search for
+        pIndex
+            pointer to the object index
 
     @param[in]
-        pVal
-            pointer to a location to store the retrieved value
-
-    @retval 0 the number was found and returned
-    @retval -1 the number could not be retrieved
+        pNode
+            pointer to the member to insert
 
 ==============================================================================*/
-int JSON_GetFloat( JNode *pNode, char *name, float *pVal )
+static void json_IndexInsert( JObjectIndex *pIndex, JNode *pNode )
 {
-    JObject *pObject;
-    JVar *pValue;
-    int result = -1;
+    uint32_t hash;
+    size_t mask = pIndex->size - 1;
+    size_t i;
 
-    /* check that the node is an object */
-    if ( ( pNode != NULL ) &&
-         ( pNode->type == JSON_OBJECT ) &&
-         ( name != NULL ) &&
-         ( pVal != NULL ) )
+    if( pNode->name != NULL )
     {
-        /* get a pointer to the first attribute of the object */
-        pObject = (JObject *)pNode;
-        pNode = pObject->pFirst;
-        while( pNode != NULL )
+        hash = (uint32_t)json_HashStr( pNode->name );
+        for( i = hash & mask;
+             pIndex->slots[i].pNode != NULL;
+             i = ( i + 1 ) & mask )
         {
-            if( strcmp( pNode->name, name ) == 0 )
-            {
-                if( pNode->type == JSON_VAR )
-                {
-                    pValue = (JVar *)pNode;
-                    if( pValue->var.type == JVARTYPE_FLOAT )
-                    {
-                        *pVal = pValue->var.val.f;
-                        result = 0;
-                        break;
-                    }
-                }
-            }
-
-            /* move to the next attribute in the object */
-            pNode = pNode->pNext;
         }
-    }
 
-    return result;
+        pIndex->slots[i].hash = hash;
+        pIndex->slots[i].pNode = pNode;
+        pIndex->count++;
+    }
 }
 
 /*============================================================================*/
-/*  JSON_GetArraySize                                                         */
+/*  json_IndexSlot                                                            */
 /*!
-    Get the length of the JSON Array
+    Find the index slot of a JSON object member
 
-    The JSON_GetArraySize function returns the length of the JSON array.
+    @param[in]
+        pIndex
+            pointer to the object index
 
     @param[in]
-        pArray
-            pointer to the JSON array object
+        pNode
+            pointer to the member
 
-    @retval -1 the input pointer does not point to a JSON Array
-    @retval the size of the JSON array
+    @retval position of the member's slot
+    @retval the index size if the member is not in the index
 
 ==============================================================================*/
-int JSON_GetArraySize( JArray *pArray )
+static size_t json_IndexSlot( JObjectIndex *pIndex, JNode *pNode )
 {
-    int n = -1;
+    size_t result = pIndex->size;
+    size_t mask = pIndex->size - 1;
+    size_t i;
 
-    if ( pArray != NULL )
+    if( pNode->name != NULL )
     {
-        if( pArray->node.type == JSON_ARRAY )
+        for( i = (uint32_t)json_HashStr( pNode->name ) & mask;
+             pIndex->slots[i].pNode != NULL;
+             i = ( i + 1 ) & mask )
         {
-            n = pArray->n;
+            if( pIndex->slots[i].pNode == pNode )
+            {
+                result = i;
+                break;
+            }
         }
     }
 
-    return n;
+    return result;
 }
@@ -0,0 +1,959 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+/*! default size of an arena block */
+#define JSON_ARENA_BLOCK_SIZE   ( 64 * 1024 )
+
+/*! alignment of arena allocations */
+#define JSON_ARENA_ALIGN        ( sizeof( uint64_t ) )
+
+/*! round a size up to the arena alignment */
+#define JSON_ARENA_ROUND( n ) \
+    ( ( (n) + JSON_ARENA_ALIGN - 1 ) & ~( JSON_ARENA_ALIGN - 1 ) )
+
+/*! smallest object which gets a sorted key table in a sorted clone */
+#define JSON_KEYS_MIN           ( 8 )
+
+/*! offset of the root node of a document arena from the arena */
+#define JSON_ARENA_ROOT_OFFSET \
+    ( JSON_ARENA_ROUND( sizeof( JArena ) ) + \
+      JSON_ARENA_ROUND( sizeof( JArenaBlock ) ) )
+
+/*! size of the sorted key table of an object with n members */
+#define JSON_KEYS_SIZE( n ) \
+    JSON_ARENA_ROUND( sizeof( struct _JObjectKeys ) + \
+                      ( (n) * sizeof( JObjectKey ) ) )
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! arena block header, followed by the block's storage */
+typedef struct _JArenaBlock
+{
+    /*! previously allocated block */
+    struct _JArenaBlock *pNext;
+
+    /*! size of the block's storage */
+    size_t size;
+
+    /*! number of bytes of the block's storage in use */
+    size_t used;
+
+} JArenaBlock;
+
+/*! memory arena */
+struct _JArena
+{
+    /*! size of a regular arena block */
+    size_t blockSize;
+
+    /*! most recently allocated block */
+    JArenaBlock *pBlocks;
+
+    /*! first block of a document arena, which is allocated together
+        with the arena, or NULL */
+    JArenaBlock *pFirst;
+};
+
+/*! sorted key table entry */
+typedef struct _JObjectKey
+{
+    /*! hash of the member name */
+    uint32_t hash;
+
+    /*! length of the member name */
+    uint32_t len;
+
+    /*! pointer to the member */
+    JNode *pNode;
+
+} JObjectKey;
+
+/*! key table of a frozen JSON object, sorted by name hash and then by
+    member position */
+struct _JObjectKeys
+{
+    /*! number of entries in the table */
+    size_t n;
+
+    /*! sorted entries */
+    JObjectKey keys[];
+};
+
+/*! output positions used while cloning into a single allocation */
+typedef struct _JCloneCursor
+{
+    /*! next free location for a node */
+    char *pNodes;
+
+    /*! next free location for a sorted key table, or NULL if the
+        clone is not sorted */
+    char *pKeys;
+
+    /*! next free location for a name or string */
+    char *pStrings;
+
+} JCloneCursor;
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static JNode *json_Clone( JNode *pNode, JArena *pArena, bool sorted );
+void *json_ArenaAlloc( JArena *pArena, size_t size );
+JArena *json_ArenaDocument( size_t size, size_t blockSize );
+JNode *json_ArenaDocumentRoot( JArena *pArena, JNode *pRoot );
+void json_ArenaDocumentFree( JNode *pRoot );
+size_t json_ArenaUsed( JArena *pArena, size_t *pBlocks );
+static size_t json_CloneSize( JNode *pNode, size_t *pStrings, size_t *pKeys );
+static size_t json_CloneNodeSize( JNode *pNode );
+static JNode *json_CloneNode( JNode *pNode, JCloneCursor *pCursor );
+static char *json_CloneStr( char *str, JCloneCursor *pCursor );
+static void json_CloneKeys( JObject *pObject, JCloneCursor *pCursor );
+static int json_KeyCompare( const void *a, const void *b );
+static uint32_t json_KeyHash( char *str, uint32_t *pLen );
+JNode *json_KeysFind( struct _JObjectKeys *pKeys, char *name );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_ArenaCreate                                                        */
+/*!
+    Create a memory arena
+
+    The JSON_ArenaCreate function creates a memory arena from which
+    JSON objects can be allocated by bumping a pointer through large
+    blocks.  Everything allocated from the arena is freed at once by
+    JSON_ArenaDestroy.  An arena must not be used by more than one
+    thread at a time.
+
+    @param[in]
+        blockSize
+            size of each arena block, or 0 for the default size
+
+    @retval pointer to the new arena
+    @retval NULL memory allocation failure
+
+============================================================================*/
+JArena *JSON_ArenaCreate( size_t blockSize )
+{
+    JArena *pArena;
+
+    pArena = calloc( 1, sizeof( JArena ) );
+    if( pArena != NULL )
+    {
+        pArena->blockSize = ( blockSize > 0 ) ? blockSize
+                                              : JSON_ARENA_BLOCK_SIZE;
+    }
+
+    return pArena;
+}
+
+/*==========================================================================*/
+/*  JSON_ArenaDestroy                                                       */
+/*!
+    Destroy a memory arena
+
+    The JSON_ArenaDestroy function frees the arena and every JSON object
+    which was allocated from it.
+
+    @param[in]
+        pArena
+            pointer to the arena to destroy
+
+============================================================================*/
+void JSON_ArenaDestroy( JArena *pArena )
+{
+    JArenaBlock *pBlock;
+
+    if( pArena != NULL )
+    {
+        while( pArena->pBlocks != NULL )
+        {
+            pBlock = pArena->pBlocks;
+            pArena->pBlocks = pBlock->pNext;
+            if( pBlock != pArena->pFirst )
+            {
+                free( pBlock );
+            }
+        }
+
+        free( pArena );
+    }
+}
+
+/*==========================================================================*/
+/*  JSON_Clone                                                              */
+/*!
+    Make a deep copy of a JSON object
+
+    The JSON_Clone function copies a JSON object and all of its children,
+    names and strings included, into one contiguous region of memory.
+    The size of the copy is computed first, so the whole copy takes a
+    single allocation.  Nodes are laid out in depth first order followed
+    by their names and strings, so traversing the copy walks memory
+    sequentially.
+
+    If an arena is specified the copy is allocated from it and freed
+    when the arena is destroyed.  Otherwise the copy is allocated with
+    malloc and freed by a single call to JSON_Free on its root.
+
+    A clone is read-only: its nodes cannot be individually freed or
+    modified, and nothing can be added to its containers.  Only its root
+    may be retained with JSON_Retain.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to copy
+
+    @param[in]
+        pArena
+            pointer to the arena to allocate the copy from, or NULL
+
+    @retval pointer to the copy
+    @retval NULL invalid arguments or memory allocation failure
+
+============================================================================*/
+JNode *JSON_Clone( JNode *pNode, JArena *pArena )
+{
+    return json_Clone( pNode, pArena, false );
+}
+
+/*==========================================================================*/
+/*  JSON_CloneSorted                                                        */
+/*!
+    Make a deep copy of a JSON object with sorted key tables
+
+    The JSON_CloneSorted function makes the same read-only copy of a
+    JSON object as JSON_Clone, and also gives every object in the copy
+    with at least JSON_KEYS_MIN members a table of its member names
+    sorted by hash.  JSON_Attribute, and the getters which use it, look
+    members of these objects up with a branchless binary search of the
+    table instead of scanning the members.  The member list itself is
+    not reordered, so the copy is still output in its original order.
+
+    The tables are stored in the copy's allocation, between its nodes
+    and its strings.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to copy
+
+    @param[in]
+        pArena
+            pointer to the arena to allocate the copy from, or NULL
+
+    @retval pointer to the copy
+    @retval NULL invalid arguments or memory allocation failure
+
+============================================================================*/
+JNode *JSON_CloneSorted( JNode *pNode, JArena *pArena )
+{
+    return json_Clone( pNode, pArena, true );
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_Clone                                                              */
+/*!
+    Make a deep copy of a JSON object
+
+    The json_Clone function sizes and copies a JSON object for
+    JSON_Clone and JSON_CloneSorted.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to copy
+
+    @param[in]
+        pArena
+            pointer to the arena to allocate the copy from, or NULL
+
+    @param[in]
+        sorted
+            true to build sorted key tables for the copied objects
+
+    @retval pointer to the copy
+    @retval NULL invalid arguments or memory allocation failure
+
+============================================================================*/
+static JNode *json_Clone( JNode *pNode, JArena *pArena, bool sorted )
+{
+    JNode *pClone = NULL;
+    JCloneCursor cursor;
+    size_t nodes;
+    size_t keys = 0;
+    size_t strings = 0;
+    size_t size;
+    char *block;
+
+    if( pNode != NULL )
+    {
+        nodes = json_CloneSize( pNode,
+                                &strings,
+                                ( sorted == true ) ? &keys : NULL );
+        size = nodes + keys + strings;
+
+        block = ( pArena != NULL ) ? json_ArenaAlloc( pArena, size )
+                                   : malloc( size );
+        if( block != NULL )
+        {
+            cursor.pNodes = block;
+            cursor.pKeys = ( sorted == true ) ? block + nodes : NULL;
+            cursor.pStrings = block + nodes + keys;
+
+            pClone = json_CloneNode( pNode, &cursor );
+            if( pArena == NULL )
+            {
+                pClone->flags |= JSON_NODE_BLOCK;
+            }
+        }
+    }
+
+    return pClone;
+}
+
+/*==========================================================================*/
+/*  json_ArenaAlloc                                                         */
+/*!
+    Allocate memory from an arena
+
+    The json_ArenaAlloc function allocates aligned memory from the
+    current arena block, starting a new block when it is full.  Requests
+    larger than the block size get a block of their own.
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+    @param[in]
+        size
+            number of bytes to allocate
+
+    @retval pointer to the allocated memory
+    @retval NULL memory allocation failure
+
+============================================================================*/
+void *json_ArenaAlloc( JArena *pArena, size_t size )
+{
+    void *p = NULL;
+    JArenaBlock *pBlock = pArena->pBlocks;
+    size_t blockSize;
+
+    size = JSON_ARENA_ROUND( size );
+
+    if( ( pBlock == NULL ) ||
+        ( ( pBlock->size - pBlock->used ) < size ) )
+    {
+        blockSize = ( size > pArena->blockSize ) ? size : pArena->blockSize;
+        pBlock = malloc( JSON_ARENA_ROUND( sizeof( JArenaBlock ) ) +
+                         blockSize );
+        if( pBlock != NULL )
+        {
+            pBlock->size = blockSize;
+            pBlock->used = 0;
+            pBlock->pNext = pArena->pBlocks;
+            pArena->pBlocks = pBlock;
+        }
+    }
+
+    if( pBlock != NULL )
+    {
+        p = (char *)pBlock + JSON_ARENA_ROUND( sizeof( JArenaBlock ) ) +
+            pBlock->used;
+        pBlock->used += size;
+    }
+
+    return p;
+}
+
+/*==========================================================================*/
+/*  json_ArenaDocument                                                      */
+/*!
+    Create the arena for a parsed document
+
+    The json_ArenaDocument function creates an arena for a document
+    being parsed, whose first block is allocated together with the
+    arena, so a document which fits in it costs a single allocation.
+    Space for the document's root node is reserved at the start of the
+    first block.
+
+    @param[in]
+        size
+            size of the first block
+
+    @param[in]
+        blockSize
+            size of the overflow blocks
+
+    @retval pointer to the new arena
+    @retval NULL memory allocation failure
+
+============================================================================*/
+JArena *json_ArenaDocument( size_t size, size_t blockSize )
+{
+    JArena *pArena;
+    JArenaBlock *pBlock;
+    size_t root = JSON_ARENA_ROUND( sizeof( JObject ) );
+
+    size = JSON_ARENA_ROUND( size );
+    if( size < root )
+    {
+        size = root;
+    }
+
+    pArena = malloc( JSON_ARENA_ROOT_OFFSET + size );
+    if( pArena != NULL )
+    {
+        pBlock = (JArenaBlock *)( (char *)pArena +
+                                  JSON_ARENA_ROUND( sizeof( JArena ) ) );
+        pBlock->pNext = NULL;
+        pBlock->size = size;
+        pBlock->used = root;
+
+        pArena->blockSize = blockSize;
+        pArena->pBlocks = pBlock;
+        pArena->pFirst = pBlock;
+    }
+
+    return pArena;
+}
+
+/*==========================================================================*/
+/*  json_ArenaDocumentRoot                                                  */
+/*!
+    Install the root node of a parsed document
+
+    The json_ArenaDocumentRoot function moves the root node of a parsed
+    document into the space reserved for it at the start of the
+    document's arena, so that freeing the root can find the arena.
+    Nothing points at the root node, so it can be moved with a copy.
+
+    @param[in]
+        pArena
+            pointer to the document arena
+
+    @param[in]
+        pRoot
+            pointer to the root node, allocated from the arena
+
+    @retval pointer to the relocated root node
+
+============================================================================*/
+JNode *json_ArenaDocumentRoot( JArena *pArena, JNode *pRoot )
+{
+    JNode *pNode = (JNode *)( (char *)pArena + JSON_ARENA_ROOT_OFFSET );
+    size_t size;
+
+    switch( pRoot->type )
+    {
+        case JSON_OBJECT:
+            size = sizeof( JObject );
+            break;
+
+        case JSON_ARRAY:
+            size = sizeof( JArray );
+            break;
+
+        default:
+            size = sizeof( JVar );
+            break;
+    }
+
+    memcpy( pNode, pRoot, size );
+    pNode->flags |= JSON_NODE_DOCUMENT;
+
+    return pNode;
+}
+
+/*==========================================================================*/
+/*  json_ArenaDocumentFree                                                  */
+/*!
+    Free a parsed document and its arena
+
+    @param[in]
+        pRoot
+            pointer to the root node of a document parsed into an arena
+
+============================================================================*/
+void json_ArenaDocumentFree( JNode *pRoot )
+{
+    JSON_ArenaDestroy( (JArena *)( (char *)pRoot - JSON_ARENA_ROOT_OFFSET ) );
+}
+
+/*==========================================================================*/
+/*  json_ArenaUsed                                                          */
+/*!
+    Get the number of bytes allocated from an arena
+
+    @param[in]
+        pArena
+            pointer to the arena
+
+    @param[out]
+        pBlocks
+            pointer to a location to store the number of arena blocks
+
+    @retval number of bytes allocated from the arena
+
+============================================================================*/
+size_t json_ArenaUsed( JArena *pArena, size_t *pBlocks )
+{
+    JArenaBlock *pBlock;
+    size_t used = 0;
+
+    *pBlocks = 0;
+    for( pBlock = pArena->pBlocks; pBlock != NULL; pBlock = pBlock->pNext )
+    {
+        used += pBlock->used;
+        (*pBlocks)++;
+    }
+
+    return used;
+}
+
+/*==========================================================================*/
+/*  json_CloneSize                                                          */
+/*!
+    Compute the size of a clone
+
+    The json_CloneSize function computes the number of bytes needed to
+    copy a JSON object and its children.
+
+    @param[in]
+        pNode
+            pointer to the JSON object
+
+    @param[in,out]
+        pStrings
+            running total of the bytes needed for names and strings
+
+    @param[in,out]
+        pKeys
+            running total of the bytes needed for sorted key tables,
+            or NULL if the clone is not sorted
+
+    @retval number of bytes needed for the nodes
+
+============================================================================*/
+static size_t json_CloneSize( JNode *pNode, size_t *pStrings, size_t *pKeys )
+{
+    size_t size = json_CloneNodeSize( pNode );
+    JNode *pChild;
+    JVar *pVar;
+
+    if( pNode->name != NULL )
+    {
+        *pStrings += strlen( pNode->name ) + 1;
+    }
+
+    switch( pNode->type )
+    {
+        case JSON_OBJECT:
+        case JSON_ARRAY:
+            if( ( pKeys != NULL ) &&
+                ( pNode->type == JSON_OBJECT ) &&
+                ( ((JObject *)pNode)->n >= JSON_KEYS_MIN ) )
+            {
+                *pKeys += JSON_KEYS_SIZE( ((JObject *)pNode)->n );
+            }
+
+            pChild = ((JObject *)pNode)->pFirst;
+            while( pChild != NULL )
+            {
+                size += json_CloneSize( pChild, pStrings, pKeys );
+                pChild = pChild->pNext;
+            }
+            break;
+
+        case JSON_VAR:
+            pVar = (JVar *)pNode;
+            if( ( pVar->var.type == JVARTYPE_STR ) &&
+                ( pVar->var.val.str != NULL ) )
+            {
+                *pStrings += strlen( pVar->var.val.str ) + 1;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return size;
+}
+
+/*==========================================================================*/
+/*  json_CloneNodeSize                                                      */
+/*!
+    Get the size of a single JSON node
+
+    @param[in]
+        pNode
+            pointer to the JSON node
+
+    @retval size of the node's structure, rounded to the arena alignment
+
+============================================================================*/
+static size_t json_CloneNodeSize( JNode *pNode )
+{
+    size_t size;
+
+    switch( pNode->type )
+    {
+        case JSON_OBJECT:
+            size = sizeof( JObject );
+            break;
+
+        case JSON_ARRAY:
+            size = sizeof( JArray );
+            break;
+
+        default:
+            size = sizeof( JVar );
+            break;
+    }
+
+    return JSON_ARENA_ROUND( size );
+}
+
+/*==========================================================================*/
+/*  json_CloneNode                                                          */
+/*!
+    Copy a JSON object into pre-sized storage
+
+    The json_CloneNode function copies a JSON object and its children
+    depth first into the storage described by the clone cursor.
+
+    @param[in]
+        pNode
+            pointer to the JSON object to copy
+
+    @param[in,out]
+        pCursor
+            pointer to the clone cursor
+
+    @retval pointer to the copy
+
+============================================================================*/
+static JNode *json_CloneNode( JNode *pNode, JCloneCursor *pCursor )
+{
+    JNode *pClone = (JNode *)pCursor->pNodes;
+    JObject *pSrc;
+    JObject *pDst;
+    JNode *pChild;
+    JNode *pChildClone;
+    JVar *pVar;
+
+    pCursor->pNodes += json_CloneNodeSize( pNode );
+
+    memset( pClone, 0, json_CloneNodeSize( pNode ) );
+    pClone->type = pNode->type;
+    pClone->flags = JSON_NODE_ARENA;
+    pClone->name = json_CloneStr( pNode->name, pCursor );
+
+    switch( pNode->type )
+    {
+        case JSON_OBJECT:
+        case JSON_ARRAY:
+            pSrc = (JObject *)pNode;
+            pDst = (JObject *)pClone;
+            pDst->n = pSrc->n;
+            pDst->hash = pSrc->hash;
+            pDst->hashEpoch = pSrc->hashEpoch;
+
+            pChild = pSrc->pFirst;
+            while( pChild != NULL )
+            {
+                pChildClone = json_CloneNode( pChild, pCursor );
+                pChildClone->pPrev = pDst->pLast;
+                if( pDst->pLast == NULL )
+                {
+                    pDst->pFirst = pChildClone;
+                }
+                else
+                {
+                    pDst->pLast->pNext = pChildClone;
+                }
+
+                pDst->pLast = pChildClone;
+                pChild = pChild->pNext;
+            }
+
+            if( ( pCursor->pKeys != NULL ) &&
+                ( pNode->type == JSON_OBJECT ) &&
+                ( pDst->n >= JSON_KEYS_MIN ) )
+            {
+                json_CloneKeys( pDst, pCursor );
+            }
+            break;
+
+        case JSON_NULL:
+        case JSON_BOOL:
+        case JSON_VAR:
+            pVar = (JVar *)pClone;
+            pVar->var = ((JVar *)pNode)->var;
+            if( pVar->var.type == JVARTYPE_STR )
+            {
+                pVar->var.val.str = json_CloneStr( pVar->var.val.str,
+                                                   pCursor );
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return pClone;
+}
+
+/*==========================================================================*/
+/*  json_CloneStr                                                           */
+/*!
+    Copy a string into pre-sized storage
+
+    @param[in]
+        str
+            pointer to the NUL terminated string to copy, or NULL
+
+    @param[in,out]
+        pCursor
+            pointer to the clone cursor
+
+    @retval pointer to the copy
+    @retval NULL if str is NULL
+
+============================================================================*/
+static char *json_CloneStr( char *str, JCloneCursor *pCursor )
+{
+    char *copy = NULL;
+    size_t len;
+
+    if( str != NULL )
+    {
+        len = strlen( str ) + 1;
+        copy = memcpy( pCursor->pStrings, str, len );
+        pCursor->pStrings += len;
+    }
+
+    return copy;
+}
+
+/*==========================================================================*/
+/*  json_CloneKeys                                                          */
+/*!
+    Build the sorted key table of a copied object
+
+    The json_CloneKeys function builds the sorted key table of an object
+    in a sorted clone, once all of its members have been copied.  The
+    members of a clone are laid out in order, so sorting the entries by
+    hash and then by member address keeps members with the same name in
+    their original order.
+
+    @param[in]
+        pObject
+            pointer to the copied object
+
+    @param[in,out]
+        pCursor
+            pointer to the clone cursor
+
+============================================================================*/
+static void json_CloneKeys( JObject *pObject, JCloneCursor *pCursor )
+{
+    struct _JObjectKeys *pKeys = (struct _JObjectKeys *)pCursor->pKeys;
+    JNode *pNode;
+    size_t n = 0;
+
+    for( pNode = pObject->pFirst; pNode != NULL; pNode = pNode->pNext )
+    {
+        pKeys->keys[n].hash = json_KeyHash( ( pNode->name != NULL )
+                                              ? pNode->name
+                                              : "",
+                                            &pKeys->keys[n].len );
+        pKeys->keys[n].pNode = pNode;
+        n++;
+    }
+
+    pKeys->n = n;
+    qsort( pKeys->keys, n, sizeof( JObjectKey ), json_KeyCompare );
+
+    pObject->pKeys = pKeys;
+    pCursor->pKeys += JSON_KEYS_SIZE( n );
+}
+
+/*==========================================================================*/
+/*  json_KeyCompare                                                         */
+/*!
+    Compare two sorted key table entries
+
+    @param[in]
+        a
+            pointer to the first JObjectKey
+
+    @param[in]
+        b
+            pointer to the second JObjectKey
+
+    @retval <0 a sorts before b
+    @retval 0 a and b are the same entry
+    @retval >0 a sorts after b
+
+============================================================================*/
+static int json_KeyCompare( const void *a, const void *b )
+{
+    const JObjectKey *ka = a;
+    const JObjectKey *kb = b;
+    int result;
+
+    if( ka->hash != kb->hash )
+    {
+        result = ( ka->hash < kb->hash ) ? -1 : 1;
+    }
+    else if( ka->pNode != kb->pNode )
+    {
+        result = ( ka->pNode < kb->pNode ) ? -1 : 1;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_KeyHash                                                            */
+/*!
+    Hash a member name
+
+    The json_KeyHash function computes the 32-bit FNV-1a hash of a
+    member name, and its length, in a single pass.
+
+    @param[in]
+        str
+            pointer to the NUL terminated name
+
+    @param[out]
+        pLen
+            pointer to a location to store the length of the name
+
+    @retval hash of the name
+
+============================================================================*/
+static uint32_t json_KeyHash( char *str, uint32_t *pLen )
+{
+    uint32_t hash = 2166136261u;
+    uint32_t len = 0;
+
+    while( str[len] != '\0' )
+    {
+        hash = ( hash ^ (uint8_t)str[len] ) * 16777619u;
+        len++;
+    }
+
+    *pLen = len;
+
+    return hash;
+}
+
+/*==========================================================================*/
+/*  json_KeysFind                                                           */
+/*!
+    Look up a member in a sorted key table
+
+    The json_KeysFind function finds the first member of a frozen
+    object with the specified name.  The first entry with the name's
+    hash is found with a branchless binary search: each step halves
+    the range with a conditional add rather than a branch, so the
+    search runs in a fixed number of steps without mispredictions.
+    The entries with that hash are then checked in order.
+
+    @param[in]
+        pKeys
+            pointer to the sorted key table
+
+    @param[in]
+        name
+            name of the member to find
+
+    @retval pointer to the member
+    @retval NULL the object has no member with the specified name
+
+============================================================================*/
+JNode *json_KeysFind( struct _JObjectKeys *pKeys, char *name )
+{
+    JNode *pNode = NULL;
+    JObjectKey *pKey = pKeys->keys;
+    JObjectKey *pEnd = pKeys->keys + pKeys->n;
+    size_t n = pKeys->n;
+    size_t half;
+    uint32_t hash;
+    uint32_t len;
+
+    hash = json_KeyHash( name, &len );
+
+    while( n > 0 )
+    {
+        half = n / 2;
+        pKey += ( pKey[half].hash < hash ) ? ( n - half ) : 0;
+        n = half;
+    }
+
+    while( ( pKey < pEnd ) && ( pKey->hash == hash ) )
+    {
+        if( ( pKey->len == len ) &&
+            ( pKey->pNode->name != NULL ) &&
+            ( memcmp( pKey->pNode->name, name, len ) == 0 ) )
+        {
+            pNode = pKey->pNode;
+            break;
+        }
+
+        pKey++;
+    }
+
+    return pNode;
+}
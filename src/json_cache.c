@@ -0,0 +1,684 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! parse cache entry */
+typedef struct _JCacheEntry
+{
+    /*! hash of the input bytes */
+    uint64_t hash;
+
+    /*! length of the input */
+    size_t len;
+
+    /*! copy of the input, used to confirm a hash match */
+    char *buf;
+
+    /*! parsed document, retained by the cache */
+    JNode *pNode;
+
+    /*! more recently used entry */
+    struct _JCacheEntry *pPrev;
+
+    /*! less recently used entry */
+    struct _JCacheEntry *pNext;
+
+    /*! next entry in the same content hash bucket */
+    struct _JCacheEntry *pNextHash;
+
+} JCacheEntry;
+
+/*! content addressed parse cache */
+struct _JParseCache
+{
+    /*! mutex protecting the cache */
+    pthread_mutex_t mutex;
+
+    /*! maximum number of cached documents */
+    size_t maxEntries;
+
+    /*! maximum number of cached input bytes */
+    size_t maxBytes;
+
+    /*! number of buckets in the hash table (a power of 2) */
+    size_t nBuckets;
+
+    /*! entries hashed by input content */
+    JCacheEntry **byHash;
+
+    /*! most recently used entry */
+    JCacheEntry *pHead;
+
+    /*! least recently used entry */
+    JCacheEntry *pTail;
+
+    /*! cache statistics */
+    JParseCacheStats stats;
+};
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static JCacheEntry *json_CacheLookup( JParseCache *pCache,
+                                      uint64_t hash,
+                                      char *buf,
+                                      size_t len );
+static int json_CacheInsert( JParseCache *pCache, JCacheEntry *pEntry );
+static void json_CacheEvict( JParseCache *pCache );
+static void json_CacheUnlinkLRU( JParseCache *pCache, JCacheEntry *pEntry );
+static void json_CacheUnlinkHash( JParseCache *pCache, JCacheEntry *pEntry );
+static void json_CacheFreeEntry( JParseCache *pCache, JCacheEntry *pEntry );
+static uint64_t json_CacheHash( const char *buf, size_t len );
+static uint64_t json_CacheMix( uint64_t x );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_CacheCreate                                                        */
+/*!
+    Create a content addressed parse cache
+
+    The JSON_CacheCreate function creates a cache which sits in front of
+    JSON_ProcessBuffer.  Inputs are identified by a hash of their bytes,
+    so byte-identical inputs are parsed once and then shared.  The cache
+    holds at most maxEntries documents and maxBytes bytes of input, and
+    evicts the least recently used documents when either limit is
+    exceeded.
+
+    @param[in]
+        maxEntries
+            maximum number of cached documents
+
+    @param[in]
+        maxBytes
+            maximum total size of the cached inputs, or 0 for no limit
+
+    @retval pointer to the new parse cache
+    @retval NULL invalid arguments or memory allocation failure
+
+============================================================================*/
+JParseCache *JSON_CacheCreate( size_t maxEntries, size_t maxBytes )
+{
+    JParseCache *pCache = NULL;
+    size_t nBuckets = 1;
+
+    if( maxEntries > 0 )
+    {
+        pCache = calloc( 1, sizeof( JParseCache ) );
+        if( pCache != NULL )
+        {
+            while( nBuckets < maxEntries )
+            {
+                nBuckets <<= 1;
+            }
+
+            pCache->maxEntries = maxEntries;
+            pCache->maxBytes = maxBytes;
+            pCache->nBuckets = nBuckets;
+            pCache->byHash = calloc( nBuckets, sizeof( JCacheEntry * ) );
+            if( pCache->byHash != NULL )
+            {
+                pthread_mutex_init( &pCache->mutex, NULL );
+            }
+            else
+            {
+                free( pCache );
+                pCache = NULL;
+            }
+        }
+    }
+
+    return pCache;
+}
+
+/*==========================================================================*/
+/*  JSON_CacheProcessBuffer                                                 */
+/*!
+    Process a JSON object from a string buffer through a parse cache
+
+    The JSON_CacheProcessBuffer function hashes the input buffer and, if
+    a byte-identical input has been parsed before and is still cached,
+    returns a new reference to the previously parsed document without
+    parsing it again.  Otherwise the buffer is parsed using
+    JSON_ProcessBuffer and a read-only copy of the result (see
+    JSON_Clone) is added to the cache.
+
+    The returned document is shared (see JSON_Retain) and read-only, so
+    the functions which modify a document fail on it with EPERM.  The
+    caller's reference must be released with JSON_Release.
+    Evicting a document from the cache releases the cache's reference, so
+    documents still in use remain valid until their last release.
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+    @param[in]
+        buf
+            pointer to the NUL terminated input buffer
+
+    @retval pointer to the shared parsed JSON object
+    @retval NULL if the JSON object is invalid
+
+============================================================================*/
+JNode *JSON_CacheProcessBuffer( JParseCache *pCache, char *buf )
+{
+    JNode *pNode = NULL;
+    JCacheEntry *pEntry;
+    JCacheEntry *pNew = NULL;
+    JNode *pParsed;
+    uint64_t hash;
+    size_t len;
+
+    if( ( pCache != NULL ) &&
+        ( buf != NULL ) )
+    {
+        len = strlen( buf );
+        hash = json_CacheHash( buf, len );
+
+        pthread_mutex_lock( &pCache->mutex );
+
+        pEntry = json_CacheLookup( pCache, hash, buf, len );
+        if( pEntry != NULL )
+        {
+            pNode = JSON_Retain( pEntry->pNode );
+            pCache->stats.hits++;
+        }
+        else
+        {
+            pCache->stats.misses++;
+        }
+
+        pthread_mutex_unlock( &pCache->mutex );
+
+        if( pNode == NULL )
+        {
+            /* parse outside of the cache lock */
+            pNew = calloc( 1, sizeof( JCacheEntry ) );
+            if( pNew != NULL )
+            {
+                pNew->hash = hash;
+                pNew->len = len;
+                pNew->buf = malloc( len + 1 );
+                if( pNew->buf != NULL )
+                {
+                    memcpy( pNew->buf, buf, len + 1 );
+
+                    /* cache a read-only copy so that no caller can
+                       modify the document the others are sharing */
+                    pParsed = JSON_ProcessBuffer( buf );
+                    pNew->pNode = JSON_Clone( pParsed, NULL );
+                    JSON_Free( pParsed );
+                }
+            }
+
+            if( ( pNew != NULL ) && ( pNew->pNode != NULL ) )
+            {
+                pthread_mutex_lock( &pCache->mutex );
+
+                /* another thread may have cached the same input while
+                   we were parsing it */
+                pEntry = json_CacheLookup( pCache, hash, buf, len );
+                if( pEntry != NULL )
+                {
+                    pNode = JSON_Retain( pEntry->pNode );
+                }
+                else
+                {
+                    /* take the caller's reference before the insertion
+                       can evict the new entry */
+                    pNode = JSON_Retain( pNew->pNode );
+                    if( json_CacheInsert( pCache, pNew ) == EOK )
+                    {
+                        pNew = NULL;
+                    }
+                    else
+                    {
+                        JSON_Release( pNode );
+                        pNode = NULL;
+                    }
+                }
+
+                pthread_mutex_unlock( &pCache->mutex );
+            }
+
+            if( pNew != NULL )
+            {
+                if( pNode == NULL )
+                {
+                    /* could not cache it, so hand over the only copy */
+                    pNode = pNew->pNode;
+                    pNew->pNode = NULL;
+                }
+
+                JSON_Free( pNew->pNode );
+                free( pNew->buf );
+                free( pNew );
+            }
+        }
+    }
+
+    return pNode;
+}
+
+/*==========================================================================*/
+/*  JSON_CacheStats                                                         */
+/*!
+    Get parse cache statistics
+
+    The JSON_CacheStats function retrieves a snapshot of the hit, miss,
+    and eviction counters of the parse cache, along with its current
+    size.
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+    @param[out]
+        pStats
+            pointer to a location to store the statistics
+
+    @retval EOK the statistics were retrieved
+    @retval EINVAL invalid arguments
+
+============================================================================*/
+int JSON_CacheStats( JParseCache *pCache, JParseCacheStats *pStats )
+{
+    int result = EINVAL;
+
+    if( ( pCache != NULL ) &&
+        ( pStats != NULL ) )
+    {
+        pthread_mutex_lock( &pCache->mutex );
+        *pStats = pCache->stats;
+        pthread_mutex_unlock( &pCache->mutex );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_CacheDestroy                                                       */
+/*!
+    Destroy a parse cache
+
+    The JSON_CacheDestroy function frees the parse cache and releases
+    its references to the cached documents.  Documents still referenced
+    by their users remain valid until they are released.
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+============================================================================*/
+void JSON_CacheDestroy( JParseCache *pCache )
+{
+    if( pCache != NULL )
+    {
+        while( pCache->pHead != NULL )
+        {
+            json_CacheFreeEntry( pCache, pCache->pHead );
+        }
+
+        pthread_mutex_destroy( &pCache->mutex );
+        free( pCache->byHash );
+        free( pCache );
+    }
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_CacheLookup                                                        */
+/*!
+    Look up an input in the parse cache
+
+    The json_CacheLookup function searches the cache for an entry whose
+    input is byte-identical to the specified input.  A matching entry
+    becomes the most recently used entry.  The cache must be locked.
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+    @param[in]
+        hash
+            hash of the input
+
+    @param[in]
+        buf
+            pointer to the input
+
+    @param[in]
+        len
+            length of the input
+
+    @retval pointer to the matching entry
+    @retval NULL the input is not cached
+
+============================================================================*/
+static JCacheEntry *json_CacheLookup( JParseCache *pCache,
+                                      uint64_t hash,
+                                      char *buf,
+                                      size_t len )
+{
+    JCacheEntry *pEntry;
+
+    pEntry = pCache->byHash[hash & ( pCache->nBuckets - 1 )];
+    while( ( pEntry != NULL ) &&
+           ( ( pEntry->hash != hash ) ||
+             ( pEntry->len != len ) ||
+             ( memcmp( pEntry->buf, buf, len ) != 0 ) ) )
+    {
+        pEntry = pEntry->pNextHash;
+    }
+
+    if( ( pEntry != NULL ) &&
+        ( pEntry != pCache->pHead ) )
+    {
+        /* move to the front of the LRU list */
+        json_CacheUnlinkLRU( pCache, pEntry );
+        pEntry->pNext = pCache->pHead;
+        pCache->pHead->pPrev = pEntry;
+        pCache->pHead = pEntry;
+    }
+
+    return pEntry;
+}
+
+/*==========================================================================*/
+/*  json_CacheInsert                                                        */
+/*!
+    Insert an entry into the parse cache
+
+    The json_CacheInsert function adds a new entry as the most recently
+    used entry, and then evicts least recently used entries until the
+    cache is within its limits.  The cache must be locked.
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+    @param[in]
+        pEntry
+            pointer to the new entry
+
+    @retval EOK the entry was inserted
+    @retval E2BIG the input is larger than the cache
+
+============================================================================*/
+static int json_CacheInsert( JParseCache *pCache, JCacheEntry *pEntry )
+{
+    int result = E2BIG;
+    size_t bucket;
+
+    if( ( pCache->maxBytes == 0 ) ||
+        ( pEntry->len <= pCache->maxBytes ) )
+    {
+        bucket = pEntry->hash & ( pCache->nBuckets - 1 );
+        pEntry->pNextHash = pCache->byHash[bucket];
+        pCache->byHash[bucket] = pEntry;
+
+        pEntry->pPrev = NULL;
+        pEntry->pNext = pCache->pHead;
+        if( pCache->pHead != NULL )
+        {
+            pCache->pHead->pPrev = pEntry;
+        }
+        else
+        {
+            pCache->pTail = pEntry;
+        }
+
+        pCache->pHead = pEntry;
+
+        pCache->stats.entries++;
+        pCache->stats.bytes += pEntry->len;
+
+        json_CacheEvict( pCache );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_CacheEvict                                                         */
+/*!
+    Evict least recently used entries
+
+    The json_CacheEvict function removes least recently used entries
+    until the cache is within its entry and byte limits.  The cache must
+    be locked.
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+============================================================================*/
+static void json_CacheEvict( JParseCache *pCache )
+{
+    while( ( pCache->pTail != NULL ) &&
+           ( ( pCache->stats.entries > pCache->maxEntries ) ||
+             ( ( pCache->maxBytes != 0 ) &&
+               ( pCache->stats.bytes > pCache->maxBytes ) ) ) )
+    {
+        json_CacheFreeEntry( pCache, pCache->pTail );
+        pCache->stats.evictions++;
+    }
+}
+
+/*==========================================================================*/
+/*  json_CacheUnlinkLRU                                                     */
+/*!
+    Remove an entry from the LRU list
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+    @param[in]
+        pEntry
+            pointer to the entry to remove
+
+============================================================================*/
+static void json_CacheUnlinkLRU( JParseCache *pCache, JCacheEntry *pEntry )
+{
+    if( pEntry->pPrev != NULL )
+    {
+        pEntry->pPrev->pNext = pEntry->pNext;
+    }
+    else
+    {
+        pCache->pHead = pEntry->pNext;
+    }
+
+    if( pEntry->pNext != NULL )
+    {
+        pEntry->pNext->pPrev = pEntry->pPrev;
+    }
+    else
+    {
+        pCache->pTail = pEntry->pPrev;
+    }
+
+    pEntry->pPrev = NULL;
+    pEntry->pNext = NULL;
+}
+
+/*==========================================================================*/
+/*  json_CacheUnlinkHash                                                    */
+/*!
+    Remove an entry from the content hash table
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+    @param[in]
+        pEntry
+            pointer to the entry to remove
+
+============================================================================*/
+static void json_CacheUnlinkHash( JParseCache *pCache, JCacheEntry *pEntry )
+{
+    JCacheEntry **ppEntry;
+
+    ppEntry = &pCache->byHash[pEntry->hash & ( pCache->nBuckets - 1 )];
+    while( *ppEntry != NULL )
+    {
+        if( *ppEntry == pEntry )
+        {
+            *ppEntry = pEntry->pNextHash;
+            break;
+        }
+
+        ppEntry = &(*ppEntry)->pNextHash;
+    }
+
+    pEntry->pNextHash = NULL;
+}
+
+/*==========================================================================*/
+/*  json_CacheFreeEntry                                                     */
+/*!
+    Free a parse cache entry
+
+    The json_CacheFreeEntry function removes an entry from the cache,
+    releases the cache's reference to its document, and frees it.
+    The cache must be locked (or being destroyed).
+
+    @param[in]
+        pCache
+            pointer to the parse cache
+
+    @param[in]
+        pEntry
+            pointer to the entry to free
+
+============================================================================*/
+static void json_CacheFreeEntry( JParseCache *pCache, JCacheEntry *pEntry )
+{
+    json_CacheUnlinkLRU( pCache, pEntry );
+    json_CacheUnlinkHash( pCache, pEntry );
+    pCache->stats.entries--;
+    pCache->stats.bytes -= pEntry->len;
+
+    JSON_Release( pEntry->pNode );
+    free( pEntry->buf );
+    free( pEntry );
+}
+
+/*==========================================================================*/
+/*  json_CacheHash                                                          */
+/*!
+    Hash a buffer
+
+    The json_CacheHash function computes a 64-bit hash of a buffer,
+    consuming it eight bytes at a time so that hashing is much cheaper
+    than parsing.
+
+    @param[in]
+        buf
+            pointer to the buffer
+
+    @param[in]
+        len
+            length of the buffer
+
+    @retval hash of the buffer
+
+============================================================================*/
+static uint64_t json_CacheHash( const char *buf, size_t len )
+{
+    uint64_t hash = len * 0x9E3779B97F4A7C15ULL;
+    uint64_t word;
+    size_t i;
+
+    for( i = 0; ( i + sizeof( word ) ) <= len; i += sizeof( word ) )
+    {
+        memcpy( &word, &buf[i], sizeof( word ) );
+        hash = ( hash ^ json_CacheMix( word ) ) * 0xFF51AFD7ED558CCDULL;
+    }
+
+    word = 0;
+    memcpy( &word, &buf[i], len - i );
+    hash = ( hash ^ json_CacheMix( word ) ) * 0xFF51AFD7ED558CCDULL;
+
+    return json_CacheMix( hash );
+}
+
+/*==========================================================================*/
+/*  json_CacheMix                                                           */
+/*!
+    Mix the bits of a 64-bit value
+
+    The json_CacheMix function applies the splitmix64 finalizer.
+
+    @param[in]
+        x
+            value to mix
+
+    @retval mixed value
+
+============================================================================*/
+static uint64_t json_CacheMix( uint64_t x )
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = ( x ^ ( x >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    x = ( x ^ ( x >> 27 ) ) * 0x94D049BB133111EBULL;
+    return x ^ ( x >> 31 );
+}
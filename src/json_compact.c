@@ -0,0 +1,518 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! log2 of the smallest compacted block */
+#define JSON_COMPACT_MIN_ORDER      ( 12 )
+
+/*! log2 of the largest compacted block */
+#define JSON_COMPACT_MAX_ORDER      ( 20 )
+
+/*! position of the block size order in the flags of a compacted node */
+#define JSON_COMPACT_ORDER_SHIFT    ( 8 )
+
+/*! alignment of the nodes in a compacted block */
+#define JSON_COMPACT_ALIGN          ( sizeof( uint64_t ) )
+
+/*! round a size up to the node alignment */
+#define JSON_COMPACT_ROUND( n ) \
+    ( ( (n) + JSON_COMPACT_ALIGN - 1 ) & ~( JSON_COMPACT_ALIGN - 1 ) )
+
+/*============================================================================
+        External Functions
+============================================================================*/
+
+/*! free the storage of a JSON node */
+extern void json_FreeStorage( JNode *json, uint32_t flags );
+
+/*! replace a member in the hash index of a JSON object */
+extern void json_IndexReplace( JObject *pObject, JNode *pOld, JNode *pNew );
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! compacted block header, followed by the relocated nodes.  A block
+    of size 2^order is aligned to its size, so a node finds the start
+    of its block by masking its own address */
+typedef struct _JCompactBlock
+{
+    /*! number of nodes in the block which have not been freed */
+    uint32_t live;
+
+} JCompactBlock;
+
+/*! allocation state while compacting a document */
+typedef struct _JCompactCursor
+{
+    /*! number of bytes of nodes still to be relocated */
+    size_t remaining;
+
+    /*! block currently being filled */
+    JCompactBlock *pBlock;
+
+    /*! log2 of the size of the current block */
+    uint32_t order;
+
+    /*! next free location in the current block */
+    char *pNext;
+
+    /*! end of the current block */
+    char *pEnd;
+
+} JCompactCursor;
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static bool json_CompactMovable( JNode *pNode );
+static size_t json_CompactSize( JNode *pNode );
+static size_t json_CompactNodeSize( JNode *pNode );
+static int json_CompactChildren( JObject *pContainer,
+                                 JCompactCursor *pCursor );
+static JNode *json_CompactMove( JObject *pContainer,
+                                JNode *pNode,
+                                JCompactCursor *pCursor );
+static void *json_CompactAlloc( JCompactCursor *pCursor, size_t size );
+void json_CompactRelease( JNode *json, uint32_t flags );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_Compact                                                            */
+/*!
+    Defragment a long-lived JSON document
+
+    The JSON_Compact function relocates every node below the root of a
+    mutable JSON document into freshly allocated contiguous blocks, in
+    depth first order, so a document which has become scattered across
+    the heap by repeated updates can be traversed sequentially again.
+    The links between the nodes and the hash indexes of large objects
+    are fixed up, and the storage the nodes were moved out of is
+    released.
+
+    The root node stays where it is, so the caller's pointer to the
+    document remains valid, as does everything the nodes point to
+    (names and strings are not moved).  Pointers to nodes below the
+    root are invalidated.  The document remains fully mutable, and
+    may be compacted again later.
+
+    Nodes which other holders may refer to are left in place together
+    with their children: subtrees shared with JSON_Retain, subtrees
+    borrowed by persistent versions, and clones.
+
+    @param[in]
+        json
+            pointer to the root of the JSON document
+
+    @retval EOK the document was compacted
+    @retval EINVAL invalid arguments
+    @retval EPERM the document is shared or is part of a clone
+    @retval ENOMEM memory allocation failure.  The document is intact
+            but only partially compacted.
+
+============================================================================*/
+int JSON_Compact( JNode *json )
+{
+    int result = EINVAL;
+    JCompactCursor cursor;
+
+    if( json != NULL )
+    {
+        if( ( json->refcount != 0 ) ||
+            ( ( json->flags & ( JSON_NODE_ARENA | JSON_NODE_BLOCK ) ) != 0 ) )
+        {
+            result = EPERM;
+        }
+        else if( ( ( json->type == JSON_ARRAY ) ||
+                   ( json->type == JSON_OBJECT ) ) &&
+                 ( ((JObject *)json)->pShared == NULL ) )
+        {
+            memset( &cursor, 0, sizeof( JCompactCursor ) );
+            cursor.remaining = json_CompactSize( json ) -
+                               json_CompactNodeSize( json );
+
+            result = json_CompactChildren( (JObject *)json, &cursor );
+        }
+        else
+        {
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_CompactMovable                                                     */
+/*!
+    Check if a JSON node can be relocated
+
+    The json_CompactMovable function checks that no-one but its parent
+    refers to a JSON node, so it can be moved.
+
+    @param[in]
+        pNode
+            pointer to the JSON node
+
+    @retval true the node can be relocated
+    @retval false the node must stay where it is
+
+============================================================================*/
+static bool json_CompactMovable( JNode *pNode )
+{
+    return ( pNode->refcount == 0 ) &&
+           ( ( pNode->flags & ( JSON_NODE_ARENA | JSON_NODE_BLOCK ) ) == 0 );
+}
+
+/*==========================================================================*/
+/*  json_CompactSize                                                        */
+/*!
+    Compute the storage needed to compact a JSON node
+
+    The json_CompactSize function computes the number of bytes needed to
+    relocate a movable JSON node and the movable nodes below it.
+
+    @param[in]
+        pNode
+            pointer to the JSON node
+
+    @retval number of bytes needed
+
+============================================================================*/
+static size_t json_CompactSize( JNode *pNode )
+{
+    size_t size = 0;
+    JObject *pContainer = (JObject *)pNode;
+    JNode *pChild;
+
+    if( json_CompactMovable( pNode ) == true )
+    {
+        size = json_CompactNodeSize( pNode );
+
+        if( ( ( pNode->type == JSON_ARRAY ) ||
+              ( pNode->type == JSON_OBJECT ) ) &&
+            ( pContainer->pShared == NULL ) )
+        {
+            for( pChild = pContainer->pFirst;
+                 pChild != NULL;
+                 pChild = pChild->pNext )
+            {
+                size += json_CompactSize( pChild );
+            }
+        }
+    }
+
+    return size;
+}
+
+/*==========================================================================*/
+/*  json_CompactNodeSize                                                    */
+/*!
+    Get the size of a single JSON node
+
+    @param[in]
+        pNode
+            pointer to the JSON node
+
+    @retval size of the node's structure, rounded to the node alignment
+
+============================================================================*/
+static size_t json_CompactNodeSize( JNode *pNode )
+{
+    size_t size;
+
+    switch( pNode->type )
+    {
+        case JSON_OBJECT:
+            size = sizeof( JObject );
+            break;
+
+        case JSON_ARRAY:
+            size = sizeof( JArray );
+            break;
+
+        default:
+            size = sizeof( JVar );
+            break;
+    }
+
+    return JSON_COMPACT_ROUND( size );
+}
+
+/*==========================================================================*/
+/*  json_CompactChildren                                                    */
+/*!
+    Relocate the members of a container
+
+    The json_CompactChildren function relocates each movable member of
+    a container, followed by the members of that member, so the nodes
+    are laid out in depth first order.
+
+    @param[in]
+        pContainer
+            pointer to the JSON array or object
+
+    @param[in,out]
+        pCursor
+            pointer to the compaction cursor
+
+    @retval EOK the members were relocated
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_CompactChildren( JObject *pContainer,
+                                 JCompactCursor *pCursor )
+{
+    int result = EOK;
+    JNode *pNode = pContainer->pFirst;
+    JNode *pMoved;
+
+    while( ( pNode != NULL ) && ( result == EOK ) )
+    {
+        if( json_CompactMovable( pNode ) == true )
+        {
+            pMoved = json_CompactMove( pContainer, pNode, pCursor );
+            if( pMoved == NULL )
+            {
+                result = ENOMEM;
+            }
+            else
+            {
+                pNode = pMoved;
+
+                if( ( ( pNode->type == JSON_ARRAY ) ||
+                      ( pNode->type == JSON_OBJECT ) ) &&
+                    ( ((JObject *)pNode)->pShared == NULL ) )
+                {
+                    result = json_CompactChildren( (JObject *)pNode,
+                                                   pCursor );
+                }
+            }
+        }
+
+        pNode = pNode->pNext;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_CompactMove                                                        */
+/*!
+    Relocate a single container member
+
+    The json_CompactMove function copies a node into the compacted
+    storage, links the copy into the container in place of the node,
+    updates the container's hash index, which refers to the members by
+    address, and releases the node's old storage.  The index slot is
+    updated in place so compaction never has to allocate a new index.
+
+    @param[in]
+        pContainer
+            pointer to the container holding the node
+
+    @param[in]
+        pNode
+            pointer to the node to move
+
+    @param[in,out]
+        pCursor
+            pointer to the compaction cursor
+
+    @retval pointer to the relocated node
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static JNode *json_CompactMove( JObject *pContainer,
+                                JNode *pNode,
+                                JCompactCursor *pCursor )
+{
+    JNode *pMoved;
+    size_t size = json_CompactNodeSize( pNode );
+    uint32_t flags = pNode->flags;
+
+    pMoved = json_CompactAlloc( pCursor, size );
+    if( pMoved != NULL )
+    {
+        memcpy( pMoved, pNode, size );
+        pMoved->flags = JSON_NODE_COMPACT |
+                        ( pCursor->order << JSON_COMPACT_ORDER_SHIFT );
+
+        if( pMoved->pPrev == NULL )
+        {
+            pContainer->pFirst = pMoved;
+        }
+        else
+        {
+            pMoved->pPrev->pNext = pMoved;
+        }
+
+        if( pMoved->pNext == NULL )
+        {
+            pContainer->pLast = pMoved;
+        }
+        else
+        {
+            pMoved->pNext->pPrev = pMoved;
+        }
+
+        if( pContainer->node.type == JSON_OBJECT )
+        {
+            json_IndexReplace( pContainer, pNode, pMoved );
+        }
+
+        json_FreeStorage( pNode, flags );
+    }
+
+    return pMoved;
+}
+
+/*==========================================================================*/
+/*  json_CompactAlloc                                                       */
+/*!
+    Allocate storage for a relocated node
+
+    The json_CompactAlloc function allocates the next node from the
+    current compacted block, starting a new block when it is full.
+    Blocks are sized to the power of two which fits the remaining
+    nodes, within JSON_COMPACT_MIN_ORDER and JSON_COMPACT_MAX_ORDER,
+    and aligned to their size.  Each node in a block counts as a
+    reference to it.
+
+    @param[in,out]
+        pCursor
+            pointer to the compaction cursor
+
+    @param[in]
+        size
+            size of the node
+
+    @retval pointer to the node storage
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static void *json_CompactAlloc( JCompactCursor *pCursor, size_t size )
+{
+    void *p = NULL;
+    void *block;
+    uint32_t order = JSON_COMPACT_MIN_ORDER;
+    size_t header = JSON_COMPACT_ROUND( sizeof( JCompactBlock ) );
+
+    if( ( pCursor->pBlock == NULL ) ||
+        ( (size_t)( pCursor->pEnd - pCursor->pNext ) < size ) )
+    {
+        while( ( order < JSON_COMPACT_MAX_ORDER ) &&
+               ( ( (size_t)1 << order ) < ( header + pCursor->remaining ) ) )
+        {
+            order++;
+        }
+
+        if( posix_memalign( &block, (size_t)1 << order, (size_t)1 << order )
+                == 0 )
+        {
+            pCursor->pBlock = block;
+            pCursor->pBlock->live = 0;
+            pCursor->order = order;
+            pCursor->pNext = (char *)block + header;
+            pCursor->pEnd = (char *)block + ( (size_t)1 << order );
+        }
+        else
+        {
+            pCursor->pBlock = NULL;
+        }
+    }
+
+    if( pCursor->pBlock != NULL )
+    {
+        p = pCursor->pNext;
+        pCursor->pNext += size;
+        pCursor->remaining -= ( size < pCursor->remaining )
+                              ? size
+                              : pCursor->remaining;
+        pCursor->pBlock->live++;
+    }
+
+    return p;
+}
+
+/*==========================================================================*/
+/*  json_CompactRelease                                                     */
+/*!
+    Release a node stored in a compacted block
+
+    The json_CompactRelease function is called when a node relocated by
+    JSON_Compact has been freed.  The block is freed when the last of
+    the nodes stored in it has been released.
+
+    @param[in]
+        json
+            pointer to the freed node
+
+    @param[in]
+        flags
+            the node's flags before it was freed
+
+============================================================================*/
+void json_CompactRelease( JNode *json, uint32_t flags )
+{
+    size_t order = ( flags >> JSON_COMPACT_ORDER_SHIFT ) & 0xFF;
+    JCompactBlock *pBlock;
+
+    pBlock = (JCompactBlock *)( (uintptr_t)json &
+                                ~( ( (uintptr_t)1 << order ) - 1 ) );
+
+    if( __atomic_sub_fetch( &pBlock->live, 1, __ATOMIC_ACQ_REL ) == 0 )
+    {
+        free( pBlock );
+    }
+}
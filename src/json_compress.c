@@ -0,0 +1,980 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <tjson/json.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! size of the blocks of compressed data read or written */
+#define JSON_COMPRESS_BLOCK     ( 64 * 1024 )
+
+/*! number of leading bytes examined to detect the compression */
+#define JSON_COMPRESS_MAGIC     ( 4 )
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! state of a compressed stream */
+typedef struct _JCodec
+{
+    /*! underlying stream of compressed data */
+    FILE *fp;
+
+    /*! compression format */
+    JCompression type;
+
+    /*! true for an output stream, false for an input stream */
+    bool output;
+
+    /*! true once the end of the underlying stream has been read */
+    bool eof;
+
+    /*! true while a compressed frame has been started but not ended */
+    bool partial;
+
+    /*! compressed data read from, or to be written to, fp */
+    unsigned char *block;
+
+    /*! number of bytes in block */
+    size_t len;
+
+    /*! offset of the next unread byte of block */
+    size_t pos;
+
+#ifdef HAVE_ZLIB
+    /*! zlib stream state */
+    z_stream z;
+#endif
+
+#ifdef HAVE_ZSTD
+    /*! zstd decompression context */
+    ZSTD_DCtx *pDCtx;
+
+    /*! zstd compression context */
+    ZSTD_CCtx *pCCtx;
+#endif
+
+} JCodec;
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static JCompression json_CompressionType( unsigned char *magic, size_t len );
+static JCodec *json_CodecCreate( FILE *fp, JCompression type, bool output );
+static int json_CodecFree( JCodec *pCodec );
+static int json_CodecFill( JCodec *pCodec );
+static ssize_t json_DecompressRead( void *cookie, char *buf, size_t size );
+static int json_DecompressClose( void *cookie );
+static ssize_t json_CompressWrite( void *cookie, const char *buf, size_t size );
+static int json_CompressClose( void *cookie );
+static int json_CompressBlock( JCodec *pCodec,
+                               const char *buf,
+                               size_t size,
+                               bool finish );
+static int json_CodecFlush( JCodec *pCodec );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_Decompress                                                         */
+/*!
+    Open a stream of possibly compressed JSON input
+
+    The JSON_Decompress function examines the first bytes of an input
+    stream to detect gzip or zstd compressed data, and returns a stream
+    which reads the decompressed data.  The data is decompressed a block
+    at a time as the stream is read, so it can be passed to any of the
+    functions which read JSON from a FILE, such as JSON_ProcessStream,
+    without a temporary file.  Concatenated gzip members and zstd frames
+    are read as one stream.
+
+    Uncompressed input from a seekable stream is returned unchanged,
+    positioned where it was.  Otherwise the returned stream owns fp, and
+    closing it also closes fp.
+
+    @param[in]
+        fp
+            the input stream
+
+    @retval the stream to read the JSON input from
+    @retval NULL the input is compressed in a format which was not
+            built in (errno is ENOTSUP), or the stream could not be
+            created.  fp is not closed.
+
+============================================================================*/
+FILE *JSON_Decompress( FILE *fp )
+{
+    FILE *result = NULL;
+    JCodec *pCodec = NULL;
+    unsigned char magic[JSON_COMPRESS_MAGIC];
+    cookie_io_functions_t io;
+    JCompression type;
+    long pos;
+    size_t len;
+
+    if( fp != NULL )
+    {
+        pos = ftell( fp );
+        len = fread( magic, 1, sizeof( magic ), fp );
+        type = json_CompressionType( magic, len );
+
+        if( ( type == JSON_COMPRESSION_NONE ) &&
+            ( pos != -1 ) &&
+            ( fseek( fp, pos, SEEK_SET ) == 0 ) )
+        {
+            result = fp;
+        }
+        else
+        {
+            pCodec = json_CodecCreate( fp, type, false );
+        }
+
+        if( pCodec != NULL )
+        {
+            /* the bytes examined are the start of the input */
+            memcpy( pCodec->block, magic, len );
+            pCodec->len = len;
+
+            memset( &io, 0, sizeof( io ) );
+            io.read = json_DecompressRead;
+            io.close = json_DecompressClose;
+
+            result = fopencookie( pCodec, "r", io );
+            if( result != NULL )
+            {
+                setvbuf( result, NULL, _IOFBF, JSON_COMPRESS_BLOCK );
+            }
+            else
+            {
+                pCodec->fp = NULL;
+                json_CodecFree( pCodec );
+            }
+        }
+    }
+    else
+    {
+        errno = EINVAL;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_Compress                                                           */
+/*!
+    Open a stream which compresses JSON output
+
+    The JSON_Compress function returns a stream which compresses the data
+    written to it a block at a time, and writes the compressed data to an
+    output stream, so that JSON_Print can write compressed output.  The
+    returned stream owns fp.  Closing it completes the compressed data
+    and closes fp.
+
+    @param[in]
+        fp
+            the output stream
+
+    @param[in]
+        type
+            the compression format
+
+    @param[in]
+        level
+            the compression level, or 0 for the default of the format
+
+    @retval the stream to write the JSON output to
+    @retval NULL the format was not built in (errno is ENOTSUP), or the
+            stream could not be created.  fp is not closed.
+
+============================================================================*/
+FILE *JSON_Compress( FILE *fp, JCompression type, int level )
+{
+    FILE *result = NULL;
+    JCodec *pCodec = NULL;
+    cookie_io_functions_t io;
+    int rc = ENOTSUP;
+
+    if( ( fp != NULL ) &&
+        ( type != JSON_COMPRESSION_NONE ) )
+    {
+        pCodec = json_CodecCreate( fp, type, true );
+    }
+    else
+    {
+        errno = EINVAL;
+    }
+
+    if( pCodec != NULL )
+    {
+#ifdef HAVE_ZLIB
+        if( type == JSON_COMPRESSION_GZIP )
+        {
+            /* a window of 15 bits plus 16 selects the gzip format */
+            rc = ( deflateInit2( &pCodec->z,
+                                 ( level != 0 ) ? level
+                                                : Z_DEFAULT_COMPRESSION,
+                                 Z_DEFLATED,
+                                 15 + 16,
+                                 8,
+                                 Z_DEFAULT_STRATEGY ) == Z_OK ) ? EOK
+                                                                : ENOMEM;
+        }
+#endif
+
+#ifdef HAVE_ZSTD
+        if( type == JSON_COMPRESSION_ZSTD )
+        {
+            /* a checksum detects corruption, as the gzip CRC does */
+            rc = ZSTD_isError( ZSTD_CCtx_setParameter( pCodec->pCCtx,
+                                                       ZSTD_c_checksumFlag,
+                                                       1 ) ) ? EINVAL : EOK;
+            if( ( level != 0 ) &&
+                ( ZSTD_isError( ZSTD_CCtx_setParameter(
+                                    pCodec->pCCtx,
+                                    ZSTD_c_compressionLevel,
+                                    level ) ) ) )
+            {
+                rc = EINVAL;
+            }
+        }
+#endif
+
+        (void)level;
+
+        if( rc == EOK )
+        {
+            memset( &io, 0, sizeof( io ) );
+            io.write = json_CompressWrite;
+            io.close = json_CompressClose;
+
+            result = fopencookie( pCodec, "w", io );
+            if( result != NULL )
+            {
+                setvbuf( result, NULL, _IOFBF, JSON_COMPRESS_BLOCK );
+            }
+            else
+            {
+                rc = errno;
+            }
+        }
+
+        if( result == NULL )
+        {
+            pCodec->fp = NULL;
+            json_CodecFree( pCodec );
+            errno = rc;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_CompressionType                                                    */
+/*!
+    Detect the compression of an input
+
+    The json_CompressionType function identifies the compression format
+    from the magic bytes at the start of the input.
+
+    @param[in]
+        magic
+            pointer to the first bytes of the input
+
+    @param[in]
+        len
+            number of bytes available
+
+    @retval the compression format of the input
+
+============================================================================*/
+static JCompression json_CompressionType( unsigned char *magic, size_t len )
+{
+    JCompression type = JSON_COMPRESSION_NONE;
+
+    if( ( len >= 2 ) &&
+        ( magic[0] == 0x1f ) &&
+        ( magic[1] == 0x8b ) )
+    {
+        type = JSON_COMPRESSION_GZIP;
+    }
+    else if( ( len >= 4 ) &&
+             ( magic[0] == 0x28 ) &&
+             ( magic[1] == 0xb5 ) &&
+             ( magic[2] == 0x2f ) &&
+             ( magic[3] == 0xfd ) )
+    {
+        type = JSON_COMPRESSION_ZSTD;
+    }
+
+    return type;
+}
+
+/*==========================================================================*/
+/*  json_CodecCreate                                                        */
+/*!
+    Create the state of a compressed stream
+
+    The json_CodecCreate function allocates the state of a compressed
+    stream, and the decompression context if it is an input stream.
+    Uncompressed input is passed through.
+
+    @param[in]
+        fp
+            the underlying stream
+
+    @param[in]
+        type
+            the compression format
+
+    @param[in]
+        output
+            true for an output stream, false for an input stream
+
+    @retval pointer to the stream state
+    @retval NULL the format was not built in (errno is ENOTSUP), or
+            memory allocation failure (errno is ENOMEM)
+
+============================================================================*/
+static JCodec *json_CodecCreate( FILE *fp, JCompression type, bool output )
+{
+    JCodec *pCodec;
+    int rc = ENOTSUP;
+
+    pCodec = calloc( 1, sizeof( JCodec ) );
+    if( pCodec != NULL )
+    {
+        pCodec->fp = fp;
+        pCodec->type = type;
+        pCodec->output = output;
+        pCodec->block = malloc( JSON_COMPRESS_BLOCK );
+        if( pCodec->block == NULL )
+        {
+            rc = ENOMEM;
+        }
+        else if( type == JSON_COMPRESSION_NONE )
+        {
+            rc = EOK;
+        }
+
+#ifdef HAVE_ZLIB
+        if( ( pCodec->block != NULL ) &&
+            ( type == JSON_COMPRESSION_GZIP ) )
+        {
+            /* deflate is initialized by JSON_Compress with the level */
+            rc = ( ( output == true ) ||
+                   ( inflateInit2( &pCodec->z, 15 + 16 ) == Z_OK ) ) ? EOK
+                                                                    : ENOMEM;
+        }
+#endif
+
+#ifdef HAVE_ZSTD
+        if( ( pCodec->block != NULL ) &&
+            ( type == JSON_COMPRESSION_ZSTD ) )
+        {
+            if( output == true )
+            {
+                pCodec->pCCtx = ZSTD_createCCtx();
+                rc = ( pCodec->pCCtx != NULL ) ? EOK : ENOMEM;
+            }
+            else
+            {
+                pCodec->pDCtx = ZSTD_createDCtx();
+                rc = ( pCodec->pDCtx != NULL ) ? EOK : ENOMEM;
+            }
+        }
+#endif
+
+        if( rc != EOK )
+        {
+            /* the context has not been initialized */
+            pCodec->type = JSON_COMPRESSION_NONE;
+            pCodec->fp = NULL;
+            json_CodecFree( pCodec );
+            pCodec = NULL;
+            errno = rc;
+        }
+    }
+
+    return pCodec;
+}
+
+/*==========================================================================*/
+/*  json_CodecFree                                                          */
+/*!
+    Release the state of a compressed stream
+
+    The json_CodecFree function releases the compression context of a
+    compressed stream, and closes the underlying stream if it is set.
+
+    @param[in]
+        pCodec
+            pointer to the stream state
+
+    @retval 0 the underlying stream was closed, or was not set
+    @retval EOF fclose failed
+
+============================================================================*/
+static int json_CodecFree( JCodec *pCodec )
+{
+    int result = 0;
+
+#ifdef HAVE_ZLIB
+    if( ( pCodec->type == JSON_COMPRESSION_GZIP ) &&
+        ( pCodec->z.state != NULL ) )
+    {
+        if( pCodec->output == true )
+        {
+            deflateEnd( &pCodec->z );
+        }
+        else
+        {
+            inflateEnd( &pCodec->z );
+        }
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    ZSTD_freeDCtx( pCodec->pDCtx );
+    ZSTD_freeCCtx( pCodec->pCCtx );
+#endif
+
+    if( pCodec->fp != NULL )
+    {
+        result = fclose( pCodec->fp );
+    }
+
+    free( pCodec->block );
+    free( pCodec );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_CodecFill                                                          */
+/*!
+    Read the next block of input
+
+    The json_CodecFill function reads the next block of the underlying
+    stream once the current block has been consumed.
+
+    @param[in]
+        pCodec
+            pointer to the stream state
+
+    @retval EOK the block has unread data, or the end of the input has
+            been reached
+    @retval EIO the underlying stream could not be read
+
+============================================================================*/
+static int json_CodecFill( JCodec *pCodec )
+{
+    int result = EOK;
+
+    if( ( pCodec->pos == pCodec->len ) &&
+        ( pCodec->eof == false ) )
+    {
+        pCodec->pos = 0;
+        pCodec->len = fread( pCodec->block,
+                             1,
+                             JSON_COMPRESS_BLOCK,
+                             pCodec->fp );
+        if( pCodec->len == 0 )
+        {
+            if( ferror( pCodec->fp ) )
+            {
+                result = EIO;
+            }
+            else
+            {
+                pCodec->eof = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DecompressRead                                                     */
+/*!
+    Read decompressed data
+
+    The json_DecompressRead function is the fopencookie read function of
+    a decompressing stream.  It decompresses input a block at a time
+    until some output is available.  Input which ends part way through
+    a gzip member or zstd frame is an error.
+
+    @param[in]
+        cookie
+            pointer to the stream state
+
+    @param[in]
+        buf
+            buffer to store the decompressed data in
+
+    @param[in]
+        size
+            size of the buffer
+
+    @retval number of bytes stored in the buffer, or 0 at end of input
+    @retval -1 the input could not be read or is corrupt (errno is set)
+
+============================================================================*/
+static ssize_t json_DecompressRead( void *cookie, char *buf, size_t size )
+{
+    JCodec *pCodec = (JCodec *)cookie;
+    ssize_t result;
+    size_t produced = 0;
+    int rc = EOK;
+    bool done = false;
+#ifdef HAVE_ZLIB
+    int zrc;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    size_t zsrc;
+#endif
+
+    if( pCodec->type == JSON_COMPRESSION_NONE )
+    {
+        /* pass through the bytes examined, then read directly */
+        if( pCodec->pos < pCodec->len )
+        {
+            produced = pCodec->len - pCodec->pos;
+            produced = ( produced < size ) ? produced : size;
+            memcpy( buf, &pCodec->block[pCodec->pos], produced );
+            pCodec->pos += produced;
+        }
+        else
+        {
+            produced = fread( buf, 1, size, pCodec->fp );
+            if( ( produced == 0 ) &&
+                ( ferror( pCodec->fp ) ) )
+            {
+                rc = EIO;
+            }
+        }
+    }
+
+#ifdef HAVE_ZLIB
+    if( pCodec->type == JSON_COMPRESSION_GZIP )
+    {
+        pCodec->z.next_out = (Bytef *)buf;
+        pCodec->z.avail_out = size;
+
+        while( ( rc == EOK ) &&
+               ( done == false ) &&
+               ( pCodec->z.avail_out == size ) )
+        {
+            rc = json_CodecFill( pCodec );
+            pCodec->z.next_in = &pCodec->block[pCodec->pos];
+            pCodec->z.avail_in = pCodec->len - pCodec->pos;
+
+            zrc = inflate( &pCodec->z, Z_NO_FLUSH );
+            pCodec->pos = pCodec->len - pCodec->z.avail_in;
+
+            if( zrc == Z_STREAM_END )
+            {
+                /* another member may follow */
+                pCodec->partial = false;
+                inflateReset( &pCodec->z );
+            }
+            else if( zrc == Z_OK )
+            {
+                pCodec->partial = true;
+            }
+            else if( zrc == Z_BUF_ERROR )
+            {
+                /* no progress is possible at the end of the input */
+                done = true;
+                rc = ( pCodec->partial == true ) ? EIO : rc;
+            }
+            else
+            {
+                rc = ( zrc == Z_MEM_ERROR ) ? ENOMEM : EBADMSG;
+            }
+        }
+
+        produced = size - pCodec->z.avail_out;
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    if( pCodec->type == JSON_COMPRESSION_ZSTD )
+    {
+        out.dst = buf;
+        out.size = size;
+        out.pos = 0;
+
+        while( ( rc == EOK ) &&
+               ( done == false ) &&
+               ( out.pos == 0 ) )
+        {
+            rc = json_CodecFill( pCodec );
+            if( ( pCodec->eof == true ) &&
+                ( pCodec->partial == false ) )
+            {
+                done = true;
+            }
+            else if( rc == EOK )
+            {
+                in.src = pCodec->block;
+                in.size = pCodec->len;
+                in.pos = pCodec->pos;
+
+                zsrc = ZSTD_decompressStream( pCodec->pDCtx, &out, &in );
+                pCodec->pos = in.pos;
+
+                if( ZSTD_isError( zsrc ) )
+                {
+                    rc = EBADMSG;
+                }
+                else
+                {
+                    /* zero when a frame is complete and flushed */
+                    pCodec->partial = ( zsrc != 0 );
+                }
+
+                if( ( rc == EOK ) &&
+                    ( out.pos == 0 ) &&
+                    ( pCodec->eof == true ) )
+                {
+                    done = true;
+                    rc = ( pCodec->partial == true ) ? EIO : rc;
+                }
+            }
+        }
+
+        produced = out.pos;
+    }
+#endif
+
+    (void)done;
+
+    if( rc == EOK )
+    {
+        result = produced;
+    }
+    else
+    {
+        errno = rc;
+        result = -1;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DecompressClose                                                    */
+/*!
+    Close a decompressing stream
+
+    The json_DecompressClose function is the fopencookie close function
+    of a decompressing stream.  It releases the stream state and closes
+    the underlying stream.
+
+    @param[in]
+        cookie
+            pointer to the stream state
+
+    @retval 0 the stream was closed
+    @retval EOF the underlying stream could not be closed
+
+============================================================================*/
+static int json_DecompressClose( void *cookie )
+{
+    return json_CodecFree( (JCodec *)cookie );
+}
+
+/*==========================================================================*/
+/*  json_CompressWrite                                                      */
+/*!
+    Write data to be compressed
+
+    The json_CompressWrite function is the fopencookie write function of
+    a compressing stream.
+
+    @param[in]
+        cookie
+            pointer to the stream state
+
+    @param[in]
+        buf
+            data to compress
+
+    @param[in]
+        size
+            number of bytes of data
+
+    @retval size the data was compressed
+    @retval 0 the compressed data could not be written (errno is set)
+
+============================================================================*/
+static ssize_t json_CompressWrite( void *cookie, const char *buf, size_t size )
+{
+    ssize_t result = size;
+    int rc;
+
+    rc = json_CompressBlock( (JCodec *)cookie, buf, size, false );
+    if( rc != EOK )
+    {
+        errno = rc;
+        result = 0;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_CompressClose                                                      */
+/*!
+    Close a compressing stream
+
+    The json_CompressClose function is the fopencookie close function of
+    a compressing stream.  It completes the compressed data, releases the
+    stream state, and closes the underlying stream.
+
+    @param[in]
+        cookie
+            pointer to the stream state
+
+    @retval 0 the stream was completed and closed
+    @retval EOF the compressed data could not be completed, or the
+            underlying stream could not be closed (errno is set)
+
+============================================================================*/
+static int json_CompressClose( void *cookie )
+{
+    int result;
+    int rc;
+
+    rc = json_CompressBlock( (JCodec *)cookie, NULL, 0, true );
+    result = json_CodecFree( (JCodec *)cookie );
+
+    if( rc != EOK )
+    {
+        errno = rc;
+        result = EOF;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_CompressBlock                                                      */
+/*!
+    Compress data
+
+    The json_CompressBlock function compresses data into the output
+    block, writing the block to the underlying stream each time it is
+    full.  When finishing, the compressed data is completed and the
+    output block is written.
+
+    @param[in]
+        pCodec
+            pointer to the stream state
+
+    @param[in]
+        buf
+            data to compress
+
+    @param[in]
+        size
+            number of bytes of data
+
+    @param[in]
+        finish
+            true to complete the compressed data
+
+    @retval EOK the data was compressed
+    @retval EIO the compressed data could not be written
+
+============================================================================*/
+static int json_CompressBlock( JCodec *pCodec,
+                               const char *buf,
+                               size_t size,
+                               bool finish )
+{
+    int result = EOK;
+    bool complete = false;
+#ifdef HAVE_ZLIB
+    int zrc;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_inBuffer in;
+    ZSTD_outBuffer out;
+    size_t zsrc;
+#endif
+
+#ifdef HAVE_ZLIB
+    if( pCodec->type == JSON_COMPRESSION_GZIP )
+    {
+        pCodec->z.next_in = (Bytef *)buf;
+        pCodec->z.avail_in = size;
+
+        while( ( result == EOK ) &&
+               ( complete == false ) )
+        {
+            pCodec->z.next_out = &pCodec->block[pCodec->len];
+            pCodec->z.avail_out = JSON_COMPRESS_BLOCK - pCodec->len;
+
+            zrc = deflate( &pCodec->z, finish ? Z_FINISH : Z_NO_FLUSH );
+            pCodec->len = JSON_COMPRESS_BLOCK - pCodec->z.avail_out;
+
+            if( zrc == Z_STREAM_ERROR )
+            {
+                result = EIO;
+            }
+            else if( pCodec->len == JSON_COMPRESS_BLOCK )
+            {
+                result = json_CodecFlush( pCodec );
+            }
+
+            complete = ( finish == true ) ? ( zrc == Z_STREAM_END )
+                                          : ( ( pCodec->z.avail_in == 0 ) &&
+                                              ( pCodec->z.avail_out > 0 ) );
+        }
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    if( pCodec->type == JSON_COMPRESSION_ZSTD )
+    {
+        in.src = buf;
+        in.size = size;
+        in.pos = 0;
+
+        while( ( result == EOK ) &&
+               ( complete == false ) )
+        {
+            out.dst = pCodec->block;
+            out.size = JSON_COMPRESS_BLOCK;
+            out.pos = pCodec->len;
+
+            zsrc = ZSTD_compressStream2( pCodec->pCCtx,
+                                         &out,
+                                         &in,
+                                         finish ? ZSTD_e_end
+                                                : ZSTD_e_continue );
+            pCodec->len = out.pos;
+
+            if( ZSTD_isError( zsrc ) )
+            {
+                result = EIO;
+            }
+            else if( pCodec->len == JSON_COMPRESS_BLOCK )
+            {
+                result = json_CodecFlush( pCodec );
+            }
+
+            /* zero when the frame is complete and flushed */
+            complete = ( finish == true ) ? ( zsrc == 0 )
+                                          : ( in.pos == in.size );
+        }
+    }
+#endif
+
+    if( ( result == EOK ) &&
+        ( finish == true ) )
+    {
+        result = json_CodecFlush( pCodec );
+    }
+
+    (void)buf;
+    (void)size;
+    (void)complete;
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_CodecFlush                                                         */
+/*!
+    Write the output block
+
+    The json_CodecFlush function writes the compressed data in the
+    output block to the underlying stream.
+
+    @param[in]
+        pCodec
+            pointer to the stream state
+
+    @retval EOK the output block was written
+    @retval EIO the output block could not be written
+
+============================================================================*/
+static int json_CodecFlush( JCodec *pCodec )
+{
+    int result = EOK;
+
+    if( ( pCodec->len > 0 ) &&
+        ( fwrite( pCodec->block, 1, pCodec->len, pCodec->fp ) != pCodec->len ) )
+    {
+        result = EIO;
+    }
+
+    pCodec->len = 0;
+
+    return result;
+}
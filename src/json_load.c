@@ -0,0 +1,936 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <fnmatch.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! largest number of loader threads */
+#define JSON_LOAD_MAX_THREADS   ( 64 )
+
+/*============================================================================
+        External Functions
+============================================================================*/
+
+/*! parse a buffer in place */
+extern JNode *json_ProcessInPlace( char *buf, size_t len, uint64_t *pUsec );
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! a set of files being loaded by a pool of threads */
+typedef struct _JLoadJob
+{
+    /*! names of the files to load */
+    char **paths;
+
+    /*! number of files to load */
+    size_t n;
+
+    /*! index of the next file to be claimed by a thread */
+    size_t next;
+
+    /*! function to invoke for each loaded file */
+    JSON_LoadFn fn;
+
+    /*! argument to pass to the function */
+    void *arg;
+
+    /*! optional array to receive the read time of each file in
+        microseconds */
+    uint64_t *pReadTimes;
+
+    /*! optional array to receive the parse time of each file in
+        microseconds */
+    uint64_t *pParseTimes;
+
+} JLoadJob;
+
+/*! read buffer owned by a loader thread */
+typedef struct _JLoadBuffer
+{
+    /*! pointer to the buffer */
+    char *p;
+
+    /*! size of the buffer */
+    size_t size;
+
+} JLoadBuffer;
+
+/*! files found by a directory walk, and the results of loading them */
+typedef struct _JLoadList
+{
+    /*! names of the files found */
+    char **paths;
+
+    /*! number of files found */
+    size_t n;
+
+    /*! number of entries allocated for paths */
+    size_t size;
+
+    /*! parsed document of each file */
+    JNode **pDocs;
+
+    /*! load error of each file */
+    int *errors;
+
+    /*! read time of each file in microseconds */
+    uint64_t *readTimes;
+
+    /*! parse time of each file in microseconds */
+    uint64_t *parseTimes;
+
+} JLoadList;
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static void json_LoadRun( JLoadJob *pJob, int nthreads );
+static void *json_LoadWorker( void *arg );
+static JNode *json_LoadFile( char *path,
+                             JLoadBuffer *pBuffer,
+                             int *pError,
+                             uint64_t *pReadUsec,
+                             uint64_t *pParseUsec );
+static int json_LoadRead( int fd, JLoadBuffer *pBuffer, size_t *pLen );
+static int json_LoadWalk( char *dir, char *pattern, JLoadList *pList );
+static int json_LoadCompare( const void *p1, const void *p2 );
+static void json_LoadCollect( size_t idx,
+                              char *path,
+                              JNode *pDoc,
+                              int error,
+                              void *arg );
+static void json_LoadAssemble( JObject *pObject,
+                               JObject *pReport,
+                               char *name,
+                               JNode *pDoc,
+                               int error,
+                               uint64_t readUsec,
+                               uint64_t parseUsec );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_LoadMany                                                           */
+/*!
+    Load many JSON files concurrently
+
+    The JSON_LoadMany function loads and parses a list of JSON files
+    using a pool of threads, so that the latency of opening and reading
+    one file overlaps the work done on the others.  Each thread claims
+    the next file from the list, reads it into a buffer it reuses for
+    every file with pread, and parses it in place.
+
+    The specified function is invoked for each file, from the thread
+    which loaded it, as soon as it has been parsed.  Invocations may be
+    concurrent, and are not in the order of the list.  The function
+    owns the parsed document.  The call returns when every file has
+    been processed.
+
+    @param[in]
+        paths
+            array of names of the files to load
+
+    @param[in]
+        n
+            number of files to load
+
+    @param[in]
+        nthreads
+            number of threads to use, or 0 for one per online processor
+
+    @param[in]
+        fn
+            the function to invoke for each file
+
+    @param[in]
+        arg
+            the argument to pass to the function each time it is invoked
+
+    @retval EOK every file was processed
+    @retval EINVAL invalid arguments
+
+============================================================================*/
+int JSON_LoadMany( char *paths[],
+                   size_t n,
+                   int nthreads,
+                   JSON_LoadFn fn,
+                   void *arg )
+{
+    int result = EINVAL;
+    JLoadJob job;
+
+    if( ( paths != NULL ) &&
+        ( fn != NULL ) &&
+        ( nthreads >= 0 ) )
+    {
+        job.paths = paths;
+        job.n = n;
+        job.next = 0;
+        job.fn = fn;
+        job.arg = arg;
+        job.pReadTimes = NULL;
+        job.pParseTimes = NULL;
+
+        json_LoadRun( &job, nthreads );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_LoadDirectory                                                      */
+/*!
+    Load every JSON file in a directory tree concurrently
+
+    The JSON_LoadDirectory function walks a directory tree, and loads
+    and parses the regular files whose names match a shell wildcard
+    pattern using a pool of threads as JSON_LoadMany does.  Symbolic
+    links to directories are not followed.
+
+    The parsed documents are assembled into a single JSON object whose
+    members are named by the path of each file relative to the
+    directory, in sorted order.  Files which could not be loaded are
+    left out.
+
+    If a report is requested, it is a JSON object with a member for
+    every matching file, named by its relative path, of the form
+    { "read_usec": <read time in microseconds>,
+      "parse_usec": <parse time in microseconds>,
+      "error": <errno> }
+    so that slow and failing files can be found.  Files are parsed one
+    at a time, and the parse time does not include waiting for another
+    thread's parse to finish.
+
+    @param[in]
+        dir
+            name of the directory to walk
+
+    @param[in]
+        pattern
+            fnmatch wildcard pattern for the file names to load, or NULL
+            to load all regular files
+
+    @param[in]
+        nthreads
+            number of threads to use, or 0 for one per online processor
+
+    @param[out]
+        ppReport
+            optional location to store the per-file report, which
+            is owned by the caller
+
+    @retval pointer to the JSON object containing the loaded documents
+    @retval NULL the directory could not be walked
+
+============================================================================*/
+JObject *JSON_LoadDirectory( char *dir,
+                             char *pattern,
+                             int nthreads,
+                             JObject **ppReport )
+{
+    JObject *pObject = NULL;
+    JObject *pReport = NULL;
+    JLoadList list;
+    JLoadJob job;
+    size_t prefix;
+    size_t i;
+    int result = EINVAL;
+
+    list.paths = NULL;
+    list.n = 0;
+    list.size = 0;
+    list.pDocs = NULL;
+    list.errors = NULL;
+    list.readTimes = NULL;
+    list.parseTimes = NULL;
+
+    if( ( dir != NULL ) &&
+        ( nthreads >= 0 ) )
+    {
+        /* relative paths start after the separator following dir */
+        prefix = strlen( dir );
+        if( ( prefix > 0 ) && ( dir[prefix - 1] != '/' ) )
+        {
+            prefix++;
+        }
+
+        result = json_LoadWalk( dir, pattern, &list );
+    }
+
+    if( result == EOK )
+    {
+        if( list.n > 1 )
+        {
+            qsort( list.paths, list.n, sizeof( char * ), json_LoadCompare );
+        }
+
+        list.pDocs = calloc( list.n + 1, sizeof( JNode * ) );
+        list.errors = calloc( list.n + 1, sizeof( int ) );
+        list.readTimes = calloc( list.n + 1, sizeof( uint64_t ) );
+        list.parseTimes = calloc( list.n + 1, sizeof( uint64_t ) );
+        pObject = JSON_Object( NULL );
+        if( ppReport != NULL )
+        {
+            pReport = JSON_Object( NULL );
+        }
+
+        if( ( list.pDocs == NULL ) ||
+            ( list.errors == NULL ) ||
+            ( list.readTimes == NULL ) ||
+            ( list.parseTimes == NULL ) ||
+            ( pObject == NULL ) ||
+            ( ( ppReport != NULL ) && ( pReport == NULL ) ) )
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if( result == EOK )
+    {
+        job.paths = list.paths;
+        job.n = list.n;
+        job.next = 0;
+        job.fn = json_LoadCollect;
+        job.arg = &list;
+        job.pReadTimes = list.readTimes;
+        job.pParseTimes = list.parseTimes;
+
+        json_LoadRun( &job, nthreads );
+
+        for( i = 0; i < list.n; i++ )
+        {
+            json_LoadAssemble( pObject,
+                               pReport,
+                               &list.paths[i][prefix],
+                               list.pDocs[i],
+                               list.errors[i],
+                               list.readTimes[i],
+                               list.parseTimes[i] );
+        }
+    }
+    else
+    {
+        JSON_Free( (JNode *)pObject );
+        JSON_Free( (JNode *)pReport );
+        pObject = NULL;
+        pReport = NULL;
+        errno = result;
+    }
+
+    if( ppReport != NULL )
+    {
+        *ppReport = pReport;
+    }
+
+    for( i = 0; i < list.n; i++ )
+    {
+        free( list.paths[i] );
+    }
+
+    free( list.paths );
+    free( list.pDocs );
+    free( list.errors );
+    free( list.readTimes );
+    free( list.parseTimes );
+
+    return pObject;
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_LoadRun                                                            */
+/*!
+    Run a load job on a pool of threads
+
+    The json_LoadRun function starts the loader threads for a job,
+    works on the job from the calling thread, and waits for the loader
+    threads to finish.
+
+    @param[in]
+        pJob
+            pointer to the job to run
+
+    @param[in]
+        nthreads
+            number of threads to use, or 0 for one per online processor
+
+============================================================================*/
+static void json_LoadRun( JLoadJob *pJob, int nthreads )
+{
+    pthread_t threads[JSON_LOAD_MAX_THREADS];
+    long count = nthreads;
+    int started = 0;
+    int i;
+
+    if( count == 0 )
+    {
+        count = sysconf( _SC_NPROCESSORS_ONLN );
+    }
+
+    if( count > JSON_LOAD_MAX_THREADS )
+    {
+        count = JSON_LOAD_MAX_THREADS;
+    }
+
+    if( (size_t)count > pJob->n )
+    {
+        count = pJob->n;
+    }
+
+    /* the calling thread is one of the loaders */
+    for( i = 1; i < count; i++ )
+    {
+        if( pthread_create( &threads[started],
+                            NULL,
+                            json_LoadWorker,
+                            pJob ) == 0 )
+        {
+            started++;
+        }
+    }
+
+    json_LoadWorker( pJob );
+
+    for( i = 0; i < started; i++ )
+    {
+        pthread_join( threads[i], NULL );
+    }
+}
+
+/*==========================================================================*/
+/*  json_LoadWorker                                                         */
+/*!
+    Loader thread
+
+    The json_LoadWorker function loads files from a job until all of
+    them have been claimed.
+
+    @param[in]
+        arg
+            pointer to the JLoadJob
+
+    @retval NULL
+
+============================================================================*/
+static void *json_LoadWorker( void *arg )
+{
+    JLoadJob *pJob = (JLoadJob *)arg;
+    JLoadBuffer buffer;
+    JNode *pDoc;
+    size_t idx;
+    int error;
+
+    buffer.p = NULL;
+    buffer.size = 0;
+
+    while( ( idx = __atomic_fetch_add( &pJob->next,
+                                       1,
+                                       __ATOMIC_RELAXED ) ) < pJob->n )
+    {
+        pDoc = json_LoadFile( pJob->paths[idx],
+                              &buffer,
+                              &error,
+                              ( pJob->pReadTimes != NULL )
+                              ? &pJob->pReadTimes[idx] : NULL,
+                              ( pJob->pParseTimes != NULL )
+                              ? &pJob->pParseTimes[idx] : NULL );
+
+        pJob->fn( idx, pJob->paths[idx], pDoc, error, pJob->arg );
+    }
+
+    free( buffer.p );
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  json_LoadFile                                                           */
+/*!
+    Load and parse a JSON file
+
+    The json_LoadFile function reads a file into a loader thread's
+    buffer and parses it in place.  The read and the parse are timed
+    separately, and the parse time does not include waiting for the
+    parser to be released by another thread.
+
+    @param[in]
+        path
+            name of the file to load
+
+    @param[in]
+        pBuffer
+            pointer to the loader thread's buffer
+
+    @param[out]
+        pError
+            location to store EOK, or the reason the file was not loaded
+
+    @param[out]
+        pReadUsec
+            optional location to store the read time in microseconds
+
+    @param[out]
+        pParseUsec
+            optional location to store the parse time in microseconds
+
+    @retval pointer to the parsed document
+    @retval NULL the file could not be read or parsed
+
+============================================================================*/
+static JNode *json_LoadFile( char *path,
+                             JLoadBuffer *pBuffer,
+                             int *pError,
+                             uint64_t *pReadUsec,
+                             uint64_t *pParseUsec )
+{
+    JNode *pDoc = NULL;
+    JParseError err;
+    size_t len;
+    int fd;
+    struct timespec start;
+    struct timespec end;
+
+    if( pReadUsec != NULL )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &start );
+    }
+
+    fd = open( path, O_RDONLY | O_CLOEXEC );
+    if( fd != -1 )
+    {
+        *pError = json_LoadRead( fd, pBuffer, &len );
+        close( fd );
+
+        if( pReadUsec != NULL )
+        {
+            clock_gettime( CLOCK_MONOTONIC, &end );
+            *pReadUsec = ( end.tv_sec - start.tv_sec ) * 1000000 +
+                         ( end.tv_nsec - start.tv_nsec ) / 1000;
+        }
+
+        if( *pError == EOK )
+        {
+            pDoc = json_ProcessInPlace( pBuffer->p, len, pParseUsec );
+            if( pDoc == NULL )
+            {
+                JSON_GetParseError( &err );
+                *pError = err.error;
+            }
+        }
+    }
+    else
+    {
+        *pError = errno;
+    }
+
+    return pDoc;
+}
+
+/*==========================================================================*/
+/*  json_LoadRead                                                           */
+/*!
+    Read a whole file into a loader thread's buffer
+
+    The json_LoadRead function reads a file into a loader thread's
+    buffer with pread, growing the buffer to fit, and terminates the
+    content with the two NULs needed to scan it in place.
+
+    @param[in]
+        fd
+            the file to read
+
+    @param[in]
+        pBuffer
+            pointer to the loader thread's buffer
+
+    @param[out]
+        pLen
+            location to store the length of the content
+
+    @retval EOK the file was read
+    @retval ENOMEM memory allocation failure
+    @retval other error returned by fstat or pread
+
+============================================================================*/
+static int json_LoadRead( int fd, JLoadBuffer *pBuffer, size_t *pLen )
+{
+    int result = EOK;
+    struct stat st;
+    size_t len = 0;
+    size_t size;
+    ssize_t n = 1;
+    char *p;
+
+    if( fstat( fd, &st ) == 0 )
+    {
+        /* ask for one byte more than expected to detect a file which
+           has grown, so the common case ends on the second pread */
+        size = st.st_size + 3;
+
+        while( ( result == EOK ) &&
+               ( n > 0 ) )
+        {
+            if( len + 2 >= size )
+            {
+                size *= 2;
+            }
+
+            if( size > pBuffer->size )
+            {
+                p = realloc( pBuffer->p, size );
+                if( p != NULL )
+                {
+                    pBuffer->p = p;
+                    pBuffer->size = size;
+                }
+                else
+                {
+                    result = ENOMEM;
+                }
+            }
+
+            if( result == EOK )
+            {
+                n = pread( fd, &pBuffer->p[len], size - len - 2, len );
+                if( n > 0 )
+                {
+                    len += n;
+                }
+                else if( ( n < 0 ) && ( errno != EINTR ) )
+                {
+                    result = errno;
+                }
+                else if( n < 0 )
+                {
+                    n = 1;
+                }
+            }
+        }
+
+        if( result == EOK )
+        {
+            pBuffer->p[len] = 0;
+            pBuffer->p[len + 1] = 0;
+            *pLen = len;
+        }
+    }
+    else
+    {
+        result = errno;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_LoadWalk                                                           */
+/*!
+    Find the files to load in a directory tree
+
+    The json_LoadWalk function recursively adds the regular files in a
+    directory tree whose names match a pattern to a list.  Directories
+    below the top which cannot be opened are skipped.
+
+    @param[in]
+        dir
+            name of the directory to walk
+
+    @param[in]
+        pattern
+            fnmatch wildcard pattern for the file names, or NULL for all
+
+    @param[in]
+        pList
+            pointer to the list of files to add to
+
+    @retval EOK the directory was walked
+    @retval ENOMEM memory allocation failure
+    @retval other error returned by opendir
+
+============================================================================*/
+static int json_LoadWalk( char *dir, char *pattern, JLoadList *pList )
+{
+    int result = EOK;
+    DIR *pDir;
+    struct dirent *pEntry;
+    struct stat st;
+    size_t len = strlen( dir );
+    char *sep = ( ( len > 0 ) && ( dir[len - 1] == '/' ) ) ? "" : "/";
+    char *path;
+    char **paths;
+
+    pDir = opendir( dir );
+    if( pDir != NULL )
+    {
+        while( ( result == EOK ) &&
+               ( ( pEntry = readdir( pDir ) ) != NULL ) )
+        {
+            if( ( strcmp( pEntry->d_name, "." ) == 0 ) ||
+                ( strcmp( pEntry->d_name, ".." ) == 0 ) )
+            {
+                continue;
+            }
+
+            path = malloc( len + strlen( pEntry->d_name ) + 2 );
+            if( path == NULL )
+            {
+                result = ENOMEM;
+                break;
+            }
+
+            sprintf( path, "%s%s%s", dir, sep, pEntry->d_name );
+
+            if( lstat( path, &st ) != 0 )
+            {
+                free( path );
+            }
+            else if( S_ISDIR( st.st_mode ) )
+            {
+                if( json_LoadWalk( path, pattern, pList ) == ENOMEM )
+                {
+                    result = ENOMEM;
+                }
+
+                free( path );
+            }
+            else if( ( stat( path, &st ) != 0 ) ||
+                     ( !S_ISREG( st.st_mode ) ) ||
+                     ( ( pattern != NULL ) &&
+                       ( fnmatch( pattern, pEntry->d_name, 0 ) != 0 ) ) )
+            {
+                free( path );
+            }
+            else
+            {
+                if( pList->n == pList->size )
+                {
+                    pList->size = ( pList->size == 0 ) ? 64
+                                                       : pList->size * 2;
+                    paths = realloc( pList->paths,
+                                     pList->size * sizeof( char * ) );
+                    if( paths == NULL )
+                    {
+                        free( path );
+                        result = ENOMEM;
+                        break;
+                    }
+
+                    pList->paths = paths;
+                }
+
+                pList->paths[pList->n++] = path;
+            }
+        }
+
+        closedir( pDir );
+    }
+    else
+    {
+        result = errno;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_LoadCompare                                                        */
+/*!
+    Compare two file names
+
+    The json_LoadCompare function is the qsort comparator used to sort
+    the files found by a directory walk.
+
+    @param[in]
+        p1
+            pointer to the first file name
+
+    @param[in]
+        p2
+            pointer to the second file name
+
+    @retval <0, 0, >0 as strcmp
+
+============================================================================*/
+static int json_LoadCompare( const void *p1, const void *p2 )
+{
+    return strcmp( *(char * const *)p1, *(char * const *)p2 );
+}
+
+/*==========================================================================*/
+/*  json_LoadCollect                                                        */
+/*!
+    Collect the result of loading a file of a directory
+
+    The json_LoadCollect function is the JSON_LoadFn used by
+    JSON_LoadDirectory.  Each file has its own slot, so the loader
+    threads store their results without locking.
+
+    @param[in]
+        idx
+            index of the file in the list
+
+    @param[in]
+        path
+            name of the file
+
+    @param[in]
+        pDoc
+            the parsed document, or NULL
+
+    @param[in]
+        error
+            the reason the file was not loaded
+
+    @param[in]
+        arg
+            pointer to the JLoadList
+
+============================================================================*/
+static void json_LoadCollect( size_t idx,
+                              char *path,
+                              JNode *pDoc,
+                              int error,
+                              void *arg )
+{
+    JLoadList *pList = (JLoadList *)arg;
+
+    (void)path;
+
+    pList->pDocs[idx] = pDoc;
+    pList->errors[idx] = error;
+}
+
+/*==========================================================================*/
+/*  json_LoadAssemble                                                       */
+/*!
+    Add a loaded file to the result of a directory load
+
+    The json_LoadAssemble function adds a parsed document to the result
+    object under its relative path, and its load time and error to the
+    report.
+
+    @param[in]
+        pObject
+            the result object, which takes ownership of pDoc
+
+    @param[in]
+        pReport
+            the report object, or NULL
+
+    @param[in]
+        name
+            relative path of the file
+
+    @param[in]
+        pDoc
+            the parsed document, or NULL
+
+    @param[in]
+        error
+            the reason the file was not loaded
+
+    @param[in]
+        readUsec
+            read time of the file in microseconds
+
+    @param[in]
+        parseUsec
+            parse time of the file in microseconds
+
+============================================================================*/
+static void json_LoadAssemble( JObject *pObject,
+                               JObject *pReport,
+                               char *name,
+                               JNode *pDoc,
+                               int error,
+                               uint64_t readUsec,
+                               uint64_t parseUsec )
+{
+    JObject *pEntry;
+
+    if( pDoc != NULL )
+    {
+        free( pDoc->name );
+        pDoc->name = strdup( name );
+        if( ( pDoc->name == NULL ) ||
+            ( JSON_ObjectAdd( pObject, pDoc ) != EOK ) )
+        {
+            JSON_Free( pDoc );
+        }
+    }
+
+    if( pReport != NULL )
+    {
+        pEntry = JSON_Object( strdup( name ) );
+        if( pEntry != NULL )
+        {
+            /* times are stored as 64-bit integers since JSON_Num
+               would truncate them to an int */
+            JSON_SetI64( (JNode *)pEntry, "read_usec", (int64_t)readUsec );
+            JSON_SetI64( (JNode *)pEntry, "parse_usec", (int64_t)parseUsec );
+            JSON_ObjectAdd( pEntry,
+                            (JNode *)JSON_Num( strdup( "error" ), error ) );
+            if( JSON_ObjectAdd( pReport, (JNode *)pEntry ) != EOK )
+            {
+                JSON_Free( (JNode *)pEntry );
+            }
+        }
+    }
+}
@@ -16,8 +16,14 @@ extern char *yytext;
 /* input file for lex */
 extern FILE *yyin;
 
-/* error flag */
-static bool errorFlag = false;
+/* length of the token text */
+extern int yyleng;
+
+/* line number of the scanner */
+extern int yylineno;
+
+/* number of input characters consumed by the scanner */
+extern size_t json_lexOffset;
 
 /* define the parser object to be a JNode pointer */
 #define YYSTYPE JNode *
@@ -25,11 +31,31 @@ static bool errorFlag = false;
 #define YYDEBUG 1
 
 /* function declarations */
-void yyerror();
+void yyerror( const char *msg );
 static char *get_charstr( char *str );
 static char escape( char c );
 int yylex();
 
+/* pack a small container into a single allocation */
+extern JNode *json_SmallPack( JNode *pNode );
+
+/* duplicate a string for a JSON node */
+extern char *json_StrDup( char *str, size_t len );
+
+/* free a string which was not attached to a node */
+extern void json_StrFree( char *str );
+
+/* enforce the nesting and container limits of the parse */
+extern int json_ParseEnter( JType type );
+extern void json_ParseLeave( void );
+extern int json_ParseMember( JNode *pContainer );
+
+/* append an element to an array, or pass it to a stream */
+extern int json_ParseAppend( JNode *pArray, JNode *pElement );
+
+/* record a syntax error */
+extern void json_ParseSyntax( const char *msg, size_t offset, size_t line );
+
 /* root of the parsed JSON object */
 JNode *root;
 
@@ -38,96 +64,175 @@ extern int yydebug;
 
 %}
 
-%token LBRACE
-%token RBRACE
-%token LBRACKET
-%token RBRACKET
+/* describe syntax errors by the unexpected and expected tokens */
+%define parse.error verbose
+
+%initial-action
+{
+    json_lexOffset = 0;
+    yylineno = 1;
+}
+
+%token LBRACE "left brace"
+%token RBRACE "right brace"
+%token LBRACKET "left bracket"
+%token RBRACKET "right bracket"
+
+%token COMMA "comma"
+%token SEMI "semicolon"
+%token DQUOTE "double quote"
+%token DOT "dot"
+%token COLON "colon"
 
-%token COMMA
-%token SEMI
-%token DQUOTE
-%token DOT
-%token COLON
+%token ID "identifier"
+%token NUM "integer"
+%token FLOAT "float"
+%token CHARSTR "string"
 
-%token ID
-%token NUM
-%token FLOAT
-%token CHARSTR
+%token TRUE "true"
+%token FALSE "false"
+%token NULLVAL "null"
 
-%token TRUE
-%token FALSE
+%token INVALID "invalid character"
 
+/* release partial trees when the parse is aborted */
+%destructor { JSON_Free( $$ ); } json json_object json_list
+%destructor { JSON_Free( $$ ); } value_list attribute_list attribute value
+%destructor { json_StrFree( (char *)$$ ); } key
 
 %%
 
+document       :  json
+                {
+                    root = $1;
+                }
+               ;
+
 json           :  json_list
 				{
 					$$ = $1;
-					root = $$;
 				}
 			   |  json_object
 			    {
 					$$ = $1;
-					root = $$;
 			    }
 			   ;
 
-json_object    :  LBRACE attribute_list RBRACE
+json_object    :  lbrace attribute_list RBRACE
 			    {
-                    JObject *pObject;
-					pObject = JSON_Object( NULL );
-                    if( pObject != NULL )
-                    {
-                        pObject->pFirst = $2;
-                        $$ = &pObject->node;
-                    }
-                    else
+                    json_ParseLeave();
+					$$ = json_SmallPack( $2 );
+			    }
+			   |  lbrace RBRACE
+			    {
+                    json_ParseLeave();
+					$$ = (JNode *)JSON_Object( NULL );
+                    if( $$ == NULL )
                     {
-                        $$ = NULL;
+                        YYABORT;
                     }
 			    }
 			   ;
 
-json_list      : LBRACKET value_list RBRACKET
+json_list      : lbracket value_list RBRACKET
 			    {
-                    JArray *pArray;
-                    JNode *pNode;
-
-					pArray = JSON_Array( NULL );
-                    if( pArray != NULL )
+                    json_ParseLeave();
+					$$ = json_SmallPack( $2 );
+			    }
+			   | lbracket RBRACKET
+			    {
+                    json_ParseLeave();
+					$$ = (JNode *)JSON_Array( NULL );
+                    if( $$ == NULL )
                     {
-                        pArray->pFirst = $2;
-                        pNode = pArray->pFirst;
-                        while ( pNode != NULL )
-                        {
-                            pArray->n++;
-                            pNode = pNode->pNext;
-                        }
-
-                        $$ = &pArray->node;
+                        YYABORT;
                     }
 			    }
 			   ;
 
-value_list    : value COMMA value_list
+lbrace         :  LBRACE
+                {
+                    if( json_ParseEnter( JSON_OBJECT ) != EOK )
+                    {
+                        YYABORT;
+                    }
+                }
+               ;
+
+lbracket       :  LBRACKET
                 {
+                    if( json_ParseEnter( JSON_ARRAY ) != EOK )
+                    {
+                        YYABORT;
+                    }
+                }
+               ;
+
+value_list    : value_list COMMA value
+                {
+                    /* append to the array so its count and last element
+                       are maintained as it is built.  The symbols of an
+                       aborted rule are not destroyed by the parser, and
+                       the element has been consumed, so release the
+                       array here */
+                    if( json_ParseAppend( $1, $3 ) != EOK )
+                    {
+                        JSON_Free( $1 );
+                        YYABORT;
+                    }
+
                     $$ = $1;
-                    $1->pNext = $3;
                 }
               | value
                 {
-                    $$ = $1;
+                    JArray *pArray;
+
+                    pArray = JSON_Array( NULL );
+                    if( pArray == NULL )
+                    {
+                        JSON_Free( $1 );
+                        YYABORT;
+                    }
+
+                    if( json_ParseAppend( (JNode *)pArray, $1 ) != EOK )
+                    {
+                        JSON_Free( (JNode *)pArray );
+                        YYABORT;
+                    }
+
+                    $$ = (JNode *)pArray;
                 }
               ;
 
-attribute_list : attribute COMMA attribute_list
+attribute_list : attribute_list COMMA attribute
 				{
+                    /* the symbols of an aborted rule are not destroyed
+                       by the parser, so release them here */
+                    if( json_ParseMember( $1 ) != EOK )
+                    {
+                        JSON_Free( $1 );
+                        JSON_Free( $3 );
+                        YYABORT;
+                    }
+
+                    /* append to the object so its count and
+                       last member are maintained as it is built */
+                    JSON_ObjectAdd( (JObject *)$1, $3 );
 					$$ = $1;
-					$1->pNext = $3;
 				}
 			   |  attribute
 				{
-					$$ = $1;
+                    JObject *pObject;
+
+                    pObject = JSON_Object( NULL );
+                    if( pObject == NULL )
+                    {
+                        JSON_Free( $1 );
+                        YYABORT;
+                    }
+
+                    JSON_ObjectAdd( pObject, $1 );
+					$$ = (JNode *)pObject;
 				}
 			   ;
 
@@ -141,28 +246,69 @@ attribute      : key COLON value
 key            :  CHARSTR
 				{
 					$$ = (JNode *)get_charstr( yytext );
+                    if( $$ == NULL )
+                    {
+                        YYABORT;
+                    }
 				}
 			   ;
 
 value          : NUM
 				{
 					$$ = (JNode *)JSON_ParseNumber( NULL, yytext );
+                    if( $$ == NULL )
+                    {
+                        YYABORT;
+                    }
 				}
 			   | FLOAT
 				{
 					$$ = (JNode *)JSON_Float( NULL, atof( yytext ));
+                    if( $$ == NULL )
+                    {
+                        YYABORT;
+                    }
 				}
 			   | TRUE
 				{
 					$$ = (JNode *)JSON_Bool( NULL, 1 );
+                    if( $$ == NULL )
+                    {
+                        YYABORT;
+                    }
 				}
 			   | FALSE
 				{
 					$$ = (JNode *)JSON_Bool( NULL, 0 );
+                    if( $$ == NULL )
+                    {
+                        YYABORT;
+                    }
+				}
+			   | NULLVAL
+				{
+					$$ = (JNode *)JSON_Null( NULL );
+                    if( $$ == NULL )
+                    {
+                        YYABORT;
+                    }
 				}
 			   | CHARSTR
 				{
-					$$ = (JNode *)JSON_Str( NULL, get_charstr( yytext ) );
+                    char *str;
+
+                    str = get_charstr( yytext );
+                    if( str == NULL )
+                    {
+                        YYABORT;
+                    }
+
+					$$ = (JNode *)JSON_Str( NULL, str );
+                    if( $$ == NULL )
+                    {
+                        json_StrFree( str );
+                        YYABORT;
+                    }
 				}
 			   | json
 				{
@@ -176,17 +322,28 @@ value          : NUM
 /*==========================================================================*/
 /*  yyerror                                                                 */
 /*!
-	Display syntax error and set error flag to true
+	Record a syntax error
 
     The yyerror function is invoked by the parser when a parse failure
-    occurs.  It outputs a "syntax error" error message and sets the
-    global error flag.
+    occurs.  It records the error description and the position of the
+    offending token for the caller to retrieve.  Nothing is output.
+
+    @param[in]
+        msg
+            description of the error
 
 ============================================================================*/
-void yyerror()
+void yyerror( const char *msg )
 {
-	printf("syntax error\n");
-    errorFlag = true;
+    size_t offset = json_lexOffset;
+
+    if( yychar != YYEOF )
+    {
+        /* the offending token has already been consumed */
+        offset -= yyleng;
+    }
+
+    json_ParseSyntax( msg, offset, yylineno );
 }
 
 /*==========================================================================*/
@@ -216,16 +373,15 @@ static char *get_charstr( char *str )
     if( str != NULL )
     {
         /* make a duplicate of the character string (removing the leading
-           double quote) so we can modify it */
-        s = strdup( &str[1] );
+           and trailing double quotes) so we can modify it */
+        l = strlen( str );
+        s = ( l >= 2 ) ? json_StrDup( &str[1], l - 2 ) : NULL;
         if( s != NULL )
         {
-            /* remove the trailing double quotes */
-            l = strlen( s );
-            s[l-1] = 0;
+            l -= 2;
 
             /* handle escaped characters in the string */
-            for ( i = 0; i < l-1 ; i++ )
+            for ( i = 0; i < l ; i++ )
             {
                 /* simple state machine for handling escape processing */
                 switch( state )
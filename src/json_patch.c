@@ -0,0 +1,2630 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! objects with fewer members than this are matched with a linear scan */
+#define JSON_DIFF_INDEX_THRESHOLD   ( 8 )
+
+/*! initial size of the JSON Pointer buffer */
+#define JSON_DIFF_PATH_SIZE         ( 256 )
+
+/*============================================================================
+        External Functions
+============================================================================*/
+
+/*! get the cached structural hash of a container */
+extern bool json_HashCached( JNode *pNode, uint64_t *pHash );
+
+/*! replace a member in the hash index of a JSON object */
+extern void json_IndexReplace( JObject *pObject, JNode *pOld, JNode *pNew );
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! growable JSON Pointer buffer shared by the whole diff */
+typedef struct _JPathBuf
+{
+    /*! NUL terminated JSON Pointer */
+    char *buf;
+
+    /*! length of the JSON Pointer */
+    size_t len;
+
+    /*! allocated size of the buffer */
+    size_t size;
+
+} JPathBuf;
+
+/*! key index slot used to match object members by name */
+typedef struct _JDiffSlot
+{
+    /*! hash of the member name */
+    uint32_t hash;
+
+    /*! true if the member has been matched with a member of the
+        other object */
+    bool matched;
+
+    /*! pointer to the object member, NULL if the slot is empty */
+    JNode *pNode;
+
+} JDiffSlot;
+
+/*! compiled JSON Pointer */
+typedef struct _JPointer
+{
+    /*! number of reference tokens */
+    size_t n;
+
+    /*! unescaped reference tokens */
+    char **tokens;
+
+    /*! storage for the reference tokens */
+    char *buf;
+
+} JPointer;
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static int json_DiffNode( JNode *a, JNode *b, JPathBuf *path, JArray *patch );
+static int json_DiffObject( JObject *a,
+                            JObject *b,
+                            JPathBuf *path,
+                            JArray *patch );
+static int json_DiffObjectIndexed( JObject *a,
+                                   JObject *b,
+                                   size_t nb,
+                                   JPathBuf *path,
+                                   JArray *patch );
+static int json_DiffDuplicates( JObject *pObject, bool *pFound );
+static int json_DiffArray( JArray *a,
+                           JArray *b,
+                           JPathBuf *path,
+                           JArray *patch );
+static int json_DiffOp( JArray *patch, char *op, char *path, JNode *value );
+static JNode *json_DiffStr( char *name, char *str );
+static int json_PathPush( JPathBuf *path, char *name, size_t idx );
+static uint32_t json_DiffHashName( char *name );
+static JNode *json_PatchCopy( JNode *pNode, char *name );
+static int json_PatchOp( JNode *doc, JNode *pOp );
+static int json_PatchMoveCopy( JNode *doc,
+                               char *op,
+                               JPointer *from,
+                               JPointer *path );
+static int json_PatchInsert( JNode *pParent, char *key, JNode *pNode );
+static int json_PatchReplace( JNode *pParent, JNode *pTarget, JNode *pSource );
+static int json_PatchAssign( JVar *pDst, JVar *pSrc );
+static void json_PatchSwap( JNode *pParent, JNode *pOld, JNode *pNew );
+static void json_PatchUnlink( JNode *pParent, JNode *pNode );
+static int json_MergeObject( JObject *pTarget, JObject *pMerge );
+static int json_PersistentStep( JNode *pNode,
+                                char *token,
+                                bool last,
+                                JNode **ppChild );
+static JNode *json_PersistentCopy( JNode *pNode,
+                                   JNode *pOld,
+                                   JNode *pNew,
+                                   char *key );
+static JNode *json_PersistentShare( JNode *pNode );
+static bool json_IsVar( JNode *pNode );
+static bool json_IsReadOnly( JNode *pNode );
+static bool json_PatchWritable( JNode *doc, JPointer *p, size_t n );
+static int json_PointerCompile( char *pointer, JPointer *p );
+static void json_PointerFree( JPointer *p );
+static JNode *json_PointerResolve( JNode *doc, JPointer *p, size_t n );
+static JNode *json_PointerStep( JNode *pNode, char *token );
+static int json_PointerIndex( char *token, size_t *pIdx );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_Diff                                                               */
+/*!
+    Compute the differences between two JSON values
+
+    The JSON_Diff function compares two JSON values and generates a
+    JSON Patch (RFC 6902) which transforms the first into the second.
+    Identical subtrees (shared nodes, or containers whose cached
+    JSON_Hash values match) are skipped, object members are matched by name
+    using a key index for large objects, and array elements are matched
+    by position, so the cost of the diff and the size of the patch are
+    proportional to what changed.
+
+    Only "add", "remove" and "replace" operations are generated.  The
+    values in the patch are copies, so the patch remains valid after
+    both inputs are freed.
+
+    @param[in]
+        a
+            pointer to the original JSON value
+
+    @param[in]
+        b
+            pointer to the updated JSON value
+
+    @retval pointer to a JSON array of patch operations which must be
+            freed by the caller
+    @retval NULL invalid arguments or memory allocation failure
+
+============================================================================*/
+JArray *JSON_Diff( JNode *a, JNode *b )
+{
+    JArray *patch = NULL;
+    JPathBuf path;
+
+    if( ( a != NULL ) &&
+        ( b != NULL ) )
+    {
+        path.len = 0;
+        path.size = JSON_DIFF_PATH_SIZE;
+        path.buf = malloc( path.size );
+        if( path.buf != NULL )
+        {
+            path.buf[0] = 0;
+
+            patch = JSON_Array( NULL );
+            if( patch != NULL )
+            {
+                if( json_DiffNode( a, b, &path, patch ) != EOK )
+                {
+                    JSON_Free( (JNode *)patch );
+                    patch = NULL;
+                }
+            }
+
+            free( path.buf );
+        }
+    }
+
+    return patch;
+}
+
+/*==========================================================================*/
+/*  JSON_ApplyPatch                                                         */
+/*!
+    Apply a JSON Patch to a JSON document in place
+
+    The JSON_ApplyPatch function applies each operation of a JSON Patch
+    (RFC 6902) to the specified document in order.  The document is
+    modified in place: targets are located through compiled JSON
+    Pointers, scalar values and containers being replaced by a value
+    of the same kind are updated without replacing their node, moved
+    values are relinked rather than copied, and the member counts and
+    last member pointers of every modified container are maintained.
+
+    Values are copied out of the patch, so the patch is not modified.
+    Processing stops at the first operation which fails, leaving the
+    operations before it applied.  Operations which would replace the
+    document root with a value of a different kind, or remove it, are
+    not supported since the root node is owned by the caller.
+
+    @param[in]
+        doc
+            pointer to the JSON document to patch
+
+    @param[in]
+        patch
+            pointer to a JSON array of patch operations
+
+    @retval EOK the patch was applied
+    @retval EINVAL invalid arguments or a malformed patch operation,
+            including one which repeats a member name
+    @retval ENOENT a patch operation refers to a value which does not exist
+    @retval ENOTSUP a patch operation would replace or remove the root
+    @retval ECANCELED a test operation failed
+    @retval EPERM the document is a read-only clone, or a patch operation
+            would modify a container shared with a persistent version
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int JSON_ApplyPatch( JNode *doc, JArray *patch )
+{
+    int result = EINVAL;
+    JNode *pOp;
+    bool duplicates = false;
+
+    if( ( doc != NULL ) &&
+        ( patch != NULL ) &&
+        ( patch->node.type == JSON_ARRAY ) )
+    {
+        result = ( json_IsReadOnly( doc ) == false ) ? EOK : EPERM;
+
+        pOp = patch->pFirst;
+        while( ( pOp != NULL ) && ( result == EOK ) )
+        {
+            /* an operation which repeats a member, such as "op", is
+               ambiguous and so is rejected (RFC 6902 appendix A.13) */
+            result = ( pOp->type == JSON_OBJECT )
+                     ? json_DiffDuplicates( (JObject *)pOp, &duplicates )
+                     : EINVAL;
+            if( ( result == EOK ) && ( duplicates == true ) )
+            {
+                result = EINVAL;
+            }
+
+            if( result == EOK )
+            {
+                result = json_PatchOp( doc, pOp );
+            }
+
+            pOp = pOp->pNext;
+        }
+
+        /* the document was modified directly */
+        JSON_HashInvalidate();
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_MergePatch                                                         */
+/*!
+    Apply a JSON Merge Patch to a JSON document in place
+
+    The JSON_MergePatch function applies a JSON Merge Patch (RFC 7396)
+    to the specified document.  Members of the merge object replace or
+    are added to the corresponding members of the document, nested
+    objects are merged recursively, and members whose value is null
+    are removed.  As with JSON_ApplyPatch, existing nodes are reused
+    wherever the replacement value is of the same kind.
+
+    @param[in]
+        doc
+            pointer to the JSON document to patch
+
+    @param[in]
+        merge
+            pointer to the JSON Merge Patch
+
+    @retval EOK the merge patch was applied
+    @retval EINVAL invalid arguments
+    @retval ENOTSUP the merge patch would change the kind of the root
+    @retval EPERM the document is a read-only clone, or the merge patch
+            would modify a container shared with a persistent version
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int JSON_MergePatch( JNode *doc, JNode *merge )
+{
+    int result = EINVAL;
+
+    if( ( doc != NULL ) &&
+        ( merge != NULL ) )
+    {
+        if( json_IsReadOnly( doc ) == true )
+        {
+            result = EPERM;
+        }
+        else if( merge->type != JSON_OBJECT )
+        {
+            result = json_PatchReplace( NULL, doc, merge );
+        }
+        else if( doc->type == JSON_OBJECT )
+        {
+            result = json_MergeObject( (JObject *)doc, (JObject *)merge );
+        }
+        else
+        {
+            result = ENOTSUP;
+        }
+
+        /* the document was modified directly */
+        JSON_HashInvalidate();
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_SetPathPersistent                                                  */
+/*!
+    Create a new version of a JSON document with one value set
+
+    The JSON_SetPathPersistent function returns a new version of the
+    document in which the value at the specified JSON Pointer (RFC 6901)
+    is set, leaving the original document unchanged.  Only the containers
+    along the path are copied.  Every other object or array is shared
+    with the original through a small header which references the
+    original node (see JSON_Retain), and scalar members of the copied
+    containers are duplicated.  A new version therefore costs one node
+    per member of each container on the path, independent of the size
+    of the subtrees beneath them.
+
+    As with the JSON Patch "add" operation, the parent of the target
+    must exist.  An existing object member or array element is replaced,
+    a new object member is appended, and "-" or an index equal to the
+    array size appends to the array.  An empty path replaces the whole
+    document.
+
+    Each version must be freed with JSON_Free, in any order.  Once a
+    version has been created, neither it nor the original may be
+    modified in place: they may only be updated by creating further
+    versions.  The containers whose members are shared are marked with
+    JSON_NODE_SHARED, and the mutators, JSON_ApplyPatch and
+    JSON_MergePatch fail with EPERM for them; values nested beneath a
+    shared container are not marked, so the caller must not modify them.
+
+    @param[in]
+        root
+            pointer to the current version of the JSON document
+
+    @param[in]
+        path
+            JSON Pointer to the value to set
+
+    @param[in]
+        value
+            pointer to the new value, which is consumed by this
+            function even if it fails
+
+    @retval pointer to the new version of the JSON document
+    @retval NULL invalid arguments, the path does not exist, or memory
+            allocation failure
+
+============================================================================*/
+JNode *JSON_SetPathPersistent( JNode *root, char *path, JNode *value )
+{
+    JNode *newRoot = NULL;
+    JNode **nodes = NULL;
+    JPointer p;
+    size_t i;
+    int result;
+
+    if( ( root != NULL ) &&
+        ( path != NULL ) &&
+        ( value != NULL ) )
+    {
+        result = json_PointerCompile( path, &p );
+        if( result == EOK )
+        {
+            nodes = malloc( ( p.n + 1 ) * sizeof( JNode * ) );
+            result = ( nodes != NULL ) ? EOK : ENOMEM;
+        }
+
+        if( result == EOK )
+        {
+            /* resolve the nodes along the path */
+            nodes[0] = root;
+            for( i = 0; ( i < p.n ) && ( result == EOK ); i++ )
+            {
+                result = json_PersistentStep( nodes[i],
+                                              p.tokens[i],
+                                              ( i + 1 ) == p.n,
+                                              &nodes[i + 1] );
+            }
+        }
+
+        if( result == EOK )
+        {
+            /* copy the path from the bottom up */
+            newRoot = value;
+            value = NULL;
+            for( i = p.n; ( i > 0 ) && ( newRoot != NULL ); i-- )
+            {
+                newRoot = json_PersistentCopy( nodes[i - 1],
+                                               nodes[i],
+                                               newRoot,
+                                               p.tokens[i - 1] );
+            }
+
+            if( ( newRoot != NULL ) &&
+                ( p.n > 0 ) &&
+                ( root->name != NULL ) )
+            {
+                newRoot->name = strdup( root->name );
+                if( newRoot->name == NULL )
+                {
+                    JSON_Free( newRoot );
+                    newRoot = NULL;
+                }
+            }
+        }
+
+        free( nodes );
+        json_PointerFree( &p );
+    }
+
+    /* free the value if it was not used */
+    JSON_Free( value );
+
+    return newRoot;
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_DiffNode                                                           */
+/*!
+    Compute the differences between two JSON values
+
+    The json_DiffNode function compares two JSON values located at the
+    specified path and appends the operations needed to transform the
+    first into the second to the patch.
+
+    @param[in]
+        a
+            pointer to the original JSON value
+
+    @param[in]
+        b
+            pointer to the updated JSON value
+
+    @param[in]
+        path
+            JSON Pointer of the values being compared
+
+    @param[in]
+        patch
+            JSON Patch to append operations to
+
+    @retval EOK the comparison completed
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_DiffNode( JNode *a, JNode *b, JPathBuf *path, JArray *patch )
+{
+    int result = EOK;
+    uint64_t ha;
+    uint64_t hb;
+
+    if( a == b )
+    {
+        /* shared subtree, nothing to do */
+    }
+    else if( ( a->type == b->type ) &&
+             ( ( a->type == JSON_OBJECT ) || ( a->type == JSON_ARRAY ) ) &&
+             ( ((JObject *)a)->pFirst == ((JObject *)b)->pFirst ) &&
+             ( ((JObject *)a)->n == ((JObject *)b)->n ) )
+    {
+        /* versions of a container sharing the same members */
+    }
+    else if( ( json_HashCached( a, &ha ) == true ) &&
+             ( json_HashCached( b, &hb ) == true ) &&
+             ( ha == hb ) )
+    {
+        /* subtrees with identical cached hashes are unchanged */
+    }
+    else if( a->type != b->type )
+    {
+        result = json_DiffOp( patch, "replace", path->buf, b );
+    }
+    else
+    {
+        switch( a->type )
+        {
+            case JSON_OBJECT:
+                result = json_DiffObject( (JObject *)a,
+                                          (JObject *)b,
+                                          path,
+                                          patch );
+                break;
+
+            case JSON_ARRAY:
+                result = json_DiffArray( (JArray *)a,
+                                         (JArray *)b,
+                                         path,
+                                         patch );
+                break;
+
+            case JSON_NULL:
+            case JSON_BOOL:
+            case JSON_VAR:
+                if( JSON_Equal( a, b ) == false )
+                {
+                    result = json_DiffOp( patch, "replace", path->buf, b );
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DiffObject                                                         */
+/*!
+    Compute the differences between two JSON objects
+
+    The json_DiffObject function matches the members of two JSON objects
+    by name.  Small objects are matched with a linear scan, larger objects
+    are matched through a temporary key index so the comparison is linear
+    in the number of members.  Only the first of several members with the
+    same name can be addressed by a JSON Pointer, so an object in which a
+    name is repeated is replaced as a whole.
+
+    @param[in]
+        a
+            pointer to the original JSON object
+
+    @param[in]
+        b
+            pointer to the updated JSON object
+
+    @param[in]
+        path
+            JSON Pointer of the objects being compared
+
+    @param[in]
+        patch
+            JSON Patch to append operations to
+
+    @retval EOK the comparison completed
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_DiffObject( JObject *a,
+                            JObject *b,
+                            JPathBuf *path,
+                            JArray *patch )
+{
+    int result = EOK;
+    JNode *pA;
+    JNode *pB;
+    JNode *pMatch;
+    size_t nb = 0;
+    size_t len = path->len;
+    bool duplicates = false;
+
+    for( pB = b->pFirst; pB != NULL; pB = pB->pNext )
+    {
+        nb++;
+    }
+
+    pA = NULL;
+    pB = NULL;
+
+    result = json_DiffDuplicates( a, &duplicates );
+    if( ( result == EOK ) && ( duplicates == false ) )
+    {
+        result = json_DiffDuplicates( b, &duplicates );
+    }
+
+    if( result != EOK )
+    {
+        /* could not check for repeated names */
+    }
+    else if( duplicates == true )
+    {
+        result = json_DiffOp( patch, "replace", path->buf, (JNode *)b );
+    }
+    else if( nb >= JSON_DIFF_INDEX_THRESHOLD )
+    {
+        /* large object, match members through a key index */
+        result = json_DiffObjectIndexed( a, b, nb, path, patch );
+    }
+    else
+    {
+        pA = a->pFirst;
+        pB = b->pFirst;
+    }
+
+    /* removed and modified members */
+    while( ( pA != NULL ) && ( result == EOK ) )
+    {
+        result = json_PathPush( path, pA->name, 0 );
+        if( result == EOK )
+        {
+            pMatch = JSON_Attribute( b, pA->name );
+            result = ( pMatch == NULL )
+                     ? json_DiffOp( patch, "remove", path->buf, NULL )
+                     : json_DiffNode( pA, pMatch, path, patch );
+        }
+
+        path->len = len;
+        path->buf[len] = 0;
+        pA = pA->pNext;
+    }
+
+    /* added members */
+    while( ( pB != NULL ) && ( result == EOK ) )
+    {
+        if( JSON_Attribute( a, pB->name ) == NULL )
+        {
+            result = json_PathPush( path, pB->name, 0 );
+            if( result == EOK )
+            {
+                result = json_DiffOp( patch, "add", path->buf, pB );
+            }
+
+            path->len = len;
+            path->buf[len] = 0;
+        }
+
+        pB = pB->pNext;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DiffObjectIndexed                                                  */
+/*!
+    Compute the differences between two large JSON objects
+
+    The json_DiffObjectIndexed function builds an open addressing index
+    of the updated object's members keyed by name, looks up each member
+    of the original object in it, and reports any members of the updated
+    object which were not matched as additions.
+
+    @param[in]
+        a
+            pointer to the original JSON object
+
+    @param[in]
+        b
+            pointer to the updated JSON object
+
+    @param[in]
+        nb
+            number of members in the updated JSON object
+
+    @param[in]
+        path
+            JSON Pointer of the objects being compared
+
+    @param[in]
+        patch
+            JSON Patch to append operations to
+
+    @retval EOK the comparison completed
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_DiffObjectIndexed( JObject *a,
+                                   JObject *b,
+                                   size_t nb,
+                                   JPathBuf *path,
+                                   JArray *patch )
+{
+    int result = EOK;
+    JDiffSlot *index;
+    JDiffSlot *pSlot;
+    size_t size = 1;
+    size_t mask;
+    size_t i;
+    uint32_t hash;
+    JNode *pNode;
+    size_t len = path->len;
+
+    /* keep the load factor at or below 50% */
+    while( size < ( nb * 2 ) )
+    {
+        size <<= 1;
+    }
+
+    mask = size - 1;
+
+    index = calloc( size, sizeof( JDiffSlot ) );
+    if( index == NULL )
+    {
+        result = ENOMEM;
+    }
+
+    for( pNode = ( index != NULL ) ? b->pFirst : NULL;
+         pNode != NULL;
+         pNode = pNode->pNext )
+    {
+        hash = json_DiffHashName( pNode->name );
+        i = hash & mask;
+        while( index[i].pNode != NULL )
+        {
+            i = ( i + 1 ) & mask;
+        }
+
+        index[i].hash = hash;
+        index[i].pNode = pNode;
+    }
+
+    /* removed and modified members */
+    pNode = a->pFirst;
+    while( ( pNode != NULL ) && ( result == EOK ) )
+    {
+        hash = json_DiffHashName( pNode->name );
+        pSlot = NULL;
+        for( i = hash & mask; index[i].pNode != NULL; i = ( i + 1 ) & mask )
+        {
+            if( ( index[i].hash == hash ) &&
+                ( index[i].matched == false ) &&
+                ( strcmp( index[i].pNode->name, pNode->name ) == 0 ) )
+            {
+                pSlot = &index[i];
+                break;
+            }
+        }
+
+        result = json_PathPush( path, pNode->name, 0 );
+        if( result == EOK )
+        {
+            if( pSlot == NULL )
+            {
+                result = json_DiffOp( patch, "remove", path->buf, NULL );
+            }
+            else
+            {
+                pSlot->matched = true;
+                result = json_DiffNode( pNode, pSlot->pNode, path, patch );
+            }
+        }
+
+        path->len = len;
+        path->buf[len] = 0;
+        pNode = pNode->pNext;
+    }
+
+    /* added members, in the order they appear in the updated object */
+    pNode = b->pFirst;
+    while( ( pNode != NULL ) && ( result == EOK ) )
+    {
+        hash = json_DiffHashName( pNode->name );
+        for( i = hash & mask; index[i].pNode != pNode; i = ( i + 1 ) & mask )
+        {
+        }
+
+        if( index[i].matched == false )
+        {
+            result = json_PathPush( path, pNode->name, 0 );
+            if( result == EOK )
+            {
+                result = json_DiffOp( patch, "add", path->buf, pNode );
+            }
+
+            path->len = len;
+            path->buf[len] = 0;
+        }
+
+        pNode = pNode->pNext;
+    }
+
+    free( index );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DiffDuplicates                                                     */
+/*!
+    Check a JSON object for repeated member names
+
+    The json_DiffDuplicates function checks if two or more members of a
+    JSON object have the same name.  Small objects are checked with a
+    linear scan, larger objects through a temporary key index.
+
+    @param[in]
+        pObject
+            pointer to the JSON object
+
+    @param[out]
+        pFound
+            set to true if a name is repeated
+
+    @retval EOK the object was checked
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_DiffDuplicates( JObject *pObject, bool *pFound )
+{
+    int result = EOK;
+    JDiffSlot *index = NULL;
+    JNode *pNode;
+    JNode *pOther;
+    size_t n = 0;
+    size_t size = 1;
+    size_t mask;
+    size_t i;
+    uint32_t hash;
+
+    *pFound = false;
+
+    for( pNode = pObject->pFirst; pNode != NULL; pNode = pNode->pNext )
+    {
+        n++;
+    }
+
+    if( n >= JSON_DIFF_INDEX_THRESHOLD )
+    {
+        /* keep the load factor at or below 50% */
+        while( size < ( n * 2 ) )
+        {
+            size <<= 1;
+        }
+
+        index = calloc( size, sizeof( JDiffSlot ) );
+        if( index == NULL )
+        {
+            result = ENOMEM;
+        }
+    }
+
+    mask = size - 1;
+
+    pNode = ( result == EOK ) ? pObject->pFirst : NULL;
+    while( ( pNode != NULL ) && ( *pFound == false ) )
+    {
+        if( index == NULL )
+        {
+            for( pOther = pNode->pNext;
+                 ( pOther != NULL ) && ( *pFound == false );
+                 pOther = pOther->pNext )
+            {
+                *pFound = ( pNode->name != NULL ) &&
+                          ( pOther->name != NULL ) &&
+                          ( strcmp( pNode->name, pOther->name ) == 0 );
+            }
+        }
+        else
+        {
+            hash = json_DiffHashName( pNode->name );
+            for( i = hash & mask;
+                 ( index[i].pNode != NULL ) && ( *pFound == false );
+                 i = ( i + 1 ) & mask )
+            {
+                *pFound = ( index[i].hash == hash ) &&
+                          ( pNode->name != NULL ) &&
+                          ( index[i].pNode->name != NULL ) &&
+                          ( strcmp( index[i].pNode->name,
+                                    pNode->name ) == 0 );
+            }
+
+            if( *pFound == false )
+            {
+                index[i].hash = hash;
+                index[i].pNode = pNode;
+            }
+        }
+
+        pNode = pNode->pNext;
+    }
+
+    free( index );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DiffArray                                                          */
+/*!
+    Compute the differences between two JSON arrays
+
+    The json_DiffArray function compares array elements by position.
+    Elements appended to the updated array are reported as additions,
+    and elements truncated from the end of the original array are
+    reported as removals from the highest index down so that each
+    removal path remains valid when the patch is applied in order.
+
+    @param[in]
+        a
+            pointer to the original JSON array
+
+    @param[in]
+        b
+            pointer to the updated JSON array
+
+    @param[in]
+        path
+            JSON Pointer of the arrays being compared
+
+    @param[in]
+        patch
+            JSON Patch to append operations to
+
+    @retval EOK the comparison completed
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_DiffArray( JArray *a, JArray *b, JPathBuf *path, JArray *patch )
+{
+    int result = EOK;
+    JNode *pA = a->pFirst;
+    JNode *pB = b->pFirst;
+    size_t idx = 0;
+    size_t na;
+    size_t len = path->len;
+
+    while( ( pA != NULL ) && ( pB != NULL ) && ( result == EOK ) )
+    {
+        result = json_PathPush( path, NULL, idx );
+        if( result == EOK )
+        {
+            result = json_DiffNode( pA, pB, path, patch );
+        }
+
+        path->len = len;
+        path->buf[len] = 0;
+        pA = pA->pNext;
+        pB = pB->pNext;
+        idx++;
+    }
+
+    /* appended elements */
+    while( ( pB != NULL ) && ( result == EOK ) )
+    {
+        result = json_PathPush( path, NULL, idx );
+        if( result == EOK )
+        {
+            result = json_DiffOp( patch, "add", path->buf, pB );
+        }
+
+        path->len = len;
+        path->buf[len] = 0;
+        pB = pB->pNext;
+        idx++;
+    }
+
+    /* truncated elements */
+    for( na = idx; pA != NULL; pA = pA->pNext )
+    {
+        na++;
+    }
+
+    while( ( na > idx ) && ( result == EOK ) )
+    {
+        na--;
+        result = json_PathPush( path, NULL, na );
+        if( result == EOK )
+        {
+            result = json_DiffOp( patch, "remove", path->buf, NULL );
+        }
+
+        path->len = len;
+        path->buf[len] = 0;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DiffOp                                                             */
+/*!
+    Append an operation to a JSON Patch
+
+    The json_DiffOp function creates a JSON Patch operation object
+    of the form { "op" : op, "path" : path, "value" : value } and
+    appends it to the patch.
+
+    @param[in]
+        patch
+            JSON Patch to append the operation to
+
+    @param[in]
+        op
+            name of the operation
+
+    @param[in]
+        path
+            JSON Pointer the operation applies to
+
+    @param[in]
+        value
+            value to copy into the operation, or NULL for no value
+
+    @retval EOK the operation was appended
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_DiffOp( JArray *patch, char *op, char *path, JNode *value )
+{
+    int result = ENOMEM;
+    JObject *pOp;
+    JNode *pValue = NULL;
+
+    pOp = JSON_Object( NULL );
+    if( pOp != NULL )
+    {
+        if( value != NULL )
+        {
+            pValue = json_PatchCopy( value, "value" );
+        }
+
+        if( ( JSON_ObjectAdd( pOp, json_DiffStr( "op", op ) ) == EOK ) &&
+            ( JSON_ObjectAdd( pOp, json_DiffStr( "path", path ) ) == EOK ) &&
+            ( ( value == NULL ) ||
+              ( JSON_ObjectAdd( pOp, pValue ) == EOK ) ) )
+        {
+            result = JSON_ArrayAdd( patch, pOp );
+        }
+        else
+        {
+            JSON_Free( pValue );
+            JSON_Free( (JNode *)pOp );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DiffStr                                                            */
+/*!
+    Create a named JSON string value
+
+    The json_DiffStr function creates a JSON string variable from copies
+    of the specified name and value.
+
+    @param[in]
+        name
+            name of the JSON string variable
+
+    @param[in]
+        str
+            value of the JSON string variable
+
+    @retval pointer to the new JSON string variable
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static JNode *json_DiffStr( char *name, char *str )
+{
+    JVar *pVar = NULL;
+    char *n;
+    char *v;
+
+    n = strdup( name );
+    v = strdup( str );
+    if( ( n != NULL ) &&
+        ( v != NULL ) )
+    {
+        pVar = JSON_Str( n, v );
+    }
+
+    if( pVar == NULL )
+    {
+        free( n );
+        free( v );
+    }
+
+    return (JNode *)pVar;
+}
+
+/*==========================================================================*/
+/*  json_PathPush                                                           */
+/*!
+    Append a reference token to a JSON Pointer
+
+    The json_PathPush function appends a reference token to the JSON
+    Pointer buffer, growing it as required.  If a name is specified it
+    is escaped as per RFC 6901 ( '~' becomes "~0" and '/' becomes "~1" ),
+    otherwise the array index is used.  The caller restores the previous
+    length to pop the token.
+
+    @param[in]
+        path
+            JSON Pointer buffer
+
+    @param[in]
+        name
+            name of the object member, or NULL for an array element
+
+    @param[in]
+        idx
+            index of the array element
+
+    @retval EOK the token was appended
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_PathPush( JPathBuf *path, char *name, size_t idx )
+{
+    int result = EOK;
+    size_t need;
+    size_t size;
+    char *buf;
+    char *p;
+
+    /* worst case every character is escaped */
+    need = path->len + 2 + ( ( name != NULL ) ? 2 * strlen( name ) : 21 );
+    if( need > path->size )
+    {
+        size = path->size * 2;
+        while( size < need )
+        {
+            size *= 2;
+        }
+
+        buf = realloc( path->buf, size );
+        if( buf != NULL )
+        {
+            path->buf = buf;
+            path->size = size;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if( ( result == EOK ) &&
+        ( name != NULL ) )
+    {
+        path->buf[path->len++] = '/';
+        for( p = name; *p != 0; p++ )
+        {
+            if( *p == '~' )
+            {
+                path->buf[path->len++] = '~';
+                path->buf[path->len++] = '0';
+            }
+            else if( *p == '/' )
+            {
+                path->buf[path->len++] = '~';
+                path->buf[path->len++] = '1';
+            }
+            else
+            {
+                path->buf[path->len++] = *p;
+            }
+        }
+
+        path->buf[path->len] = 0;
+    }
+    else if( result == EOK )
+    {
+        path->len += sprintf( &path->buf[path->len], "/%zu", idx );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_DiffHashName                                                       */
+/*!
+    Hash an object member name
+
+    The json_DiffHashName function computes the 32-bit FNV-1a hash
+    of an object member name.
+
+    @param[in]
+        name
+            pointer to the NUL terminated member name
+
+    @retval hash of the member name
+
+============================================================================*/
+static uint32_t json_DiffHashName( char *name )
+{
+    uint32_t hash = 2166136261u;
+
+    if( name != NULL )
+    {
+        while( *name != 0 )
+        {
+            hash ^= (uint8_t)*name++;
+            hash *= 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+/*==========================================================================*/
+/*  json_PatchCopy                                                          */
+/*!
+    Make a deep copy of a JSON value
+
+    The json_PatchCopy function recursively copies a JSON value, giving
+    the copy the specified name.
+
+    @param[in]
+        pNode
+            pointer to the JSON value to copy
+
+    @param[in]
+        name
+            name to give the copy, or NULL for no name
+
+    @retval pointer to the copy which must be freed by the caller
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static JNode *json_PatchCopy( JNode *pNode, char *name )
+{
+    JNode *pCopy = NULL;
+    JNode *pChild;
+    JNode *pChildCopy;
+    JVar *pVar;
+    JVar *pVarCopy;
+    char *copyname = NULL;
+    bool ok = true;
+
+    if( name != NULL )
+    {
+        copyname = strdup( name );
+        ok = ( copyname != NULL );
+    }
+
+    switch( ( ok == true ) ? pNode->type : JSON_INVALID )
+    {
+        case JSON_OBJECT:
+        case JSON_ARRAY:
+            pCopy = ( pNode->type == JSON_OBJECT )
+                    ? (JNode *)JSON_Object( copyname )
+                    : (JNode *)JSON_Array( copyname );
+            if( pCopy != NULL )
+            {
+                pChild = ((JObject *)pNode)->pFirst;
+                while( ( pChild != NULL ) && ( ok == true ) )
+                {
+                    pChildCopy = json_PatchCopy( pChild, pChild->name );
+                    if( pChildCopy == NULL )
+                    {
+                        ok = false;
+                    }
+                    else if( pNode->type == JSON_OBJECT )
+                    {
+                        JSON_ObjectAdd( (JObject *)pCopy, pChildCopy );
+                    }
+                    else
+                    {
+                        JSON_ArrayAdd( (JArray *)pCopy, (JObject *)pChildCopy );
+                    }
+
+                    pChild = pChild->pNext;
+                }
+            }
+            break;
+
+        case JSON_NULL:
+        case JSON_BOOL:
+        case JSON_VAR:
+            pVar = (JVar *)pNode;
+            pVarCopy = JSON_Var( copyname );
+            if( pVarCopy != NULL )
+            {
+                pVarCopy->node.type = pNode->type;
+                pVarCopy->var = pVar->var;
+                if( ( pVar->var.type == JVARTYPE_STR ) &&
+                    ( pVar->var.val.str != NULL ) )
+                {
+                    pVarCopy->var.val.str = strdup( pVar->var.val.str );
+                    ok = ( pVarCopy->var.val.str != NULL );
+                }
+            }
+            pCopy = (JNode *)pVarCopy;
+            break;
+
+        default:
+            break;
+    }
+
+    if( pCopy == NULL )
+    {
+        free( copyname );
+    }
+    else if( ok == false )
+    {
+        JSON_Free( pCopy );
+        pCopy = NULL;
+    }
+
+    return pCopy;
+}
+
+/*==========================================================================*/
+/*  json_PatchOp                                                            */
+/*!
+    Apply a single JSON Patch operation
+
+    The json_PatchOp function decodes a JSON Patch operation object
+    and applies it to the document.
+
+    @param[in]
+        doc
+            pointer to the JSON document to patch
+
+    @param[in]
+        pOp
+            pointer to the JSON Patch operation object
+
+    @retval EOK the operation was applied
+    @retval EINVAL malformed patch operation
+    @retval ENOENT the operation refers to a value which does not exist
+    @retval ENOTSUP the operation would replace or remove the root
+    @retval ECANCELED a test operation failed
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_PatchOp( JNode *doc, JNode *pOp )
+{
+    int result;
+    char *op;
+    JNode *value;
+    JPointer path;
+    JPointer from;
+    JNode *pParent = NULL;
+    JNode *pTarget = NULL;
+    JNode *pNode;
+    char *key = NULL;
+
+    op = JSON_GetStr( pOp, "op" );
+    value = JSON_Attribute( (JObject *)pOp, "value" );
+
+    result = json_PointerCompile( JSON_GetStr( pOp, "path" ), &path );
+    if( result != EOK )
+    {
+        /* malformed path */
+    }
+    else if( path.n == 0 )
+    {
+        pTarget = doc;
+    }
+    else
+    {
+        key = path.tokens[path.n - 1];
+        pParent = json_PointerResolve( doc, &path, path.n - 1 );
+        if( pParent != NULL )
+        {
+            pTarget = json_PointerStep( pParent, key );
+        }
+    }
+
+    if( result != EOK )
+    {
+        /* path could not be compiled */
+    }
+    else if( op == NULL )
+    {
+        result = EINVAL;
+    }
+    else if( ( pParent == NULL ) && ( path.n > 0 ) )
+    {
+        result = ENOENT;
+    }
+    else if( ( strcmp( op, "test" ) != 0 ) &&
+             ( json_PatchWritable( doc,
+                                   &path,
+                                   ( path.n > 0 ) ? path.n - 1 : 0 ) == false ) )
+    {
+        /* the containers leading to the target must all be writable */
+        result = EPERM;
+    }
+    else if( ( strcmp( op, "add" ) == 0 ) ||
+             ( strcmp( op, "replace" ) == 0 ) )
+    {
+        if( value == NULL )
+        {
+            result = EINVAL;
+        }
+        else if( ( pTarget != NULL ) &&
+                 ( ( pParent == NULL ) ||
+                   ( pParent->type == JSON_OBJECT ) ||
+                   ( op[0] == 'r' ) ) )
+        {
+            /* replace the existing value, re-using its node if possible */
+            result = json_PatchReplace( pParent, pTarget, value );
+        }
+        else if( op[0] == 'r' )
+        {
+            result = ENOENT;
+        }
+        else
+        {
+            pNode = json_PatchCopy( value, NULL );
+            result = json_PatchInsert( pParent, key, pNode );
+        }
+    }
+    else if( strcmp( op, "remove" ) == 0 )
+    {
+        if( pParent == NULL )
+        {
+            result = ENOTSUP;
+        }
+        else if( pTarget == NULL )
+        {
+            result = ENOENT;
+        }
+        else
+        {
+            json_PatchUnlink( pParent, pTarget );
+            JSON_Free( pTarget );
+        }
+    }
+    else if( strcmp( op, "test" ) == 0 )
+    {
+        if( value == NULL )
+        {
+            result = EINVAL;
+        }
+        else if( pTarget == NULL )
+        {
+            result = ENOENT;
+        }
+        else if( JSON_Equal( pTarget, value ) == false )
+        {
+            result = ECANCELED;
+        }
+    }
+    else if( ( strcmp( op, "move" ) == 0 ) ||
+             ( strcmp( op, "copy" ) == 0 ) )
+    {
+        result = json_PointerCompile( JSON_GetStr( pOp, "from" ), &from );
+        if( result == EOK )
+        {
+            result = json_PatchMoveCopy( doc, op, &from, &path );
+            json_PointerFree( &from );
+        }
+    }
+    else
+    {
+        result = EINVAL;
+    }
+
+    json_PointerFree( &path );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PatchMoveCopy                                                      */
+/*!
+    Apply a JSON Patch move or copy operation
+
+    The json_PatchMoveCopy function moves or copies the value at the
+    "from" location to the "path" location.  A moved value is unlinked
+    from its original container and relinked at its new location, so
+    its node (and all of its children) are re-used.
+
+    @param[in]
+        doc
+            pointer to the JSON document to patch
+
+    @param[in]
+        op
+            "move" or "copy"
+
+    @param[in]
+        from
+            compiled JSON Pointer of the source value
+
+    @param[in]
+        path
+            compiled JSON Pointer of the destination
+
+    @retval EOK the operation was applied
+    @retval EINVAL a value cannot be moved into one of its children
+    @retval ENOENT the source or destination does not exist
+    @retval ENOTSUP the operation would move or replace the root
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_PatchMoveCopy( JNode *doc,
+                               char *op,
+                               JPointer *from,
+                               JPointer *path )
+{
+    int result = EOK;
+    JNode *pFromParent;
+    JNode *pSource = NULL;
+    JNode *pParent;
+    JNode *pNode = NULL;
+    size_t i;
+    bool prefix;
+
+    if( ( from->n == 0 ) || ( path->n == 0 ) )
+    {
+        result = ENOTSUP;
+    }
+    else
+    {
+        pFromParent = json_PointerResolve( doc, from, from->n - 1 );
+        if( pFromParent != NULL )
+        {
+            pSource = json_PointerStep( pFromParent,
+                                        from->tokens[from->n - 1] );
+        }
+
+        if( pSource == NULL )
+        {
+            result = ENOENT;
+        }
+        else if( op[0] == 'c' )
+        {
+            pNode = json_PatchCopy( pSource, NULL );
+        }
+        else
+        {
+            /* a value cannot be moved into one of its own children */
+            prefix = ( from->n <= path->n );
+            for( i = 0; ( i < from->n ) && ( prefix == true ); i++ )
+            {
+                prefix = ( strcmp( from->tokens[i], path->tokens[i] ) == 0 );
+            }
+
+            if( prefix == true )
+            {
+                result = ( from->n == path->n ) ? EOK : EINVAL;
+            }
+            else if( json_PatchWritable( doc, from, from->n - 1 ) == false )
+            {
+                result = EPERM;
+            }
+            else
+            {
+                json_PatchUnlink( pFromParent, pSource );
+                pNode = pSource;
+            }
+        }
+    }
+
+    if( pNode != NULL )
+    {
+        /* the destination is evaluated after the source was removed */
+        pParent = json_PointerResolve( doc, path, path->n - 1 );
+        result = json_PatchInsert( pParent,
+                                   path->tokens[path->n - 1],
+                                   pNode );
+    }
+    else if( ( result == EOK ) && ( pSource != NULL ) && ( op[0] == 'c' ) )
+    {
+        result = ENOMEM;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PatchInsert                                                        */
+/*!
+    Insert a value into a container
+
+    The json_PatchInsert function adds a detached value to an object
+    under the specified member name (replacing any existing member with
+    that name), or inserts it into an array at the specified index,
+    where "-" appends it to the end of the array.  The value is freed
+    if it cannot be inserted.
+
+    @param[in]
+        pParent
+            pointer to the object or array to insert into
+
+    @param[in]
+        key
+            unescaped member name or array index
+
+    @param[in]
+        pNode
+            pointer to the detached value to insert
+
+    @retval EOK the value was inserted
+    @retval ENOENT the container or array index does not exist
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_PatchInsert( JNode *pParent, char *key, JNode *pNode )
+{
+    int result = ENOENT;
+    JNode *pExisting;
+    JArray *pArray;
+    size_t idx;
+    char *name;
+
+    if( pNode == NULL )
+    {
+        result = ENOMEM;
+    }
+    else if( pParent == NULL )
+    {
+        result = ENOENT;
+    }
+    else if( pParent->type == JSON_OBJECT )
+    {
+        pExisting = JSON_Attribute( (JObject *)pParent, key );
+        if( pExisting != NULL )
+        {
+            json_PatchSwap( pParent, pExisting, pNode );
+            JSON_Free( pExisting );
+            pNode = NULL;
+            result = EOK;
+        }
+        else
+        {
+            name = strdup( key );
+            if( name != NULL )
+            {
+                free( pNode->name );
+                pNode->name = name;
+                result = JSON_ObjectAdd( (JObject *)pParent, pNode );
+                pNode = ( result == EOK ) ? NULL : pNode;
+            }
+            else
+            {
+                result = ENOMEM;
+            }
+        }
+    }
+    else if( pParent->type == JSON_ARRAY )
+    {
+        pArray = (JArray *)pParent;
+        if( strcmp( key, "-" ) == 0 )
+        {
+            idx = pArray->n;
+            result = EOK;
+        }
+        else
+        {
+            result = json_PointerIndex( key, &idx );
+            if( ( result == EOK ) && ( idx > pArray->n ) )
+            {
+                result = ENOENT;
+            }
+        }
+
+        if( result == EOK )
+        {
+            free( pNode->name );
+            pNode->name = NULL;
+
+            result = JSON_ArrayInsertAt( pArray, idx, pNode );
+            pNode = ( result == EOK ) ? NULL : pNode;
+        }
+    }
+
+    /* free the value if it was not inserted */
+    JSON_Free( pNode );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PatchReplace                                                       */
+/*!
+    Replace a value with a copy of another value
+
+    The json_PatchReplace function replaces the target value with a copy
+    of the source value.  Scalar targets replaced by a scalar are updated
+    in place, and containers replaced by a container of the same type
+    have their children replaced in place, so the target node itself is
+    re-used.  Otherwise a copy of the source is swapped into the target's
+    container.
+
+    @param[in]
+        pParent
+            pointer to the container of the target, or NULL for the root
+
+    @param[in]
+        pTarget
+            pointer to the value to replace
+
+    @param[in]
+        pSource
+            pointer to the replacement value
+
+    @retval EOK the value was replaced
+    @retval ENOTSUP the root would change kind
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_PatchReplace( JNode *pParent, JNode *pTarget, JNode *pSource )
+{
+    int result = EOK;
+    JNode *pCopy = NULL;
+    JObject *pDst;
+    JObject *pSrc;
+    struct _JObjectIndex *pIndex;
+    JNode *pNode;
+    JNode *pDelete;
+
+    if( ( json_IsVar( pTarget ) == true ) &&
+        ( json_IsVar( pSource ) == true ) )
+    {
+        result = json_PatchAssign( (JVar *)pTarget, (JVar *)pSource );
+    }
+    else if( ( pTarget->type == pSource->type ) ||
+             ( pParent != NULL ) )
+    {
+        pCopy = json_PatchCopy( pSource, NULL );
+        if( pCopy == NULL )
+        {
+            result = ENOMEM;
+        }
+        else if( ( pTarget->type == pSource->type ) &&
+                 ( json_IsReadOnly( pTarget ) == false ) )
+        {
+            /* JArray and JObject share the same member list layout,
+               so take over the children of the copy in either case */
+            pDst = (JObject *)pTarget;
+            pSrc = (JObject *)pCopy;
+
+            pNode = pDst->pFirst;
+            while( pNode != NULL )
+            {
+                pDelete = pNode;
+                pNode = pNode->pNext;
+                JSON_Free( pDelete );
+            }
+
+            pDst->pFirst = pSrc->pFirst;
+            pDst->pLast = pSrc->pLast;
+            pDst->n = pSrc->n;
+            pSrc->pFirst = NULL;
+            pSrc->pLast = NULL;
+            pSrc->n = 0;
+
+            if( pTarget->type == JSON_OBJECT )
+            {
+                /* the copy's index describes the members taken over,
+                   and the copy frees the target's stale index */
+                pIndex = pDst->pIndex;
+                pDst->pIndex = pSrc->pIndex;
+                pSrc->pIndex = pIndex;
+            }
+
+            JSON_Free( pCopy );
+        }
+        else
+        {
+            json_PatchSwap( pParent, pTarget, pCopy );
+            JSON_Free( pTarget );
+        }
+    }
+    else
+    {
+        result = ENOTSUP;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PatchAssign                                                        */
+/*!
+    Assign a scalar value in place
+
+    The json_PatchAssign function overwrites a scalar (null, boolean,
+    number, or string) JSON value with another scalar value, re-using
+    the target node.
+
+    @param[in]
+        pDst
+            pointer to the JSON variable to update
+
+    @param[in]
+        pSrc
+            pointer to the JSON variable to copy the value from
+
+    @retval EOK the value was assigned
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_PatchAssign( JVar *pDst, JVar *pSrc )
+{
+    int result = EOK;
+    char *str = NULL;
+
+    if( ( pSrc->var.type == JVARTYPE_STR ) &&
+        ( pSrc->var.val.str != NULL ) )
+    {
+        str = strdup( pSrc->var.val.str );
+        if( str == NULL )
+        {
+            result = ENOMEM;
+        }
+    }
+
+    if( result == EOK )
+    {
+        if( pDst->var.type == JVARTYPE_STR )
+        {
+            free( pDst->var.val.str );
+        }
+
+        pDst->node.type = pSrc->node.type;
+        pDst->var = pSrc->var;
+        if( pDst->var.type == JVARTYPE_STR )
+        {
+            pDst->var.val.str = str;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PatchSwap                                                          */
+/*!
+    Swap a new value into a container
+
+    The json_PatchSwap function links a detached value into a container
+    in the position of an existing value, transferring the existing
+    value's name to it.  The existing value is unlinked but not freed.
+
+    @param[in]
+        pParent
+            pointer to the container
+
+    @param[in]
+        pOld
+            pointer to the value to unlink
+
+    @param[in]
+        pNew
+            pointer to the value to link in its place
+
+============================================================================*/
+static void json_PatchSwap( JNode *pParent, JNode *pOld, JNode *pNew )
+{
+    JObject *pContainer = (JObject *)pParent;
+
+    if( pParent->type == JSON_OBJECT )
+    {
+        json_IndexReplace( pContainer, pOld, pNew );
+    }
+
+    free( pNew->name );
+    pNew->name = pOld->name;
+    pOld->name = NULL;
+
+    pNew->pPrev = pOld->pPrev;
+    pNew->pNext = pOld->pNext;
+
+    if( pOld->pPrev == NULL )
+    {
+        pContainer->pFirst = pNew;
+    }
+    else
+    {
+        pOld->pPrev->pNext = pNew;
+    }
+
+    if( pOld->pNext == NULL )
+    {
+        pContainer->pLast = pNew;
+    }
+    else
+    {
+        pOld->pNext->pPrev = pNew;
+    }
+
+    pOld->pNext = NULL;
+    pOld->pPrev = NULL;
+}
+
+/*==========================================================================*/
+/*  json_PatchUnlink                                                        */
+/*!
+    Unlink a value from its container
+
+    The json_PatchUnlink function removes a value from an object or
+    array, maintaining the container's count and first and last member
+    pointers.  The value is not freed.
+
+    @param[in]
+        pParent
+            pointer to the container
+
+    @param[in]
+        pNode
+            pointer to the value to unlink
+
+============================================================================*/
+static void json_PatchUnlink( JNode *pParent, JNode *pNode )
+{
+    JSON_Remove( pParent, pNode );
+}
+
+/*==========================================================================*/
+/*  json_MergeObject                                                        */
+/*!
+    Merge a JSON Merge Patch object into a JSON object
+
+    The json_MergeObject function applies the members of a JSON Merge
+    Patch object to a JSON object as per RFC 7396.
+
+    @param[in]
+        pTarget
+            pointer to the JSON object to update
+
+    @param[in]
+        pMerge
+            pointer to the JSON Merge Patch object
+
+    @retval EOK the merge was applied
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_MergeObject( JObject *pTarget, JObject *pMerge )
+{
+    int result = EOK;
+    JNode *pMember;
+    JNode *pExisting;
+    JNode *pNode;
+
+    if( json_IsReadOnly( (JNode *)pTarget ) == true )
+    {
+        result = EPERM;
+    }
+
+    pMember = pMerge->pFirst;
+    while( ( pMember != NULL ) && ( result == EOK ) )
+    {
+        pExisting = JSON_Attribute( pTarget, pMember->name );
+
+        if( pMember->type == JSON_NULL )
+        {
+            if( pExisting != NULL )
+            {
+                json_PatchUnlink( (JNode *)pTarget, pExisting );
+                JSON_Free( pExisting );
+            }
+        }
+        else if( ( pMember->type == JSON_OBJECT ) &&
+                 ( pExisting != NULL ) &&
+                 ( pExisting->type == JSON_OBJECT ) )
+        {
+            result = json_MergeObject( (JObject *)pExisting,
+                                       (JObject *)pMember );
+        }
+        else if( pMember->type == JSON_OBJECT )
+        {
+            /* merging into a non-object starts from an empty object,
+               which also strips any nulls from the merge value */
+            pNode = (JNode *)JSON_Object( NULL );
+            result = ( pNode != NULL )
+                     ? json_MergeObject( (JObject *)pNode,
+                                         (JObject *)pMember )
+                     : ENOMEM;
+            if( result == EOK )
+            {
+                result = json_PatchInsert( (JNode *)pTarget,
+                                           pMember->name,
+                                           pNode );
+            }
+            else
+            {
+                JSON_Free( pNode );
+            }
+        }
+        else if( pExisting != NULL )
+        {
+            result = json_PatchReplace( (JNode *)pTarget,
+                                        pExisting,
+                                        pMember );
+        }
+        else
+        {
+            result = json_PatchInsert( (JNode *)pTarget,
+                                       pMember->name,
+                                       json_PatchCopy( pMember, NULL ) );
+        }
+
+        pMember = pMember->pNext;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PersistentStep                                                     */
+/*!
+    Resolve one step of a persistent update path
+
+    The json_PersistentStep function looks up a reference token in a
+    container.  The final token of the path may also refer to a new
+    object member or to the end of an array.
+
+    @param[in]
+        pNode
+            pointer to the container
+
+    @param[in]
+        token
+            reference token to look up
+
+    @param[in]
+        last
+            true if this is the final token of the path
+
+    @param[out]
+        ppChild
+            location to store the matching child, or NULL if the final
+            token refers to a value to be added
+
+    @retval EOK the step was resolved
+    @retval ENOENT the path does not exist
+
+============================================================================*/
+static int json_PersistentStep( JNode *pNode,
+                                char *token,
+                                bool last,
+                                JNode **ppChild )
+{
+    int result = ENOENT;
+    size_t idx;
+
+    *ppChild = NULL;
+
+    if( pNode->type == JSON_OBJECT )
+    {
+        *ppChild = JSON_Attribute( (JObject *)pNode, token );
+        if( ( *ppChild != NULL ) || ( last == true ) )
+        {
+            result = EOK;
+        }
+    }
+    else if( pNode->type == JSON_ARRAY )
+    {
+        if( strcmp( token, "-" ) == 0 )
+        {
+            result = ( last == true ) ? EOK : ENOENT;
+        }
+        else if( json_PointerIndex( token, &idx ) == EOK )
+        {
+            *ppChild = JSON_Index( (JArray *)pNode, idx );
+            if( ( *ppChild != NULL ) ||
+                ( ( last == true ) && ( idx == ((JArray *)pNode)->n ) ) )
+            {
+                result = EOK;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PersistentCopy                                                     */
+/*!
+    Copy a container on a persistent update path
+
+    The json_PersistentCopy function creates a new version of a
+    container in which one member is replaced by (or, if pOld is NULL,
+    appended as) a new value.  All other members are shared with the
+    original container.
+
+    @param[in]
+        pNode
+            pointer to the original container
+
+    @param[in]
+        pOld
+            pointer to the member to replace, or NULL to append
+
+    @param[in]
+        pNew
+            pointer to the new member, which is consumed by this
+            function even if it fails
+
+    @param[in]
+        key
+            name of the new member if the container is an object
+
+    @retval pointer to the new version of the container
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static JNode *json_PersistentCopy( JNode *pNode,
+                                   JNode *pOld,
+                                   JNode *pNew,
+                                   char *key )
+{
+    JObject *pCopy = NULL;
+    JNode *pChild;
+    JNode *pMember;
+    int result = ENOMEM;
+
+    free( pNew->name );
+    pNew->name = ( pNode->type == JSON_OBJECT ) ? strdup( key ) : NULL;
+
+    if( ( pNode->type != JSON_OBJECT ) || ( pNew->name != NULL ) )
+    {
+        pCopy = ( pNode->type == JSON_OBJECT )
+                ? JSON_Object( NULL )
+                : (JObject *)JSON_Array( NULL );
+    }
+
+    if( pCopy != NULL )
+    {
+        result = EOK;
+
+        pChild = ((JObject *)pNode)->pFirst;
+        while( ( pChild != NULL ) && ( result == EOK ) )
+        {
+            if( pChild == pOld )
+            {
+                pMember = pNew;
+                pNew = NULL;
+            }
+            else
+            {
+                pMember = json_PersistentShare( pChild );
+            }
+
+            if( pMember == NULL )
+            {
+                result = ENOMEM;
+            }
+            else if( pCopy->node.type == JSON_OBJECT )
+            {
+                result = JSON_ObjectAdd( pCopy, pMember );
+            }
+            else
+            {
+                result = JSON_ArrayAdd( (JArray *)pCopy, (JObject *)pMember );
+            }
+
+            pChild = pChild->pNext;
+        }
+
+        if( ( result == EOK ) && ( pNew != NULL ) )
+        {
+            if( pCopy->node.type == JSON_OBJECT )
+            {
+                result = JSON_ObjectAdd( pCopy, pNew );
+            }
+            else
+            {
+                result = JSON_ArrayAdd( (JArray *)pCopy, (JObject *)pNew );
+            }
+
+            pNew = NULL;
+        }
+    }
+
+    if( result != EOK )
+    {
+        JSON_Free( (JNode *)pCopy );
+        pCopy = NULL;
+    }
+
+    JSON_Free( pNew );
+
+    return (JNode *)pCopy;
+}
+
+/*==========================================================================*/
+/*  json_PersistentShare                                                    */
+/*!
+    Share a member of a container on a persistent update path
+
+    The json_PersistentShare function creates a node which can be linked
+    into a new version of a container in place of an unchanged member.
+    Objects and arrays get a header which borrows the name and members
+    of the node which owns them and holds a reference to it, so the
+    subtree itself is not copied.  Scalars are copied.
+
+    @param[in]
+        pNode
+            pointer to the unchanged member
+
+    @retval pointer to the node to link into the new version
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static JNode *json_PersistentShare( JNode *pNode )
+{
+    JNode *pShare = NULL;
+    JObject *pHeader;
+    JObject *pOwner;
+
+    if( ( pNode->type == JSON_OBJECT ) ||
+        ( pNode->type == JSON_ARRAY ) )
+    {
+        /* always reference the owner, never another header */
+        pOwner = (JObject *)pNode;
+        if( pOwner->pShared != NULL )
+        {
+            pOwner = (JObject *)pOwner->pShared;
+        }
+
+        pHeader = ( pNode->type == JSON_OBJECT )
+                  ? JSON_Object( NULL )
+                  : (JObject *)JSON_Array( NULL );
+        if( pHeader != NULL )
+        {
+            pHeader->node.name = pOwner->node.name;
+            pHeader->n = pOwner->n;
+            pHeader->pFirst = pOwner->pFirst;
+            pHeader->pLast = pOwner->pLast;
+            pHeader->hash = ((JObject *)pNode)->hash;
+            pHeader->hashEpoch = ((JObject *)pNode)->hashEpoch;
+            pHeader->pShared = JSON_Retain( (JNode *)pOwner );
+            pShare = (JNode *)pHeader;
+
+            /* the owner's member list is now borrowed by the header */
+            pOwner->node.flags |= JSON_NODE_SHARED;
+        }
+    }
+    else
+    {
+        pShare = json_PatchCopy( pNode, pNode->name );
+    }
+
+    return pShare;
+}
+
+/*==========================================================================*/
+/*  json_IsVar                                                              */
+/*!
+    Check if a JSON value is a scalar
+
+    The json_IsVar function checks if a JSON value is stored in a JVar,
+    ie it is a null, boolean, number, or string.
+
+    @param[in]
+        pNode
+            pointer to the JSON value
+
+    @retval true the value is a scalar
+    @retval false the value is a container
+
+============================================================================*/
+static bool json_IsVar( JNode *pNode )
+{
+    return ( pNode->type == JSON_VAR ) ||
+           ( pNode->type == JSON_BOOL ) ||
+           ( pNode->type == JSON_NULL );
+}
+
+/*==========================================================================*/
+/*  json_IsReadOnly                                                         */
+/*!
+    Check if a JSON value may not be modified in place
+
+    The json_IsReadOnly function checks if a JSON value is part of a
+    read-only clone, or is a container whose member list is shared
+    between persistent versions (a version header, or an owner whose
+    members a header borrows).
+
+    @param[in]
+        pNode
+            pointer to the JSON value
+
+    @retval true the value is read-only
+    @retval false the value may be modified
+
+============================================================================*/
+static bool json_IsReadOnly( JNode *pNode )
+{
+    bool readonly = ( ( pNode->flags &
+                        ( JSON_NODE_ARENA | JSON_NODE_SHARED ) ) != 0 );
+
+    if( ( ( pNode->type == JSON_OBJECT ) ||
+          ( pNode->type == JSON_ARRAY ) ) &&
+        ( ((JObject *)pNode)->pShared != NULL ) )
+    {
+        readonly = true;
+    }
+
+    return readonly;
+}
+
+/*==========================================================================*/
+/*  json_PatchWritable                                                      */
+/*!
+    Check if the containers along a JSON Pointer may be modified
+
+    The json_PatchWritable function walks the first n tokens of a
+    compiled JSON Pointer from the document root and checks that the
+    root and every value reached are writable.  A member of a shared
+    container is itself shared, so any read-only container on the way
+    makes the whole path read-only.  The walk stops early at a value
+    which does not exist.
+
+    @param[in]
+        doc
+            pointer to the JSON document
+
+    @param[in]
+        p
+            pointer to the compiled JSON Pointer
+
+    @param[in]
+        n
+            number of tokens to walk
+
+    @retval true the containers along the path may be modified
+    @retval false the path passes through a read-only value
+
+============================================================================*/
+static bool json_PatchWritable( JNode *doc, JPointer *p, size_t n )
+{
+    bool writable = true;
+    JNode *pNode = doc;
+    size_t i = 0;
+
+    while( ( pNode != NULL ) && ( writable == true ) )
+    {
+        writable = ( json_IsReadOnly( pNode ) == false );
+        pNode = ( i < n ) ? json_PointerStep( pNode, p->tokens[i++] ) : NULL;
+    }
+
+    return writable;
+}
+
+/*==========================================================================*/
+/*  json_PointerCompile                                                     */
+/*!
+    Compile a JSON Pointer
+
+    The json_PointerCompile function splits a JSON Pointer (RFC 6901)
+    into its reference tokens and unescapes them ( "~1" becomes '/' and
+    "~0" becomes '~' ) so they can be matched directly against member
+    names.
+
+    @param[in]
+        pointer
+            pointer to the NUL terminated JSON Pointer
+
+    @param[out]
+        p
+            pointer to the compiled JSON Pointer to populate.  It must be
+            released with json_PointerFree if this function succeeds.
+
+    @retval EOK the JSON Pointer was compiled
+    @retval EINVAL the JSON Pointer is malformed
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_PointerCompile( char *pointer, JPointer *p )
+{
+    int result = EOK;
+    char *src;
+    char *dst;
+    size_t i;
+
+    p->n = 0;
+    p->tokens = NULL;
+    p->buf = NULL;
+
+    if( ( pointer == NULL ) ||
+        ( ( pointer[0] != 0 ) && ( pointer[0] != '/' ) ) )
+    {
+        result = EINVAL;
+    }
+    else if( pointer[0] == '/' )
+    {
+        for( src = pointer; *src != 0; src++ )
+        {
+            if( *src == '/' )
+            {
+                p->n++;
+            }
+        }
+
+        p->buf = strdup( pointer );
+        p->tokens = malloc( p->n * sizeof( char * ) );
+        if( ( p->buf == NULL ) || ( p->tokens == NULL ) )
+        {
+            result = ENOMEM;
+        }
+
+        /* unescape each token in place, terminating it where the
+           next one begins */
+        i = 0;
+        dst = p->buf;
+        for( src = p->buf; ( result == EOK ) && ( *src != 0 ); src++ )
+        {
+            if( *src == '/' )
+            {
+                *dst++ = 0;
+                p->tokens[i++] = dst;
+            }
+            else if( *src == '~' )
+            {
+                src++;
+                if( *src == '0' )
+                {
+                    *dst++ = '~';
+                }
+                else if( *src == '1' )
+                {
+                    *dst++ = '/';
+                }
+                else
+                {
+                    result = EINVAL;
+                }
+            }
+            else
+            {
+                *dst++ = *src;
+            }
+        }
+
+        if( result == EOK )
+        {
+            *dst = 0;
+        }
+        else
+        {
+            json_PointerFree( p );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PointerFree                                                        */
+/*!
+    Release a compiled JSON Pointer
+
+    The json_PointerFree function releases the storage of a compiled
+    JSON Pointer.
+
+    @param[in]
+        p
+            pointer to the compiled JSON Pointer
+
+============================================================================*/
+static void json_PointerFree( JPointer *p )
+{
+    free( p->tokens );
+    free( p->buf );
+    p->tokens = NULL;
+    p->buf = NULL;
+    p->n = 0;
+}
+
+/*==========================================================================*/
+/*  json_PointerResolve                                                     */
+/*!
+    Resolve a compiled JSON Pointer
+
+    The json_PointerResolve function evaluates the first n reference
+    tokens of a compiled JSON Pointer against a JSON document.
+
+    @param[in]
+        doc
+            pointer to the JSON document
+
+    @param[in]
+        p
+            pointer to the compiled JSON Pointer
+
+    @param[in]
+        n
+            number of reference tokens to evaluate
+
+    @retval pointer to the referenced JSON value
+    @retval NULL the referenced value does not exist
+
+============================================================================*/
+static JNode *json_PointerResolve( JNode *doc, JPointer *p, size_t n )
+{
+    JNode *pNode = doc;
+    size_t i;
+
+    for( i = 0; ( i < n ) && ( pNode != NULL ); i++ )
+    {
+        pNode = json_PointerStep( pNode, p->tokens[i] );
+    }
+
+    return pNode;
+}
+
+/*==========================================================================*/
+/*  json_PointerStep                                                        */
+/*!
+    Evaluate one JSON Pointer reference token
+
+    The json_PointerStep function looks up an unescaped reference token
+    as a member name of an object or an index of an array.
+
+    @param[in]
+        pNode
+            pointer to the JSON object or array
+
+    @param[in]
+        token
+            unescaped reference token
+
+    @retval pointer to the referenced JSON value
+    @retval NULL the referenced value does not exist
+
+============================================================================*/
+static JNode *json_PointerStep( JNode *pNode, char *token )
+{
+    JNode *result = NULL;
+    size_t idx;
+
+    if( pNode->type == JSON_OBJECT )
+    {
+        result = JSON_Attribute( (JObject *)pNode, token );
+    }
+    else if( ( pNode->type == JSON_ARRAY ) &&
+             ( json_PointerIndex( token, &idx ) == EOK ) )
+    {
+        result = JSON_Index( (JArray *)pNode, idx );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_PointerIndex                                                       */
+/*!
+    Convert a JSON Pointer reference token to an array index
+
+    The json_PointerIndex function converts a reference token to an
+    array index.  As per RFC 6901 the token must consist only of decimal
+    digits with no leading zeros.
+
+    @param[in]
+        token
+            unescaped reference token
+
+    @param[out]
+        pIdx
+            pointer to a location to store the array index
+
+    @retval EOK the token is a valid array index
+    @retval EINVAL the token is not a valid array index
+
+============================================================================*/
+static int json_PointerIndex( char *token, size_t *pIdx )
+{
+    int result = EINVAL;
+    size_t idx = 0;
+    char *p;
+
+    if( ( token[0] != 0 ) &&
+        ( ( token[0] != '0' ) || ( token[1] == 0 ) ) )
+    {
+        result = EOK;
+        for( p = token; ( *p != 0 ) && ( result == EOK ); p++ )
+        {
+            if( ( *p >= '0' ) && ( *p <= '9' ) )
+            {
+                idx = ( idx * 10 ) + ( *p - '0' );
+            }
+            else
+            {
+                result = EINVAL;
+            }
+        }
+    }
+
+    *pIdx = idx;
+
+    return result;
+}
@@ -0,0 +1,862 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! default size of each output buffer */
+#define JSON_SINK_BUFFER_SIZE   ( 64 * 1024 )
+
+/*! default number of output buffers */
+#define JSON_SINK_BUFFERS       ( 2 )
+
+/*! default flush interval in milliseconds */
+#define JSON_SINK_INTERVAL      ( 100 )
+
+/*============================================================================
+        External Functions
+============================================================================*/
+
+/*! output a JSON object to a memory buffer */
+extern int json_WriterBuffer( JNode *json,
+                              char **ppBuf,
+                              size_t *pSize,
+                              size_t *pLen );
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! output buffer of an asynchronous JSON record writer */
+typedef struct _JSinkBuffer
+{
+    /*! next buffer in the free list or the write queue */
+    struct _JSinkBuffer *pNext;
+
+    /*! number of bytes in use */
+    size_t len;
+
+    /*! buffer content */
+    char data[];
+
+} JSinkBuffer;
+
+/*! per-thread buffer in which records are serialized */
+typedef struct _JSinkRecord
+{
+    /*! pointer to the buffer */
+    char *buf;
+
+    /*! size of the buffer */
+    size_t size;
+
+} JSinkRecord;
+
+/*! asynchronous JSON record writer state */
+struct _JAsyncSink
+{
+    /*! file descriptor being written to */
+    int fd;
+
+    /*! size of each output buffer */
+    size_t bufferSize;
+
+    /*! flush interval in milliseconds, or zero */
+    unsigned int interval;
+
+    /*! true to drop records rather than wait for a buffer */
+    bool drop;
+
+    /*! mutex protecting the buffers and counters */
+    pthread_mutex_t lock;
+
+    /*! signalled when a buffer is queued to be written, or on stop */
+    pthread_cond_t ready;
+
+    /*! signalled when a buffer has been written */
+    pthread_cond_t space;
+
+    /*! buffer records are being added to, or NULL */
+    JSinkBuffer *pActive;
+
+    /*! list of empty buffers */
+    JSinkBuffer *pFree;
+
+    /*! first buffer waiting to be written */
+    JSinkBuffer *pHead;
+
+    /*! last buffer waiting to be written */
+    JSinkBuffer *pTail;
+
+    /*! number of buffers queued to be written */
+    uint64_t queued;
+
+    /*! number of buffers which have been written */
+    uint64_t done;
+
+    /*! true when the writer thread has been told to stop */
+    bool stop;
+
+    /*! writer thread */
+    pthread_t thread;
+
+    /*! counters */
+    JAsyncSinkStats stats;
+};
+
+/*============================================================================
+        Private File Scoped Variables
+============================================================================*/
+
+/*! key of the per-thread record buffers */
+static pthread_key_t json_sinkKey;
+
+/*! creates json_sinkKey once */
+static pthread_once_t json_sinkOnce = PTHREAD_ONCE_INIT;
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static void *json_SinkThread( void *arg );
+static int json_SinkReserve( JAsyncSink *pSink, size_t len );
+static void json_SinkQueue( JAsyncSink *pSink );
+static int json_SinkOutput( int fd, JSinkBuffer *pBuffer );
+static void json_SinkDeadline( unsigned int interval, struct timespec *ts );
+static JSinkRecord *json_SinkRecord( void );
+static void json_SinkKey( void );
+static void json_SinkRecordFree( void *arg );
+static void json_SinkFree( JAsyncSink *pSink );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_AsyncSink                                                          */
+/*!
+    Create an asynchronous JSON record writer
+
+    The JSON_AsyncSink function creates a writer which outputs JSON
+    records to a file descriptor from a background thread, so that the
+    threads producing the records never wait for the output to be
+    written.
+
+    Records are serialized into a per-thread buffer without holding any
+    lock, and then copied into the active output buffer.  Full buffers
+    are queued to the writer thread, which writes each of them with a
+    single write call, and a partly filled buffer is queued when the
+    flush interval expires.  When every buffer is waiting to be
+    written, records are either dropped or their producers wait,
+    according to the configuration.
+
+    @param[in]
+        fd
+            the file descriptor to write to
+
+    @param[in]
+        pConfig
+            pointer to the writer configuration, or NULL for 64 KB
+            buffers, double buffering, a 100 ms flush interval, and
+            producers which wait for a buffer rather than drop records
+
+    @retval pointer to the asynchronous JSON record writer
+    @retval NULL if the writer could not be created
+
+============================================================================*/
+JAsyncSink *JSON_AsyncSink( int fd, JAsyncSinkConfig *pConfig )
+{
+    JAsyncSink *pSink = NULL;
+    JSinkBuffer *pBuffer;
+    pthread_condattr_t attr;
+    size_t buffers = JSON_SINK_BUFFERS;
+    size_t i;
+    bool ok = false;
+
+    if( fd >= 0 )
+    {
+        pSink = calloc( 1, sizeof( JAsyncSink ) );
+        if( pSink != NULL )
+        {
+            pSink->fd = fd;
+            pSink->bufferSize = JSON_SINK_BUFFER_SIZE;
+            pSink->interval = JSON_SINK_INTERVAL;
+
+            if( pConfig != NULL )
+            {
+                if( pConfig->bufferSize > 0 )
+                {
+                    pSink->bufferSize = pConfig->bufferSize;
+                }
+
+                if( pConfig->buffers > buffers )
+                {
+                    buffers = pConfig->buffers;
+                }
+
+                pSink->interval = pConfig->flushInterval;
+                pSink->drop = pConfig->drop;
+            }
+
+            /* the flush interval is measured on the monotonic clock */
+            pthread_condattr_init( &attr );
+            pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+            pthread_mutex_init( &pSink->lock, NULL );
+            pthread_cond_init( &pSink->ready, &attr );
+            pthread_cond_init( &pSink->space, NULL );
+            pthread_condattr_destroy( &attr );
+
+            ok = true;
+            for( i = 0; ( i < buffers ) && ( ok == true ); i++ )
+            {
+                pBuffer = malloc( sizeof( JSinkBuffer ) + pSink->bufferSize );
+                if( pBuffer != NULL )
+                {
+                    pBuffer->pNext = pSink->pFree;
+                    pSink->pFree = pBuffer;
+                }
+                else
+                {
+                    ok = false;
+                }
+            }
+
+            if( ( ok == true ) &&
+                ( pthread_once( &json_sinkOnce, json_SinkKey ) == 0 ) )
+            {
+                ok = ( pthread_create( &pSink->thread,
+                                       NULL,
+                                       json_SinkThread,
+                                       pSink ) == 0 );
+            }
+            else
+            {
+                ok = false;
+            }
+
+            if( ok == false )
+            {
+                json_SinkFree( pSink );
+                pSink = NULL;
+            }
+        }
+    }
+
+    return pSink;
+}
+
+/*==========================================================================*/
+/*  JSON_AsyncSinkWrite                                                     */
+/*!
+    Write a JSON record asynchronously
+
+    The JSON_AsyncSinkWrite function serializes a JSON object in the
+    same format as JSON_Print, followed by a newline, and adds it to
+    the output of an asynchronous writer.  It may be called from many
+    threads at once.  The caller keeps ownership of the object, which
+    may be freed as soon as the function returns.
+
+    @param[in]
+        pSink
+            pointer to the asynchronous JSON record writer
+
+    @param[in]
+        json
+            pointer to the JSON object to write
+
+    @retval EOK the record was added to the output
+    @retval EAGAIN the record was dropped as every buffer is waiting
+            to be written
+    @retval E2BIG the record was dropped as it is larger than a buffer
+    @retval ENOMEM memory allocation failure
+    @retval EINVAL invalid arguments
+
+============================================================================*/
+int JSON_AsyncSinkWrite( JAsyncSink *pSink, JNode *json )
+{
+    int result = EINVAL;
+    JSinkRecord *pRecord;
+    size_t len = 0;
+
+    if( ( pSink != NULL ) &&
+        ( json != NULL ) )
+    {
+        pRecord = json_SinkRecord();
+        if( pRecord != NULL )
+        {
+            result = json_WriterBuffer( json,
+                                        &pRecord->buf,
+                                        &pRecord->size,
+                                        &len );
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+
+        if( ( result == EOK ) &&
+            ( len + 1 > pSink->bufferSize ) )
+        {
+            result = E2BIG;
+        }
+
+        pthread_mutex_lock( &pSink->lock );
+
+        if( result == EOK )
+        {
+            result = json_SinkReserve( pSink, len + 1 );
+        }
+
+        if( result == EOK )
+        {
+            memcpy( &pSink->pActive->data[pSink->pActive->len],
+                    pRecord->buf,
+                    len );
+            pSink->pActive->data[pSink->pActive->len + len] = '\n';
+            pSink->pActive->len += len + 1;
+            pSink->stats.records++;
+        }
+        else
+        {
+            pSink->stats.dropped++;
+        }
+
+        pthread_mutex_unlock( &pSink->lock );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_AsyncSinkFlush                                                     */
+/*!
+    Wait for the records written so far to be output
+
+    The JSON_AsyncSinkFlush function queues the active buffer of an
+    asynchronous writer, and waits until every buffer queued before it
+    has been written.
+
+    @param[in]
+        pSink
+            pointer to the asynchronous JSON record writer
+
+    @retval EOK the records were written
+    @retval EINVAL invalid arguments
+    @retval other the first error returned by write
+
+============================================================================*/
+int JSON_AsyncSinkFlush( JAsyncSink *pSink )
+{
+    int result = EINVAL;
+    uint64_t queued;
+
+    if( pSink != NULL )
+    {
+        pthread_mutex_lock( &pSink->lock );
+
+        json_SinkQueue( pSink );
+
+        queued = pSink->queued;
+        while( pSink->done < queued )
+        {
+            pthread_cond_wait( &pSink->space, &pSink->lock );
+        }
+
+        result = pSink->stats.error;
+
+        pthread_mutex_unlock( &pSink->lock );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_AsyncSinkStats                                                     */
+/*!
+    Get asynchronous writer statistics
+
+    The JSON_AsyncSinkStats function retrieves a snapshot of the record,
+    drop, and write counters of an asynchronous writer.
+
+    @param[in]
+        pSink
+            pointer to the asynchronous JSON record writer
+
+    @param[out]
+        pStats
+            pointer to a location to store the statistics
+
+    @retval EOK the statistics were retrieved
+    @retval EINVAL invalid arguments
+
+============================================================================*/
+int JSON_AsyncSinkStats( JAsyncSink *pSink, JAsyncSinkStats *pStats )
+{
+    int result = EINVAL;
+
+    if( ( pSink != NULL ) &&
+        ( pStats != NULL ) )
+    {
+        pthread_mutex_lock( &pSink->lock );
+        *pStats = pSink->stats;
+        pthread_mutex_unlock( &pSink->lock );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  JSON_AsyncSinkStop                                                      */
+/*!
+    Stop an asynchronous JSON record writer
+
+    The JSON_AsyncSinkStop function writes any records which have not
+    been written, stops the writer thread, and releases the writer.
+    The file descriptor is not closed.  No other thread may be writing
+    records to the writer when it is stopped.
+
+    @param[in]
+        pSink
+            pointer to the asynchronous JSON record writer
+
+    @retval EOK every record was written
+    @retval EINVAL invalid arguments
+    @retval other the first error returned by write
+
+============================================================================*/
+int JSON_AsyncSinkStop( JAsyncSink *pSink )
+{
+    int result = EINVAL;
+
+    if( pSink != NULL )
+    {
+        pthread_mutex_lock( &pSink->lock );
+        json_SinkQueue( pSink );
+        pSink->stop = true;
+        pthread_cond_signal( &pSink->ready );
+        pthread_mutex_unlock( &pSink->lock );
+
+        pthread_join( pSink->thread, NULL );
+
+        result = pSink->stats.error;
+
+        json_SinkFree( pSink );
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_SinkThread                                                         */
+/*!
+    Asynchronous writer thread
+
+    The json_SinkThread function writes the queued buffers of an
+    asynchronous writer in order, and queues the active buffer each
+    time the flush interval expires, until it is told to stop and the
+    queue is empty.  Once a write has failed, queued buffers are
+    discarded so that producers are never left waiting.
+
+    @param[in]
+        arg
+            pointer to the asynchronous JSON record writer
+
+    @retval NULL always
+
+============================================================================*/
+static void *json_SinkThread( void *arg )
+{
+    JAsyncSink *pSink = (JAsyncSink *)arg;
+    JSinkBuffer *pBuffer;
+    struct timespec deadline;
+    int rc;
+
+    pthread_mutex_lock( &pSink->lock );
+
+    json_SinkDeadline( pSink->interval, &deadline );
+
+    while( ( pSink->pHead != NULL ) ||
+           ( pSink->stop == false ) )
+    {
+        if( pSink->pHead == NULL )
+        {
+            if( pSink->interval > 0 )
+            {
+                rc = pthread_cond_timedwait( &pSink->ready,
+                                             &pSink->lock,
+                                             &deadline );
+                if( rc == ETIMEDOUT )
+                {
+                    json_SinkQueue( pSink );
+                    json_SinkDeadline( pSink->interval, &deadline );
+                }
+            }
+            else
+            {
+                pthread_cond_wait( &pSink->ready, &pSink->lock );
+            }
+        }
+        else
+        {
+            pBuffer = pSink->pHead;
+            pSink->pHead = pBuffer->pNext;
+            if( pSink->pHead == NULL )
+            {
+                pSink->pTail = NULL;
+            }
+
+            /* the output is written without holding the lock */
+            if( pSink->stats.error == EOK )
+            {
+                pthread_mutex_unlock( &pSink->lock );
+                rc = json_SinkOutput( pSink->fd, pBuffer );
+                pthread_mutex_lock( &pSink->lock );
+
+                if( rc == EOK )
+                {
+                    pSink->stats.bytes += pBuffer->len;
+                    pSink->stats.writes++;
+                }
+                else
+                {
+                    pSink->stats.error = rc;
+                }
+            }
+
+            pBuffer->pNext = pSink->pFree;
+            pSink->pFree = pBuffer;
+            pSink->done++;
+
+            pthread_cond_broadcast( &pSink->space );
+        }
+    }
+
+    pthread_mutex_unlock( &pSink->lock );
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  json_SinkReserve                                                        */
+/*!
+    Make room for a record in the active buffer
+
+    The json_SinkReserve function queues the active buffer if the record
+    does not fit in it, and takes an empty buffer if there is no active
+    buffer, waiting for one to be written if the writer is configured
+    to wait.  It must be called with the lock held.
+
+    @param[in]
+        pSink
+            pointer to the asynchronous JSON record writer
+
+    @param[in]
+        len
+            length of the record
+
+    @retval EOK the active buffer has room for the record
+    @retval EAGAIN every buffer is waiting to be written
+
+============================================================================*/
+static int json_SinkReserve( JAsyncSink *pSink, size_t len )
+{
+    int result = EOK;
+
+    /* another producer may fill the active buffer while this one waits */
+    while( ( result == EOK ) &&
+           ( ( pSink->pActive == NULL ) ||
+             ( pSink->pActive->len + len > pSink->bufferSize ) ) )
+    {
+        if( pSink->pActive != NULL )
+        {
+            json_SinkQueue( pSink );
+        }
+        else if( pSink->pFree != NULL )
+        {
+            pSink->pActive = pSink->pFree;
+            pSink->pFree = pSink->pActive->pNext;
+            pSink->pActive->len = 0;
+        }
+        else if( pSink->drop == true )
+        {
+            result = EAGAIN;
+        }
+        else
+        {
+            pSink->stats.waits++;
+            pthread_cond_wait( &pSink->space, &pSink->lock );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_SinkQueue                                                          */
+/*!
+    Queue the active buffer to be written
+
+    The json_SinkQueue function moves the active buffer, if it holds any
+    records, to the end of the write queue and wakes the writer thread.
+    It must be called with the lock held.
+
+    @param[in]
+        pSink
+            pointer to the asynchronous JSON record writer
+
+============================================================================*/
+static void json_SinkQueue( JAsyncSink *pSink )
+{
+    JSinkBuffer *pBuffer = pSink->pActive;
+
+    if( ( pBuffer != NULL ) &&
+        ( pBuffer->len > 0 ) )
+    {
+        pBuffer->pNext = NULL;
+        if( pSink->pTail != NULL )
+        {
+            pSink->pTail->pNext = pBuffer;
+        }
+        else
+        {
+            pSink->pHead = pBuffer;
+        }
+
+        pSink->pTail = pBuffer;
+        pSink->pActive = NULL;
+        pSink->queued++;
+
+        pthread_cond_signal( &pSink->ready );
+    }
+}
+
+/*==========================================================================*/
+/*  json_SinkOutput                                                         */
+/*!
+    Write a buffer to a file descriptor
+
+    The json_SinkOutput function writes the content of a buffer,
+    continuing after short writes and interruptions.
+
+    @param[in]
+        fd
+            the file descriptor to write to
+
+    @param[in]
+        pBuffer
+            pointer to the buffer to write
+
+    @retval EOK the buffer was written
+    @retval other error returned by write
+
+============================================================================*/
+static int json_SinkOutput( int fd, JSinkBuffer *pBuffer )
+{
+    int result = EOK;
+    size_t offset = 0;
+    ssize_t n;
+
+    while( ( result == EOK ) &&
+           ( offset < pBuffer->len ) )
+    {
+        n = write( fd, &pBuffer->data[offset], pBuffer->len - offset );
+        if( n >= 0 )
+        {
+            offset += n;
+        }
+        else if( errno != EINTR )
+        {
+            result = errno;
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_SinkDeadline                                                       */
+/*!
+    Compute the time of the next flush
+
+    The json_SinkDeadline function computes the monotonic clock time
+    one flush interval from now.
+
+    @param[in]
+        interval
+            flush interval in milliseconds
+
+    @param[out]
+        ts
+            location to store the time of the next flush
+
+============================================================================*/
+static void json_SinkDeadline( unsigned int interval, struct timespec *ts )
+{
+    clock_gettime( CLOCK_MONOTONIC, ts );
+
+    ts->tv_sec += interval / 1000;
+    ts->tv_nsec += ( interval % 1000 ) * 1000000L;
+    if( ts->tv_nsec >= 1000000000L )
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/*==========================================================================*/
+/*  json_SinkRecord                                                         */
+/*!
+    Get the calling thread's record buffer
+
+    The json_SinkRecord function gets the buffer in which the calling
+    thread serializes records, creating it on first use.  It is shared
+    by every asynchronous writer, and freed when the thread exits.
+
+    @retval pointer to the calling thread's record buffer
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static JSinkRecord *json_SinkRecord( void )
+{
+    JSinkRecord *pRecord = pthread_getspecific( json_sinkKey );
+
+    if( pRecord == NULL )
+    {
+        pRecord = calloc( 1, sizeof( JSinkRecord ) );
+        if( ( pRecord != NULL ) &&
+            ( pthread_setspecific( json_sinkKey, pRecord ) != 0 ) )
+        {
+            free( pRecord );
+            pRecord = NULL;
+        }
+    }
+
+    return pRecord;
+}
+
+/*==========================================================================*/
+/*  json_SinkKey                                                            */
+/*!
+    Create the key of the per-thread record buffers
+
+    The json_SinkKey function is run once by pthread_once to create the
+    key of the per-thread record buffers.
+
+============================================================================*/
+static void json_SinkKey( void )
+{
+    pthread_key_create( &json_sinkKey, json_SinkRecordFree );
+}
+
+/*==========================================================================*/
+/*  json_SinkRecordFree                                                     */
+/*!
+    Free a thread's record buffer
+
+    The json_SinkRecordFree function is the destructor of the per-thread
+    record buffers, invoked when a thread exits.
+
+    @param[in]
+        arg
+            pointer to the JSinkRecord to free
+
+============================================================================*/
+static void json_SinkRecordFree( void *arg )
+{
+    JSinkRecord *pRecord = (JSinkRecord *)arg;
+
+    if( pRecord != NULL )
+    {
+        free( pRecord->buf );
+        free( pRecord );
+    }
+}
+
+/*==========================================================================*/
+/*  json_SinkFree                                                           */
+/*!
+    Release an asynchronous JSON record writer
+
+    The json_SinkFree function releases the buffers and synchronization
+    objects of an asynchronous writer whose thread is not running.
+
+    @param[in]
+        pSink
+            pointer to the asynchronous JSON record writer
+
+============================================================================*/
+static void json_SinkFree( JAsyncSink *pSink )
+{
+    JSinkBuffer *pBuffer;
+
+    free( pSink->pActive );
+
+    while( pSink->pFree != NULL )
+    {
+        pBuffer = pSink->pFree;
+        pSink->pFree = pBuffer->pNext;
+        free( pBuffer );
+    }
+
+    while( pSink->pHead != NULL )
+    {
+        pBuffer = pSink->pHead;
+        pSink->pHead = pBuffer->pNext;
+        free( pBuffer );
+    }
+
+    pthread_cond_destroy( &pSink->ready );
+    pthread_cond_destroy( &pSink->space );
+    pthread_mutex_destroy( &pSink->lock );
+
+    free( pSink );
+}
@@ -0,0 +1,527 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <libgen.h>
+#include <sys/inotify.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! size of the inotify event buffer */
+#define JSON_WATCH_BUFSIZE  ( 4096 )
+
+/*! inotify events which indicate that a new version of the file is ready */
+#define JSON_WATCH_EVENTS   ( IN_CLOSE_WRITE | IN_MOVED_TO )
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! JSON file watcher state */
+struct _JWatch
+{
+    /*! full path of the watched file */
+    char *path;
+
+    /*! directory containing the watched file */
+    char *dir;
+
+    /*! base name of the watched file */
+    char *file;
+
+    /*! inotify file descriptor */
+    int fd;
+
+    /*! pipe used to wake up the watcher thread when stopping */
+    int stopfd[2];
+
+    /*! watcher thread */
+    pthread_t thread;
+
+    /*! most recently parsed version of the document */
+    JNode *pDoc;
+
+    /*! change notification callback */
+    JSON_WatchFn fn;
+
+    /*! opaque argument passed to the callback */
+    void *arg;
+};
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static void *json_WatchThread( void *arg );
+static void json_WatchReload( JWatch *pWatch );
+static int json_WatchChanges( JNode *a, JNode *b, JArray *pChanges );
+static int json_WatchChange( JArray *pChanges, char *path );
+static void json_WatchFree( JWatch *pWatch );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_Watch                                                              */
+/*!
+    Watch a JSON file for changes
+
+    The JSON_Watch function starts a background thread which uses inotify
+    to wait for changes to the specified JSON file.  Each time a new
+    version of the file is written (or renamed into place), it is
+    re-parsed using JSON_Process, compared against the previous version
+    using JSON_Diff, and the callback is invoked with the paths of the
+    values which changed.  Versions which fail to parse, or which do not
+    change any value, do not invoke the callback.
+
+    The containing directory is watched rather than the file itself so
+    that editors and tools which replace the file atomically are handled.
+
+    @param[in]
+        path
+            name of the JSON file to watch
+
+    @param[in]
+        fn
+            callback to invoke when the document changes
+
+    @param[in]
+        arg
+            opaque argument passed to the callback
+
+    @retval pointer to the JSON file watcher
+    @retval NULL if the watcher could not be started
+
+============================================================================*/
+JWatch *JSON_Watch( char *path, JSON_WatchFn fn, void *arg )
+{
+    JWatch *pWatch = NULL;
+    char *dirbuf = NULL;
+    char *filebuf = NULL;
+    bool ok = false;
+
+    if( ( path != NULL ) &&
+        ( fn != NULL ) )
+    {
+        pWatch = calloc( 1, sizeof( JWatch ) );
+        if( pWatch != NULL )
+        {
+            pWatch->fd = -1;
+            pWatch->stopfd[0] = -1;
+            pWatch->stopfd[1] = -1;
+            pWatch->fn = fn;
+            pWatch->arg = arg;
+
+            /* dirname and basename may modify their arguments */
+            pWatch->path = strdup( path );
+            dirbuf = strdup( path );
+            filebuf = strdup( path );
+            if( ( pWatch->path != NULL ) &&
+                ( dirbuf != NULL ) &&
+                ( filebuf != NULL ) )
+            {
+                pWatch->dir = strdup( dirname( dirbuf ) );
+                pWatch->file = strdup( basename( filebuf ) );
+            }
+
+            if( ( pWatch->dir != NULL ) &&
+                ( pWatch->file != NULL ) &&
+                ( pipe( pWatch->stopfd ) == 0 ) )
+            {
+                pWatch->fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+                if( ( pWatch->fd != -1 ) &&
+                    ( inotify_add_watch( pWatch->fd,
+                                         pWatch->dir,
+                                         JSON_WATCH_EVENTS ) != -1 ) )
+                {
+                    ok = ( pthread_create( &pWatch->thread,
+                                           NULL,
+                                           json_WatchThread,
+                                           pWatch ) == 0 );
+                }
+            }
+
+            free( dirbuf );
+            free( filebuf );
+
+            if( ok == false )
+            {
+                json_WatchFree( pWatch );
+                pWatch = NULL;
+            }
+        }
+    }
+
+    return pWatch;
+}
+
+/*==========================================================================*/
+/*  JSON_WatchStop                                                          */
+/*!
+    Stop watching a JSON file
+
+    The JSON_WatchStop function stops the watcher thread, waits for it
+    to exit, and releases the watcher and its most recent document.
+    The watcher is never freed while its thread is still running, even
+    if the stop request cannot be written.
+    It must not be called from within the watcher callback.
+
+    @param[in]
+        pWatch
+            pointer to the JSON file watcher to stop
+
+============================================================================*/
+void JSON_WatchStop( JWatch *pWatch )
+{
+    char c = 0;
+    ssize_t rc;
+
+    if( pWatch != NULL )
+    {
+        do
+        {
+            rc = write( pWatch->stopfd[1], &c, sizeof( c ) );
+        } while( ( rc == -1 ) && ( errno == EINTR ) );
+
+        if( rc != sizeof( c ) )
+        {
+            /* closing the write end also wakes the thread, since its
+               poll sees POLLHUP on the read end */
+            close( pWatch->stopfd[1] );
+            pWatch->stopfd[1] = -1;
+        }
+
+        /* the thread must have exited before the watcher is freed */
+        pthread_join( pWatch->thread, NULL );
+
+        json_WatchFree( pWatch );
+    }
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_WatchThread                                                        */
+/*!
+    JSON file watcher thread
+
+    The json_WatchThread function loads the initial version of the
+    watched file and then waits for inotify events on its directory
+    until it is told to stop.
+
+    @param[in]
+        arg
+            pointer to the JSON file watcher
+
+    @retval NULL always
+
+============================================================================*/
+static void *json_WatchThread( void *arg )
+{
+    JWatch *pWatch = (JWatch *)arg;
+    struct pollfd fds[2];
+    char buf[JSON_WATCH_BUFSIZE]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    struct inotify_event *event;
+    ssize_t len;
+    ssize_t i;
+    bool reload;
+
+    json_WatchReload( pWatch );
+
+    fds[0].fd = pWatch->fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = pWatch->stopfd[0];
+    fds[1].events = POLLIN;
+
+    while( 1 )
+    {
+        if( poll( fds, 2, -1 ) == -1 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        if( fds[1].revents != 0 )
+        {
+            /* we have been asked to stop */
+            break;
+        }
+
+        /* drain all pending events so a burst of writes causes
+           a single reload */
+        reload = false;
+        while( ( len = read( pWatch->fd, buf, sizeof( buf ) ) ) > 0 )
+        {
+            for( i = 0; i < len; i += sizeof( *event ) + event->len )
+            {
+                event = (struct inotify_event *)&buf[i];
+                if( ( event->len > 0 ) &&
+                    ( strcmp( event->name, pWatch->file ) == 0 ) )
+                {
+                    reload = true;
+                }
+            }
+        }
+
+        if( reload == true )
+        {
+            json_WatchReload( pWatch );
+        }
+    }
+
+    return NULL;
+}
+
+/*==========================================================================*/
+/*  json_WatchReload                                                        */
+/*!
+    Reload the watched file
+
+    The json_WatchReload function re-parses the watched file, diffs it
+    against the previous version, and invokes the watcher callback if
+    anything has changed.  If the file cannot be parsed, the previous
+    version is retained.  If the changes cannot be determined, the whole
+    document is reported as changed.
+
+    @param[in]
+        pWatch
+            pointer to the JSON file watcher
+
+============================================================================*/
+static void json_WatchReload( JWatch *pWatch )
+{
+    JNode *pDoc;
+    JArray *pChanges;
+
+    pDoc = JSON_Process( pWatch->path );
+    if( pDoc != NULL )
+    {
+        /* cache the subtree hashes so JSON_Diff can skip unchanged
+           subtrees of this version now, and of the next version later */
+        JSON_Hash( pDoc, JSON_HASH_UNORDERED );
+
+        pChanges = JSON_Array( NULL );
+        if( pChanges != NULL )
+        {
+            if( pWatch->pDoc == NULL )
+            {
+                /* first version, the whole document is new */
+                json_WatchChange( pChanges, "" );
+            }
+            else if( json_WatchChanges( pWatch->pDoc,
+                                        pDoc,
+                                        pChanges ) != EOK )
+            {
+                /* the changed paths are incomplete, so report the
+                   whole document as changed instead */
+                JSON_Free( (JNode *)pChanges );
+                pChanges = JSON_Array( NULL );
+                if( pChanges != NULL )
+                {
+                    json_WatchChange( pChanges, "" );
+                }
+            }
+        }
+
+        if( pChanges != NULL )
+        {
+            if( pChanges->n > 0 )
+            {
+                pWatch->fn( pDoc, pChanges, pWatch->arg );
+
+                JSON_Free( pWatch->pDoc );
+                pWatch->pDoc = pDoc;
+                pDoc = NULL;
+            }
+
+            JSON_Free( (JNode *)pChanges );
+        }
+
+        /* discard an unchanged (or unreported) document */
+        JSON_Free( pDoc );
+    }
+}
+
+/*==========================================================================*/
+/*  json_WatchChanges                                                       */
+/*!
+    Get the paths which differ between two JSON documents
+
+    The json_WatchChanges function diffs two versions of the watched
+    document using JSON_Diff and collects the path of every operation
+    in the resulting JSON Patch.
+
+    @param[in]
+        a
+            pointer to the previous version of the document
+
+    @param[in]
+        b
+            pointer to the new version of the document
+
+    @param[in]
+        pChanges
+            array to append the changed paths to
+
+    @retval EOK the changes were collected
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_WatchChanges( JNode *a, JNode *b, JArray *pChanges )
+{
+    int result = ENOMEM;
+    JArray *patch;
+    JNode *pOp;
+    char *path;
+
+    patch = JSON_Diff( a, b );
+    if( patch != NULL )
+    {
+        result = EOK;
+
+        pOp = patch->pFirst;
+        while( ( pOp != NULL ) && ( result == EOK ) )
+        {
+            path = JSON_GetStr( pOp, "path" );
+            if( path != NULL )
+            {
+                result = json_WatchChange( pChanges, path );
+            }
+
+            pOp = pOp->pNext;
+        }
+
+        JSON_Free( (JNode *)patch );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_WatchChange                                                        */
+/*!
+    Record a changed path
+
+    The json_WatchChange function appends a copy of the specified JSON
+    Pointer to the change list as a JSON string value.
+
+    @param[in]
+        pChanges
+            array to append the changed path to
+
+    @param[in]
+        path
+            JSON Pointer of the changed value
+
+    @retval EOK the path was recorded
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+static int json_WatchChange( JArray *pChanges, char *path )
+{
+    int result = ENOMEM;
+    char *str;
+    JVar *pVar;
+
+    str = strdup( path );
+    if( str != NULL )
+    {
+        pVar = JSON_Str( NULL, str );
+        if( pVar != NULL )
+        {
+            result = JSON_ArrayAdd( pChanges, (JObject *)pVar );
+        }
+        else
+        {
+            free( str );
+        }
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  json_WatchFree                                                          */
+/*!
+    Release a JSON file watcher
+
+    The json_WatchFree function closes all of the watcher's file
+    descriptors and frees its memory.  The watcher thread must not
+    be running.
+
+    @param[in]
+        pWatch
+            pointer to the JSON file watcher to free
+
+============================================================================*/
+static void json_WatchFree( JWatch *pWatch )
+{
+    if( pWatch->fd != -1 )
+    {
+        close( pWatch->fd );
+    }
+
+    if( pWatch->stopfd[0] != -1 )
+    {
+        close( pWatch->stopfd[0] );
+    }
+
+    if( pWatch->stopfd[1] != -1 )
+    {
+        close( pWatch->stopfd[1] );
+    }
+
+    JSON_Free( pWatch->pDoc );
+    free( pWatch->path );
+    free( pWatch->dir );
+    free( pWatch->file );
+    free( pWatch );
+}
@@ -0,0 +1,680 @@
+/*============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+============================================================================*/
+
+
+
+/*============================================================================
+        Includes
+============================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <tjson/json.h>
+
+/*============================================================================
+        Defines
+============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+#ifndef IOV_MAX
+#define IOV_MAX                 ( 1024 )
+#endif
+
+/*! size of the buffer holding the formatted pieces of a batch */
+#define JSON_WRITER_SCRATCH     ( 8192 )
+
+/*! strings shorter than this are copied rather than referenced */
+#define JSON_WRITER_INLINE      ( 128 )
+
+/*! space for a formatted number, enough for the largest float in %f */
+#define JSON_WRITER_NUMBER      ( 64 )
+
+/*============================================================================
+        Private Types
+============================================================================*/
+
+/*! storage for the current batch of a vectored write */
+typedef struct _JWriterBatch
+{
+    /*! pieces of the current batch */
+    struct iovec iov[IOV_MAX];
+
+    /*! formatted pieces of the current batch */
+    char scratch[JSON_WRITER_SCRATCH];
+
+} JWriterBatch;
+
+/*! state of a vectored write of a JSON object, or of a write of a JSON
+    object into a memory buffer */
+typedef struct _JWriter
+{
+    /*! file descriptor being written to */
+    int fd;
+
+    /*! first error encountered */
+    int result;
+
+    /*! number of entries of iov in use */
+    int cnt;
+
+    /*! number of bytes of scratch in use */
+    size_t used;
+
+    /*! pieces of the current batch */
+    struct iovec *iov;
+
+    /*! formatted pieces of the current batch */
+    char *scratch;
+
+    /*! memory buffer being written to, or NULL for a file descriptor */
+    char *buf;
+
+    /*! number of bytes of buf in use */
+    size_t len;
+
+    /*! size of buf */
+    size_t size;
+
+} JWriter;
+
+/*============================================================================
+        Private Function Declarations
+============================================================================*/
+
+static void json_WriterNode( JWriter *pWriter, JNode *json, bool comma );
+static void json_WriterValue( JWriter *pWriter, JVar *pVar );
+static void json_WriterText( JWriter *pWriter, const char *text, size_t len );
+static void json_WriterRef( JWriter *pWriter, const char *text, size_t len );
+static void json_WriterFormat( JWriter *pWriter, const char *fmt, ... );
+static void json_WriterFlush( JWriter *pWriter );
+static void json_WriterAppend( JWriter *pWriter,
+                               const char *text,
+                               size_t len );
+int json_WriterBuffer( JNode *json,
+                       char **ppBuf,
+                       size_t *pSize,
+                       size_t *pLen );
+
+/*============================================================================
+        Public Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  JSON_PrintFd                                                            */
+/*!
+    Output a JSON object to a file descriptor
+
+    The JSON_PrintFd function outputs the JSON object to a file
+    descriptor, such as a file or socket, in the same format as
+    JSON_Print.  Rather than copying everything into an output buffer,
+    it builds a list of pieces which is written with writev, up to
+    IOV_MAX pieces at a time.  Punctuation, numbers and short strings
+    are formatted into a scratch buffer, while long strings are
+    referenced where they are stored, so large string values are never
+    copied.
+
+    @param[in]
+        json
+            pointer to the JSON Object to output
+
+    @param[in]
+        fd
+            the file descriptor to write to
+
+    @retval EOK the JSON object was written
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+    @retval other error returned by writev
+
+============================================================================*/
+int JSON_PrintFd( JNode *json, int fd )
+{
+    int result = EINVAL;
+    JWriter writer;
+    JWriterBatch *pBatch;
+
+    if( ( json != NULL ) &&
+        ( fd >= 0 ) )
+    {
+        /* the batch is too large for the stack */
+        pBatch = malloc( sizeof( JWriterBatch ) );
+        if( pBatch != NULL )
+        {
+            writer.fd = fd;
+            writer.result = EOK;
+            writer.cnt = 0;
+            writer.used = 0;
+            writer.iov = pBatch->iov;
+            writer.scratch = pBatch->scratch;
+            writer.buf = NULL;
+
+            json_WriterNode( &writer, json, false );
+            json_WriterFlush( &writer );
+
+            result = writer.result;
+            free( pBatch );
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================
+        Private Function Definitions
+============================================================================*/
+
+/*==========================================================================*/
+/*  json_WriterNode                                                         */
+/*!
+    Output a JSON node to a writer
+
+    The json_WriterNode function outputs the JSON node recursively in
+    the same way as JSON_Print.
+
+    @param[in]
+        pWriter
+            pointer to the writer
+
+    @param[in]
+        json
+            pointer to the JSON node to output
+
+    @param[in]
+        comma
+            true - output leading comma
+            false - no leading comma
+
+============================================================================*/
+static void json_WriterNode( JWriter *pWriter, JNode *json, bool comma )
+{
+    JObject *pContainer;
+    JNode *pNode;
+
+    if( comma == true )
+    {
+        json_WriterText( pWriter, ",", 1 );
+        comma = false;
+    }
+
+    if( json->name != NULL )
+    {
+        json_WriterText( pWriter, "\"", 1 );
+        json_WriterRef( pWriter, json->name, strlen( json->name ) );
+        json_WriterText( pWriter, "\" : ", 4 );
+    }
+
+    switch( json->type )
+    {
+        case JSON_ARRAY:
+        case JSON_OBJECT:
+            pContainer = (JObject *)json;
+            json_WriterText( pWriter,
+                             ( json->type == JSON_ARRAY ) ? "[" : "{",
+                             1 );
+            pNode = pContainer->pFirst;
+            while( ( pNode != NULL ) &&
+                   ( pWriter->result == EOK ) )
+            {
+                json_WriterNode( pWriter, pNode, comma );
+                comma = true;
+                pNode = pNode->pNext;
+            }
+            json_WriterText( pWriter,
+                             ( json->type == JSON_ARRAY ) ? "]" : "}",
+                             1 );
+            break;
+
+        case JSON_NULL:
+            json_WriterText( pWriter, "null", 4 );
+            break;
+
+        case JSON_BOOL:
+        case JSON_VAR:
+            json_WriterValue( pWriter, (JVar *)json );
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*==========================================================================*/
+/*  json_WriterValue                                                        */
+/*!
+    Output a JSON value to a writer
+
+    The json_WriterValue function outputs the JSON value in the same
+    format as JSON_Print.
+
+    @param[in]
+        pWriter
+            pointer to the writer
+
+    @param[in]
+        pVar
+            pointer to the JSON Variable to output
+
+============================================================================*/
+static void json_WriterValue( JWriter *pWriter, JVar *pVar )
+{
+    if( pVar->node.type == JSON_BOOL )
+    {
+        if( pVar->var.val.ui > 0 )
+        {
+            json_WriterText( pWriter, "true", 4 );
+        }
+        else
+        {
+            json_WriterText( pWriter, "false ", 6 );
+        }
+    }
+    else
+    {
+        switch( pVar->var.type )
+        {
+            case JVARTYPE_UINT16:
+                json_WriterFormat( pWriter, "%d", pVar->var.val.ui );
+                break;
+
+            case JVARTYPE_INT16:
+                json_WriterFormat( pWriter, "%d", pVar->var.val.i );
+                break;
+
+            case JVARTYPE_UINT32:
+                json_WriterFormat( pWriter, "%d", pVar->var.val.ul );
+                break;
+
+            case JVARTYPE_INT32:
+                json_WriterFormat( pWriter, "%d", pVar->var.val.l );
+                break;
+
+            case JVARTYPE_UINT64:
+                json_WriterFormat( pWriter, "%" PRIu64, pVar->var.val.ull );
+                break;
+
+            case JVARTYPE_INT64:
+                json_WriterFormat( pWriter, "%" PRId64, pVar->var.val.ll );
+                break;
+
+            case JVARTYPE_FLOAT:
+                json_WriterFormat( pWriter, "%f", pVar->var.val.f );
+                break;
+
+            case JVARTYPE_STR:
+                json_WriterText( pWriter, "\"", 1 );
+                json_WriterRef( pWriter,
+                                pVar->var.val.str,
+                                strlen( pVar->var.val.str ) );
+                json_WriterText( pWriter, "\"", 1 );
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  json_WriterText                                                         */
+/*!
+    Copy text into the current batch
+
+    The json_WriterText function copies a short piece of text into the
+    scratch buffer.  Consecutive copied pieces share a single entry of
+    the batch.  The batch is written out first if it is full.  When
+    writing to memory, the text is appended to the memory buffer.
+
+    @param[in]
+        pWriter
+            pointer to the writer
+
+    @param[in]
+        text
+            pointer to the text to copy
+
+    @param[in]
+        len
+            length of the text, at most JSON_WRITER_SCRATCH
+
+============================================================================*/
+static void json_WriterText( JWriter *pWriter, const char *text, size_t len )
+{
+    struct iovec *pLast;
+    char *p;
+
+    if( pWriter->buf != NULL )
+    {
+        json_WriterAppend( pWriter, text, len );
+    }
+    else
+    {
+        if( ( pWriter->used + len > JSON_WRITER_SCRATCH ) ||
+            ( pWriter->cnt == IOV_MAX ) )
+        {
+            json_WriterFlush( pWriter );
+        }
+
+        p = &pWriter->scratch[pWriter->used];
+        memcpy( p, text, len );
+        pWriter->used += len;
+
+        pLast = ( pWriter->cnt > 0 ) ? &pWriter->iov[pWriter->cnt - 1]
+                                     : NULL;
+        if( ( pLast != NULL ) &&
+            ( (char *)pLast->iov_base + pLast->iov_len == p ) )
+        {
+            pLast->iov_len += len;
+        }
+        else
+        {
+            pWriter->iov[pWriter->cnt].iov_base = p;
+            pWriter->iov[pWriter->cnt].iov_len = len;
+            pWriter->cnt++;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  json_WriterRef                                                          */
+/*!
+    Add a string to the current batch
+
+    The json_WriterRef function adds a string to the batch by reference,
+    so it is written from where it is stored without being copied.
+    Short strings are copied into the scratch buffer instead, as a
+    separate entry would cost more than the copy.  When writing to
+    memory, every string is copied.
+
+    @param[in]
+        pWriter
+            pointer to the writer
+
+    @param[in]
+        text
+            pointer to the string
+
+    @param[in]
+        len
+            length of the string
+
+============================================================================*/
+static void json_WriterRef( JWriter *pWriter, const char *text, size_t len )
+{
+    if( ( len < JSON_WRITER_INLINE ) ||
+        ( pWriter->buf != NULL ) )
+    {
+        json_WriterText( pWriter, text, len );
+    }
+    else
+    {
+        if( pWriter->cnt == IOV_MAX )
+        {
+            json_WriterFlush( pWriter );
+        }
+
+        pWriter->iov[pWriter->cnt].iov_base = (void *)text;
+        pWriter->iov[pWriter->cnt].iov_len = len;
+        pWriter->cnt++;
+    }
+}
+
+/*==========================================================================*/
+/*  json_WriterFormat                                                       */
+/*!
+    Format a number into the current batch
+
+    The json_WriterFormat function formats a value into the scratch
+    buffer, using the same conversion as JSON_Print.
+
+    @param[in]
+        pWriter
+            pointer to the writer
+
+    @param[in]
+        fmt
+            printf style format of the value
+
+============================================================================*/
+static void json_WriterFormat( JWriter *pWriter, const char *fmt, ... )
+{
+    char buf[JSON_WRITER_NUMBER];
+    va_list args;
+    int n;
+
+    va_start( args, fmt );
+    n = vsnprintf( buf, sizeof( buf ), fmt, args );
+    va_end( args );
+
+    if( ( n > 0 ) &&
+        ( n < (int)sizeof( buf ) ) )
+    {
+        json_WriterText( pWriter, buf, n );
+    }
+}
+
+/*==========================================================================*/
+/*  json_WriterFlush                                                        */
+/*!
+    Write out the current batch
+
+    The json_WriterFlush function writes the pieces of the current batch
+    to the file descriptor with writev, continuing after short writes
+    and interruptions, and starts a new batch.
+
+    @param[in]
+        pWriter
+            pointer to the writer
+
+============================================================================*/
+static void json_WriterFlush( JWriter *pWriter )
+{
+    struct iovec *iov = pWriter->iov;
+    int cnt = pWriter->cnt;
+    ssize_t n;
+
+    while( ( cnt > 0 ) &&
+           ( pWriter->result == EOK ) )
+    {
+        n = writev( pWriter->fd, iov, cnt );
+        if( n < 0 )
+        {
+            if( errno != EINTR )
+            {
+                pWriter->result = errno;
+            }
+        }
+        else
+        {
+            /* skip the pieces which were written completely */
+            while( ( cnt > 0 ) &&
+                   ( (size_t)n >= iov->iov_len ) )
+            {
+                n -= iov->iov_len;
+                iov++;
+                cnt--;
+            }
+
+            if( cnt > 0 )
+            {
+                iov->iov_base = (char *)iov->iov_base + n;
+                iov->iov_len -= n;
+            }
+        }
+    }
+
+    pWriter->cnt = 0;
+    pWriter->used = 0;
+}
+
+/*==========================================================================*/
+/*  json_WriterAppend                                                       */
+/*!
+    Append text to a memory buffer
+
+    The json_WriterAppend function appends text to the memory buffer of
+    a writer, doubling the size of the buffer as needed.
+
+    @param[in]
+        pWriter
+            pointer to the writer
+
+    @param[in]
+        text
+            pointer to the text to append
+
+    @param[in]
+        len
+            length of the text
+
+============================================================================*/
+static void json_WriterAppend( JWriter *pWriter,
+                               const char *text,
+                               size_t len )
+{
+    size_t size = pWriter->size;
+    char *p;
+
+    if( pWriter->result == EOK )
+    {
+        while( pWriter->len + len > size )
+        {
+            size *= 2;
+        }
+
+        if( size > pWriter->size )
+        {
+            p = realloc( pWriter->buf, size );
+            if( p != NULL )
+            {
+                pWriter->buf = p;
+                pWriter->size = size;
+            }
+            else
+            {
+                pWriter->result = ENOMEM;
+            }
+        }
+
+        if( pWriter->result == EOK )
+        {
+            memcpy( &pWriter->buf[pWriter->len], text, len );
+            pWriter->len += len;
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  json_WriterBuffer                                                       */
+/*!
+    Output a JSON object to a memory buffer
+
+    The json_WriterBuffer function appends the JSON object to a heap
+    allocated memory buffer, in the same format as JSON_Print, growing
+    the buffer with realloc as needed.  The buffer may be reused for
+    many objects to avoid allocating for each of them.
+
+    @param[in]
+        json
+            pointer to the JSON Object to output
+
+    @param[in,out]
+        ppBuf
+            location of the pointer to the buffer, which may be NULL
+
+    @param[in,out]
+        pSize
+            location of the size of the buffer
+
+    @param[in,out]
+        pLen
+            location of the number of bytes of the buffer in use
+
+    @retval EOK the JSON object was appended to the buffer
+    @retval EINVAL invalid arguments
+    @retval ENOMEM memory allocation failure
+
+============================================================================*/
+int json_WriterBuffer( JNode *json,
+                       char **ppBuf,
+                       size_t *pSize,
+                       size_t *pLen )
+{
+    int result = EINVAL;
+    JWriter writer;
+
+    if( ( json != NULL ) &&
+        ( ppBuf != NULL ) &&
+        ( pSize != NULL ) &&
+        ( pLen != NULL ) )
+    {
+        writer.fd = -1;
+        writer.result = EOK;
+        writer.cnt = 0;
+        writer.used = 0;
+        writer.iov = NULL;
+        writer.scratch = NULL;
+        writer.buf = *ppBuf;
+        writer.len = *pLen;
+        writer.size = *pSize;
+
+        if( writer.buf == NULL )
+        {
+            writer.size = JSON_WRITER_SCRATCH;
+            writer.buf = malloc( writer.size );
+            writer.len = 0;
+        }
+
+        if( writer.buf != NULL )
+        {
+            json_WriterNode( &writer, json, false );
+
+            *ppBuf = writer.buf;
+            *pSize = writer.size;
+            *pLen = writer.len;
+            result = writer.result;
+        }
+        else
+        {
+            result = ENOMEM;
+        }
+    }
+
+    return result;
+}
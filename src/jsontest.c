@@ -52,12 +52,26 @@ SOFTWARE.
 #include <stddef.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
 #include <tjson/json.h>
 
 /*============================================================================
         Defines
 ============================================================================*/
 
+/*! number of records used by the small container benchmark */
+#define BENCH_RECORDS   ( 200000 )
+
+/*! number of lookup passes made over the benchmark records */
+#define BENCH_PASSES    ( 10 )
+
+/*! number of heap blocks allocated to fragment the heap */
+#define BENCH_FRAGMENTS ( 2000000 )
+
+/*! largest packed container, the library default */
+#define BENCH_SMALL_MAX ( 8 )
+
 /*============================================================================
         External Variables
 ============================================================================*/
@@ -66,11 +80,243 @@ SOFTWARE.
         Public Types
 ============================================================================*/
 
+/*! JSON Patch or JSON Merge Patch test vector */
+typedef struct _PatchVector
+{
+    /*! the document to patch */
+    char *doc;
+
+    /*! the patch to apply */
+    char *patch;
+
+    /*! the expected document, if the patch succeeds */
+    char *expected;
+
+    /*! the expected result of applying the patch */
+    int result;
+} PatchVector;
+
+/*! JSON_Diff round trip test vector */
+typedef struct _DiffVector
+{
+    /*! the original document */
+    char *a;
+
+    /*! the updated document */
+    char *b;
+} DiffVector;
+
+/*============================================================================
+        Private File Scoped Variables
+============================================================================*/
+
+/*! RFC 6902 Appendix A examples */
+static const PatchVector patchVectors[] =
+{
+    /* A.1 adding an object member */
+    { "{\"foo\":\"bar\"}",
+      "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\"}]",
+      "{\"baz\":\"qux\",\"foo\":\"bar\"}",
+      EOK },
+
+    /* A.2 adding an array element */
+    { "{\"foo\":[\"bar\",\"baz\"]}",
+      "[{\"op\":\"add\",\"path\":\"/foo/1\",\"value\":\"qux\"}]",
+      "{\"foo\":[\"bar\",\"qux\",\"baz\"]}",
+      EOK },
+
+    /* A.3 removing an object member */
+    { "{\"baz\":\"qux\",\"foo\":\"bar\"}",
+      "[{\"op\":\"remove\",\"path\":\"/baz\"}]",
+      "{\"foo\":\"bar\"}",
+      EOK },
+
+    /* A.4 removing an array element */
+    { "{\"foo\":[\"bar\",\"qux\",\"baz\"]}",
+      "[{\"op\":\"remove\",\"path\":\"/foo/1\"}]",
+      "{\"foo\":[\"bar\",\"baz\"]}",
+      EOK },
+
+    /* A.5 replacing a value */
+    { "{\"baz\":\"qux\",\"foo\":\"bar\"}",
+      "[{\"op\":\"replace\",\"path\":\"/baz\",\"value\":\"boo\"}]",
+      "{\"baz\":\"boo\",\"foo\":\"bar\"}",
+      EOK },
+
+    /* A.6 moving a value */
+    { "{\"foo\":{\"bar\":\"baz\",\"waldo\":\"fred\"},"
+      "\"qux\":{\"corge\":\"grault\"}}",
+      "[{\"op\":\"move\",\"from\":\"/foo/waldo\",\"path\":\"/qux/thud\"}]",
+      "{\"foo\":{\"bar\":\"baz\"},"
+      "\"qux\":{\"corge\":\"grault\",\"thud\":\"fred\"}}",
+      EOK },
+
+    /* A.7 moving an array element */
+    { "{\"foo\":[\"all\",\"grass\",\"cows\",\"eat\"]}",
+      "[{\"op\":\"move\",\"from\":\"/foo/1\",\"path\":\"/foo/3\"}]",
+      "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}",
+      EOK },
+
+    /* A.8 testing a value: success */
+    { "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}",
+      "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"qux\"},"
+      "{\"op\":\"test\",\"path\":\"/foo/1\",\"value\":2}]",
+      "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}",
+      EOK },
+
+    /* A.9 testing a value: error */
+    { "{\"baz\":\"qux\"}",
+      "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"bar\"}]",
+      NULL,
+      ECANCELED },
+
+    /* A.10 adding a nested member object */
+    { "{\"foo\":\"bar\"}",
+      "[{\"op\":\"add\",\"path\":\"/child\","
+      "\"value\":{\"grandchild\":{}}}]",
+      "{\"foo\":\"bar\",\"child\":{\"grandchild\":{}}}",
+      EOK },
+
+    /* A.11 ignoring unrecognized elements */
+    { "{\"foo\":\"bar\"}",
+      "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\","
+      "\"xyz\":123}]",
+      "{\"foo\":\"bar\",\"baz\":\"qux\"}",
+      EOK },
+
+    /* A.12 adding to a nonexistent target */
+    { "{\"foo\":\"bar\"}",
+      "[{\"op\":\"add\",\"path\":\"/baz/bat\",\"value\":\"qux\"}]",
+      NULL,
+      ENOENT },
+
+    /* A.13 invalid JSON Patch document */
+    { "{\"foo\":\"bar\"}",
+      "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\","
+      "\"op\":\"remove\"}]",
+      NULL,
+      EINVAL },
+
+    /* A.14 ~ escape ordering */
+    { "{\"/\":9,\"~1\":10}",
+      "[{\"op\":\"test\",\"path\":\"/~01\",\"value\":10}]",
+      "{\"/\":9,\"~1\":10}",
+      EOK },
+
+    /* A.15 comparing strings and numbers */
+    { "{\"/\":9,\"~1\":10}",
+      "[{\"op\":\"test\",\"path\":\"/~01\",\"value\":\"10\"}]",
+      NULL,
+      ECANCELED },
+
+    /* A.16 adding an array value */
+    { "{\"foo\":[\"bar\"]}",
+      "[{\"op\":\"add\",\"path\":\"/foo/-\","
+      "\"value\":[\"abc\",\"def\"]}]",
+      "{\"foo\":[\"bar\",[\"abc\",\"def\"]]}",
+      EOK }
+};
+
+/*! RFC 7396 Appendix A examples.  A merge patch which changes the kind
+    of the document root is not supported, since the root node is owned
+    by the caller */
+static const PatchVector mergeVectors[] =
+{
+    { "{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}", EOK },
+    { "{\"a\":\"b\"}", "{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}", EOK },
+    { "{\"a\":\"b\"}", "{\"a\":null}", "{}", EOK },
+    { "{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}", "{\"b\":\"c\"}", EOK },
+    { "{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":\"c\"}", EOK },
+    { "{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":[\"b\"]}", EOK },
+    { "{\"a\":{\"b\":\"c\"}}",
+      "{\"a\":{\"b\":\"d\",\"c\":null}}",
+      "{\"a\":{\"b\":\"d\"}}",
+      EOK },
+    { "{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}", "{\"a\":[1]}", EOK },
+    { "[\"a\",\"b\"]", "[\"c\",\"d\"]", "[\"c\",\"d\"]", EOK },
+    { "{\"a\":\"b\"}", "[\"c\"]", NULL, ENOTSUP },
+    { "{\"a\":\"foo\"}", "null", NULL, ENOTSUP },
+    { "{\"a\":\"foo\"}", "\"bar\"", NULL, ENOTSUP },
+    { "{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}", EOK },
+    { "[1,2]", "{\"a\":\"b\",\"c\":null}", NULL, ENOTSUP },
+    { "{}",
+      "{\"a\":{\"bb\":{\"ccc\":null}}}",
+      "{\"a\":{\"bb\":{}}}",
+      EOK }
+};
+
+/*! JSON_Diff round trips */
+static const DiffVector diffVectors[] =
+{
+    /* scalar changes, additions and removals */
+    { "{\"a\":1,\"b\":\"x\",\"c\":true}",
+      "{\"a\":2,\"b\":\"x\",\"d\":null}" },
+
+    /* values which change kind */
+    { "{\"a\":[1,2],\"b\":{\"x\":1},\"c\":3}",
+      "{\"a\":{\"x\":1},\"b\":[1,2],\"c\":\"3\"}" },
+
+    /* array insertions */
+    { "[1,2,3]", "[0,1,2,9,3,4]" },
+
+    /* array removals */
+    { "[0,1,2,9,3,4]", "[1,3]" },
+    { "{\"a\":[1,2,3]}", "{\"a\":[]}" },
+    { "{\"a\":[]}", "{\"a\":[1,2,3]}" },
+
+    /* nested containers */
+    { "{\"a\":[1,{\"b\":[1,2],\"c\":{}}],\"d\":{\"e\":{\"f\":1}}}",
+      "{\"a\":[1,{\"b\":[2],\"c\":{\"g\":[]}},3],\"d\":{\"e\":{}}}" },
+
+    /* names which need escaping in a JSON Pointer */
+    { "{\"a/b\":1,\"c~d\":{\"~\":2}}", "{\"a/b\":3,\"c~d\":{\"/\":2}}" },
+
+    /* objects large enough to be matched through a key index */
+    { "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8}",
+      "{\"a\":1,\"b\":0,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9}" },
+    { "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8}",
+      "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"a\":8}" },
+
+    /* duplicate names */
+    { "{\"a\":1,\"a\":2}", "{\"a\":3}" },
+    { "{\"a\":1}", "{\"a\":1,\"a\":2}" },
+    { "{\"a\":1,\"a\":2,\"b\":3}", "{\"b\":3,\"a\":2,\"a\":1}" }
+};
+
+/*! document used by the memory management tests */
+static char *memoryDoc =
+    "{\"a\":{\"n\":1,\"s\":\"x\"},\"b\":[1,2,3],"
+    "\"c\":{\"d\":{\"e\":true}},\"f\":\"str\"}";
+
 /*============================================================================
         Private Function Declarations
 ============================================================================*/
 static void usage( void );
 static void BuildObj( void );
+static int TestCompress( void );
+static int TestCompressType( JCompression type, char *name );
+static int TestCompressDamaged( char *path, size_t keep, long flip );
+static int TestPatch( void );
+static int TestPatchVector( const PatchVector *pVector, bool merge );
+static int TestDiffVector( const DiffVector *pVector );
+static JNode *TestParseValue( char *text );
+static int TestMemory( void );
+static int TestCheck( bool ok, char *what );
+static int TestCompactMutate( void );
+static int TestMutate( JNode *pDoc );
+static int TestPersistentFree( bool originFirst );
+static int TestSmallRemove( void );
+static int TestIndexChurn( void );
+static int TestRetainDetach( void );
+static int TestCloneFree( void );
+static void BenchSmall( void );
+static void BenchSmallRun( char *heap,
+                           char *layout,
+                           char *buf,
+                           size_t max );
+static JNode *BenchSmallBuild( void );
+static void **BenchFragment( void );
+static double BenchTime( void );
 
 /*============================================================================
         Public Function Declarations
@@ -105,7 +351,7 @@ void main(int argc, char **argv)
     char *inbuf;
     JNode *pNode;
 
-    while( ( c = getopt( argc, argv, "do:hb" ) ) != -1 )
+    while( ( c = getopt( argc, argv, "do:hbzpms" ) ) != -1 )
     {
         switch( c )
         {
@@ -113,6 +359,23 @@ void main(int argc, char **argv)
                 BuildObj();
                 break;
 
+            case 'z':
+                exit( TestCompress() );
+                break;
+
+            case 'p':
+                exit( TestPatch() );
+                break;
+
+            case 'm':
+                exit( TestMemory() );
+                break;
+
+            case 's':
+                BenchSmall();
+                exit( 0 );
+                break;
+
             case 'd':
                 debug = true;
                 break;
@@ -161,10 +424,14 @@ void main(int argc, char **argv)
 ============================================================================*/
 static void usage( void )
 {
-    printf("usage: jsontest [-d] [-o output_file] [-h] [-b]\n" );
+    printf("usage: jsontest [-d] [-o output_file] [-h] [-b] [-z] [-p] [-m] [-s]\n" );
     printf("\t-d enable debug output\n");
     printf("\t-h display this help\n");
     printf("\t-b build a sample object\n");
+    printf("\t-z test compressed input and output\n");
+    printf("\t-p test JSON Patch, JSON Merge Patch and JSON_Diff\n");
+    printf("\t-m test memory management of mutable documents\n");
+    printf("\t-s benchmark packed small containers\n");
     printf("\t-o <filename> specifies the output file\n");
 
     exit( 0 );
@@ -227,5 +494,1215 @@ static void BuildObj( void )
     printf("\n");
 }
 
+/*==========================================================================*/
+/*  TestCompress                                                            */
+/*!
+    Test compressed input and output
+
+    The TestCompress function writes a document through JSON_Compress
+    in each compression format, checks that JSON_Process reads back an
+    equal document, and that truncated or corrupted copies of the
+    compressed file are rejected.  Formats which were not built in are
+    skipped.
+
+    @retval 0 all tests passed
+    @retval 1 a test failed
+
+============================================================================*/
+static int TestCompress( void )
+{
+    int failures = 0;
+
+    failures += TestCompressType( JSON_COMPRESSION_GZIP, "gzip" );
+    failures += TestCompressType( JSON_COMPRESSION_ZSTD, "zstd" );
+
+    printf( "compression tests: %s\n", ( failures == 0 ) ? "PASS" : "FAIL" );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestCompressType                                                        */
+/*!
+    Test one compression format
+
+    The TestCompressType function round trips a document through a
+    compressed file, then checks that a copy missing its last bytes and
+    a copy with a corrupted checksum are both rejected.
+
+    @param[in]
+        type
+            the compression format
+
+    @param[in]
+        name
+            name of the compression format
+
+    @retval number of failed tests
+
+============================================================================*/
+static int TestCompressType( JCompression type, char *name )
+{
+    char path[] = "/tmp/jsontestXXXXXX";
+    char *doc = "{\"name\":\"archive\",\"n\":[1,2,3,{\"x\":true}],"
+                "\"s\":\"a string which is long enough to compress\"}";
+    JNode *pDoc;
+    JNode *pRead;
+    FILE *fp = NULL;
+    FILE *out = NULL;
+    int failures = 0;
+    long size = 0;
+    long flip;
+    int fd;
+
+    pDoc = JSON_ProcessBuffer( doc );
+    fd = mkstemp( path );
+    if( fd != -1 )
+    {
+        fp = fdopen( fd, "w" );
+    }
+
+    if( fp != NULL )
+    {
+        out = JSON_Compress( fp, type, 0 );
+        if( out == NULL )
+        {
+            fclose( fp );
+        }
+    }
+
+    if( out != NULL )
+    {
+        JSON_Print( pDoc, out, false );
+        if( fclose( out ) != 0 )
+        {
+            failures++;
+        }
+
+        pRead = JSON_Process( path );
+        if( JSON_Equal( pDoc, pRead ) == false )
+        {
+            printf( "%s: round trip failed\n", name );
+            failures++;
+        }
+
+        JSON_Free( pRead );
+
+        fp = fopen( path, "r" );
+        if( fp != NULL )
+        {
+            fseek( fp, 0, SEEK_END );
+            size = ftell( fp );
+            fclose( fp );
+        }
+
+        /* truncated, and a corrupted trailer (gzip CRC or zstd checksum) */
+        if( TestCompressDamaged( path, size - 2, -1 ) != 0 )
+        {
+            printf( "%s: truncated archive accepted\n", name );
+            failures++;
+        }
+
+        flip = ( type == JSON_COMPRESSION_GZIP ) ? size - 8 : size - 1;
+        if( TestCompressDamaged( path, size, flip ) != 0 )
+        {
+            printf( "%s: corrupted archive accepted\n", name );
+            failures++;
+        }
+    }
+    else if( errno == ENOTSUP )
+    {
+        printf( "%s: not built in, skipped\n", name );
+    }
+    else
+    {
+        printf( "%s: cannot create compressed file\n", name );
+        failures++;
+    }
+
+    if( fd != -1 )
+    {
+        unlink( path );
+    }
+
+    JSON_Free( pDoc );
+
+    return failures;
+}
+
+/*==========================================================================*/
+/*  TestCompressDamaged                                                     */
+/*!
+    Check that a damaged compressed file is rejected
+
+    The TestCompressDamaged function copies the start of a compressed
+    file, optionally flipping the bits of one byte, and checks that
+    JSON_Process rejects the copy with an input error.
+
+    @param[in]
+        path
+            name of the compressed file
+
+    @param[in]
+        keep
+            number of bytes to copy
+
+    @param[in]
+        flip
+            offset of the byte to corrupt, or -1
+
+    @retval 0 the damaged copy was rejected
+    @retval 1 the damaged copy was accepted
+
+============================================================================*/
+static int TestCompressDamaged( char *path, size_t keep, long flip )
+{
+    char copy[] = "/tmp/jsontestXXXXXX";
+    char buf[4096];
+    JParseError err;
+    JNode *pDoc;
+    FILE *in;
+    FILE *out = NULL;
+    size_t n;
+    int result = 1;
+    int fd;
+
+    in = fopen( path, "r" );
+    fd = mkstemp( copy );
+    if( fd != -1 )
+    {
+        out = fdopen( fd, "w" );
+    }
+
+    if( ( in != NULL ) &&
+        ( out != NULL ) &&
+        ( keep <= sizeof( buf ) ) )
+    {
+        n = fread( buf, 1, keep, in );
+        if( ( flip >= 0 ) && ( (size_t)flip < n ) )
+        {
+            buf[flip] ^= 0xff;
+        }
+
+        fwrite( buf, 1, n, out );
+        fclose( out );
+        out = NULL;
+
+        pDoc = JSON_Process( copy );
+        JSON_GetParseError( &err );
+        if( ( pDoc == NULL ) &&
+            ( ( err.error == EIO ) || ( err.error == EBADMSG ) ) )
+        {
+            result = 0;
+        }
+
+        JSON_Free( pDoc );
+    }
+
+    if( in != NULL )
+    {
+        fclose( in );
+    }
+
+    if( out != NULL )
+    {
+        fclose( out );
+    }
+
+    if( fd != -1 )
+    {
+        unlink( copy );
+    }
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  TestPatch                                                               */
+/*!
+    Test JSON Patch, JSON Merge Patch and JSON_Diff
+
+    The TestPatch function applies the examples from Appendix A of
+    RFC 6902 and RFC 7396, and checks that the patch generated by
+    JSON_Diff turns each original document of diffVectors into the
+    updated document.
+
+    @retval 0 all tests passed
+    @retval 1 a test failed
+
+============================================================================*/
+static int TestPatch( void )
+{
+    int failures = 0;
+    size_t i;
+
+    for( i = 0; i < sizeof( patchVectors ) / sizeof( patchVectors[0] ); i++ )
+    {
+        failures += TestPatchVector( &patchVectors[i], false );
+    }
+
+    for( i = 0; i < sizeof( mergeVectors ) / sizeof( mergeVectors[0] ); i++ )
+    {
+        failures += TestPatchVector( &mergeVectors[i], true );
+    }
+
+    for( i = 0; i < sizeof( diffVectors ) / sizeof( diffVectors[0] ); i++ )
+    {
+        failures += TestDiffVector( &diffVectors[i] );
+    }
+
+    printf( "patch tests: %s\n", ( failures == 0 ) ? "PASS" : "FAIL" );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestPatchVector                                                         */
+/*!
+    Apply a JSON Patch or JSON Merge Patch test vector
+
+    The TestPatchVector function applies the patch of a test vector to
+    its document, and checks the result and the patched document.
+
+    @param[in]
+        pVector
+            pointer to the test vector
+
+    @param[in]
+        merge
+            true if the patch is a JSON Merge Patch
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestPatchVector( const PatchVector *pVector, bool merge )
+{
+    int result = 1;
+    JNode *pDoc;
+    JNode *pPatch;
+    JNode *pExpected = NULL;
+    int rc = EINVAL;
+
+    pDoc = JSON_ProcessBuffer( pVector->doc );
+    pPatch = TestParseValue( pVector->patch );
+    if( pVector->expected != NULL )
+    {
+        pExpected = JSON_ProcessBuffer( pVector->expected );
+    }
+
+    if( ( pDoc != NULL ) && ( pPatch != NULL ) )
+    {
+        if( merge == true )
+        {
+            rc = JSON_MergePatch( pDoc, pPatch );
+        }
+        else if( pPatch->type == JSON_ARRAY )
+        {
+            rc = JSON_ApplyPatch( pDoc, (JArray *)pPatch );
+        }
+
+        if( ( rc == pVector->result ) &&
+            ( ( rc != EOK ) || ( JSON_Equal( pDoc, pExpected ) == true ) ) )
+        {
+            result = 0;
+        }
+    }
+
+    if( result != 0 )
+    {
+        printf( "%s %s to %s: result %d, expected %d\n",
+                ( merge == true ) ? "merge" : "patch",
+                pVector->patch,
+                pVector->doc,
+                rc,
+                pVector->result );
+    }
+
+    JSON_Free( pDoc );
+    JSON_Free( pPatch );
+    JSON_Free( pExpected );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  TestDiffVector                                                          */
+/*!
+    Round trip a JSON_Diff test vector
+
+    The TestDiffVector function generates the patch between the two
+    documents of a test vector with JSON_Diff, applies it to the first
+    document, and checks that the result is equal to the second.
+
+    @param[in]
+        pVector
+            pointer to the test vector
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestDiffVector( const DiffVector *pVector )
+{
+    int result = 1;
+    JNode *pA;
+    JNode *pB;
+    JArray *pPatch = NULL;
+
+    pA = JSON_ProcessBuffer( pVector->a );
+    pB = JSON_ProcessBuffer( pVector->b );
+    if( ( pA != NULL ) && ( pB != NULL ) )
+    {
+        pPatch = JSON_Diff( pA, pB );
+        if( ( pPatch != NULL ) &&
+            ( JSON_ApplyPatch( pA, pPatch ) == EOK ) &&
+            ( JSON_Equal( pA, pB ) == true ) )
+        {
+            result = 0;
+        }
+    }
+
+    if( result != 0 )
+    {
+        printf( "diff %s to %s: ", pVector->a, pVector->b );
+        JSON_Print( (JNode *)pPatch, stdout, false );
+        printf( "\n" );
+    }
+
+    JSON_Free( pA );
+    JSON_Free( pB );
+    JSON_Free( (JNode *)pPatch );
+
+    return result;
+}
+
+/*==========================================================================*/
+/*  TestParseValue                                                          */
+/*!
+    Parse a JSON value
+
+    The TestParseValue function parses a JSON document, or a scalar
+    value, which the parser only accepts inside an array, by parsing it
+    as the only element of an array.
+
+    @param[in]
+        text
+            pointer to the JSON text
+
+    @retval pointer to the parsed value
+    @retval NULL the value could not be parsed
+
+============================================================================*/
+static JNode *TestParseValue( char *text )
+{
+    JNode *pValue;
+    JNode *pArray;
+    char buf[256];
+
+    pValue = JSON_ProcessBuffer( text );
+    if( ( pValue == NULL ) &&
+        ( (size_t)snprintf( buf, sizeof( buf ), "[%s]", text ) <
+          sizeof( buf ) ) )
+    {
+        pArray = JSON_ProcessBuffer( buf );
+        if( ( pArray != NULL ) &&
+            ( ((JArray *)pArray)->n == 1 ) )
+        {
+            pValue = ((JArray *)pArray)->pFirst;
+            JSON_Remove( pArray, pValue );
+        }
+
+        JSON_Free( pArray );
+    }
+
+    return pValue;
+}
+
+/*==========================================================================*/
+/*  TestMemory                                                              */
+/*!
+    Test the memory management of mutable documents
+
+    The TestMemory function exercises the storage layouts which a
+    document may end up in: compacted blocks, members borrowed by
+    persistent versions, packed small containers, hash indexes of
+    large objects, retained subtrees, clones and arenas.  Each test
+    mutates and frees the document in an order which has been
+    troublesome, so it is most useful when run under a memory checker.
+
+    @retval 0 all tests passed
+    @retval 1 a test failed
+
+============================================================================*/
+static int TestMemory( void )
+{
+    int failures = 0;
+
+    failures += TestCompactMutate();
+    failures += TestPersistentFree( true );
+    failures += TestPersistentFree( false );
+    failures += TestSmallRemove();
+    failures += TestIndexChurn();
+    failures += TestRetainDetach();
+    failures += TestCloneFree();
+
+    printf( "memory tests: %s\n", ( failures == 0 ) ? "PASS" : "FAIL" );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestCheck                                                               */
+/*!
+    Check a test condition
+
+    The TestCheck function reports a test condition which does not
+    hold.
+
+    @param[in]
+        ok
+            the test condition
+
+    @param[in]
+        what
+            description of the condition
+
+    @retval 0 the condition holds
+    @retval 1 the condition does not hold
+
+============================================================================*/
+static int TestCheck( bool ok, char *what )
+{
+    if( ok == false )
+    {
+        printf( "memory test failed: %s\n", what );
+    }
+
+    return ( ok == true ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestCompactMutate                                                       */
+/*!
+    Test mutating a compacted document
+
+    The TestCompactMutate function fragments a document by replacing
+    one of its members repeatedly, compacts it, and applies the same
+    changes to it and to an uncompacted copy, which must stay equal
+    through a second compaction until both are freed.
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestCompactMutate( void )
+{
+    int failures = 0;
+    JNode *pDoc;
+    JNode *pRef;
+    int i;
+
+    pDoc = JSON_ProcessBuffer( memoryDoc );
+    pRef = JSON_ProcessBuffer( memoryDoc );
+    if( ( pDoc != NULL ) && ( pRef != NULL ) )
+    {
+        for( i = 0; i < 64; i++ )
+        {
+            JSON_ObjectReplace( (JObject *)pDoc,
+                                (JNode *)JSON_Num( strdup( "g" ), i ) );
+            JSON_ObjectReplace( (JObject *)pRef,
+                                (JNode *)JSON_Num( strdup( "g" ), i ) );
+        }
+
+        failures += TestCheck( JSON_Compact( pDoc ) == EOK, "compact" );
+        failures += TestCheck( JSON_Equal( pDoc, pRef ),
+                               "compacted document is unchanged" );
+
+        failures += TestMutate( pDoc );
+        failures += TestMutate( pRef );
+        failures += TestCheck( JSON_Equal( pDoc, pRef ),
+                               "compacted document can be mutated" );
+
+        failures += TestCheck( JSON_Compact( pDoc ) == EOK, "compact again" );
+        failures += TestCheck( JSON_Equal( pDoc, pRef ),
+                               "document is unchanged by a second compact" );
+    }
+    else
+    {
+        failures += TestCheck( false, "parse document to compact" );
+    }
+
+    JSON_Free( pDoc );
+    JSON_Free( pRef );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestMutate                                                              */
+/*!
+    Apply a set of changes to a copy of the memory test document
+
+    The TestMutate function updates scalar members, adds a member and
+    removes a member of a document parsed from memoryDoc.
+
+    @param[in]
+        pDoc
+            pointer to the document to change
+
+    @retval 0 the changes were made
+    @retval 1 a change failed
+
+============================================================================*/
+static int TestMutate( JNode *pDoc )
+{
+    int failures = 0;
+    JNode *pA;
+    JNode *pB;
+
+    pA = JSON_Attribute( (JObject *)pDoc, "a" );
+    failures += TestCheck( JSON_SetNum( pA, "n", 42 ) == EOK, "set number" );
+    failures += TestCheck( JSON_SetStr( pA, "s", "changed" ) == EOK,
+                           "set string" );
+    failures += TestCheck( JSON_ObjectAdd( (JObject *)pDoc,
+                                           (JNode *)JSON_Num( strdup( "h" ),
+                                                              7 ) ) == EOK,
+                           "add member" );
+
+    pB = JSON_Attribute( (JObject *)pDoc, "b" );
+    failures += TestCheck( JSON_Remove( pDoc, pB ) == EOK, "remove member" );
+    JSON_Free( pB );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestPersistentFree                                                      */
+/*!
+    Test freeing persistent versions in either order
+
+    The TestPersistentFree function creates two successive persistent
+    versions of a document, and frees them either oldest or newest
+    first, checking that the versions which remain are intact.  It also
+    checks that the original cannot be modified once its members are
+    shared.
+
+    @param[in]
+        originFirst
+            true to free the original document first
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestPersistentFree( bool originFirst )
+{
+    int failures = 0;
+    JNode *pVersion[3];
+    JNode *pExpected[3];
+    int i;
+
+    pVersion[0] = JSON_ProcessBuffer( memoryDoc );
+    pVersion[1] = JSON_SetPathPersistent( pVersion[0],
+                                          "/c/d/e",
+                                          (JNode *)JSON_Num( NULL, 5 ) );
+    pVersion[2] = JSON_SetPathPersistent( pVersion[1],
+                                          "/b/-",
+                                          (JNode *)JSON_Num( NULL, 4 ) );
+
+    pExpected[0] = JSON_ProcessBuffer( memoryDoc );
+    pExpected[1] = JSON_ProcessBuffer(
+        "{\"a\":{\"n\":1,\"s\":\"x\"},\"b\":[1,2,3],"
+        "\"c\":{\"d\":{\"e\":5}},\"f\":\"str\"}" );
+    pExpected[2] = JSON_ProcessBuffer(
+        "{\"a\":{\"n\":1,\"s\":\"x\"},\"b\":[1,2,3,4],"
+        "\"c\":{\"d\":{\"e\":5}},\"f\":\"str\"}" );
+
+    if( ( pVersion[2] != NULL ) && ( pExpected[2] != NULL ) )
+    {
+        failures += TestCheck(
+            JSON_SetNum( JSON_Attribute( (JObject *)pVersion[0], "a" ),
+                         "n",
+                         2 ) == EPERM,
+            "shared members are read-only" );
+
+        for( i = 0; i < 3; i++ )
+        {
+            /* free one version, then check the remaining ones */
+            JSON_Free( pVersion[ ( originFirst == true ) ? i : 2 - i ] );
+            pVersion[ ( originFirst == true ) ? i : 2 - i ] = NULL;
+
+            failures += TestCheck(
+                ( pVersion[0] == NULL ) ||
+                ( JSON_Equal( pVersion[0], pExpected[0] ) == true ),
+                "original survives freeing a version" );
+            failures += TestCheck(
+                ( pVersion[1] == NULL ) ||
+                ( JSON_Equal( pVersion[1], pExpected[1] ) == true ),
+                "version survives freeing another version" );
+            failures += TestCheck(
+                ( pVersion[2] == NULL ) ||
+                ( JSON_Equal( pVersion[2], pExpected[2] ) == true ),
+                "latest version survives freeing an older one" );
+        }
+    }
+    else
+    {
+        failures += TestCheck( false, "create persistent versions" );
+    }
+
+    for( i = 0; i < 3; i++ )
+    {
+        JSON_Free( pVersion[i] );
+        JSON_Free( pExpected[i] );
+    }
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestSmallRemove                                                         */
+/*!
+    Test removing inline members of a packed container
+
+    The TestSmallRemove function removes members stored inline in a
+    packed small container, frees one before the container and the
+    other after it, and checks that the container and the member which
+    outlived it are still usable.
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestSmallRemove( void )
+{
+    int failures = 0;
+    JNode *pDoc;
+    JNode *pExpected;
+    JNode *pA = NULL;
+    JNode *pB = NULL;
+    JObject *pHolder;
+
+    pDoc = JSON_ProcessBuffer(
+        "{\"a\":1,\"b\":\"two\",\"c\":[1,2],\"d\":true}" );
+    pExpected = JSON_ProcessBuffer(
+        "{\"c\":[1,2],\"d\":true,\"e\":\"five\"}" );
+    if( pDoc != NULL )
+    {
+        pA = JSON_Attribute( (JObject *)pDoc, "a" );
+        pB = JSON_Attribute( (JObject *)pDoc, "b" );
+    }
+
+    if( ( pA != NULL ) && ( pB != NULL ) )
+    {
+        failures += TestCheck( ( pB->flags & JSON_NODE_INLINE ) != 0,
+                               "small container is packed" );
+        failures += TestCheck( JSON_Remove( pDoc, pA ) == EOK,
+                               "remove inline member" );
+        failures += TestCheck( JSON_Remove( pDoc, pB ) == EOK,
+                               "remove another inline member" );
+
+        /* free one member before the container */
+        JSON_Free( pA );
+
+        JSON_ObjectAdd( (JObject *)pDoc,
+                        (JNode *)JSON_Str( strdup( "e" ), strdup( "five" ) ) );
+        failures += TestCheck( JSON_Equal( pDoc, pExpected ),
+                               "packed container after removals" );
+
+        /* and the other one after it */
+        JSON_Free( pDoc );
+        pDoc = NULL;
+
+        pHolder = JSON_Object( NULL );
+        JSON_ObjectAdd( pHolder, pB );
+        JSON_Free( pExpected );
+        pExpected = JSON_ProcessBuffer( "{\"b\":\"two\"}" );
+        failures += TestCheck( JSON_Equal( (JNode *)pHolder, pExpected ),
+                               "inline member outlives its container" );
+        JSON_Free( (JNode *)pHolder );
+    }
+    else
+    {
+        failures += TestCheck( false, "parse packed container" );
+    }
+
+    JSON_Free( pDoc );
+    JSON_Free( pExpected );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestIndexChurn                                                          */
+/*!
+    Test hash index promotion and demotion
+
+    The TestIndexChurn function repeatedly grows an object past the
+    hash index threshold and shrinks it below half of it again, in a
+    scattered order, checking every lookup after each phase.
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestIndexChurn( void )
+{
+    int failures = 0;
+    JObject *pObject;
+    JObjectIndexStats before;
+    JObjectIndexStats after;
+    JNode *pNode;
+    char name[16];
+    int round;
+    int i;
+    int k;
+    int val;
+    bool present;
+
+    JSON_SetObjectIndexThreshold( 16 );
+    JSON_GetObjectIndexStats( &before );
+
+    pObject = JSON_Object( NULL );
+    for( round = 0; ( round < 4 ) && ( pObject != NULL ); round++ )
+    {
+        for( i = 0; i < 64; i++ )
+        {
+            snprintf( name, sizeof( name ), "k%d", i );
+            if( JSON_Attribute( pObject, name ) == NULL )
+            {
+                JSON_ObjectAdd( pObject,
+                                (JNode *)JSON_Num( strdup( name ), i ) );
+            }
+        }
+
+        for( i = 0; i < 64; i++ )
+        {
+            snprintf( name, sizeof( name ), "k%d", i );
+            failures += TestCheck( ( JSON_GetNum( (JNode *)pObject,
+                                                  name,
+                                                  &val ) == EOK ) &&
+                                   ( val == i ),
+                                   "lookup after promotion" );
+        }
+
+        /* remove all but four members in a scattered order */
+        for( i = 0; i < 64; i++ )
+        {
+            k = ( i * 37 + round ) % 64;
+            snprintf( name, sizeof( name ), "k%d", k );
+            pNode = JSON_Attribute( pObject, name );
+            if( ( k >= 4 ) && ( pNode != NULL ) )
+            {
+                failures += TestCheck( JSON_Remove( (JNode *)pObject,
+                                                    pNode ) == EOK,
+                                       "remove indexed member" );
+                JSON_Free( pNode );
+            }
+        }
+
+        for( i = 0; i < 64; i++ )
+        {
+            snprintf( name, sizeof( name ), "k%d", i );
+            present = ( JSON_Attribute( pObject, name ) != NULL );
+            failures += TestCheck( present == ( i < 4 ),
+                                   "lookup after demotion" );
+        }
+    }
+
+    JSON_GetObjectIndexStats( &after );
+    failures += TestCheck( after.promotions >= before.promotions + 4,
+                           "objects are promoted to a hash index" );
+    failures += TestCheck( after.demotions >= before.demotions + 4,
+                           "objects are demoted from a hash index" );
+
+    JSON_Free( (JNode *)pObject );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestRetainDetach                                                        */
+/*!
+    Test a retained member outliving its document
+
+    The TestRetainDetach function retains a member of a document, frees
+    the document, and checks that the member was detached from its
+    siblings and is still intact.
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestRetainDetach( void )
+{
+    int failures = 0;
+    JNode *pDoc;
+    JNode *pKept = NULL;
+    JNode *pExpected;
+
+    pDoc = JSON_ProcessBuffer( memoryDoc );
+    pExpected = JSON_ProcessBuffer( "{\"d\":{\"e\":true}}" );
+    if( pDoc != NULL )
+    {
+        pKept = JSON_Retain( JSON_Attribute( (JObject *)pDoc, "c" ) );
+    }
+
+    JSON_Free( pDoc );
+
+    if( pKept != NULL )
+    {
+        failures += TestCheck( ( pKept->pPrev == NULL ) &&
+                               ( pKept->pNext == NULL ),
+                               "retained member is detached" );
+        failures += TestCheck( JSON_Equal( pKept, pExpected ),
+                               "retained member outlives its document" );
+        JSON_Release( pKept );
+    }
+    else
+    {
+        failures += TestCheck( false, "retain member" );
+    }
+
+    JSON_Free( pExpected );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  TestCloneFree                                                           */
+/*!
+    Test clones and arena allocated documents
+
+    The TestCloneFree function makes heap, sorted and arena clones of a
+    document, checks that they are read-only and that they outlive the
+    original, and frees them.  It also parses a document into its own
+    arena and frees it.
+
+    @retval 0 the test passed
+    @retval 1 the test failed
+
+============================================================================*/
+static int TestCloneFree( void )
+{
+    int failures = 0;
+    JNode *pDoc;
+    JNode *pExpected;
+    JNode *pClone;
+    JNode *pSorted;
+    JNode *pArenaClone;
+    JNode *pArenaDoc;
+    JNode *pNode;
+    JArena *pArena;
+
+    pDoc = JSON_ProcessBuffer( memoryDoc );
+    pExpected = JSON_ProcessBuffer( memoryDoc );
+    pArena = JSON_ArenaCreate( 0 );
+
+    pClone = JSON_Clone( pDoc, NULL );
+    pSorted = JSON_CloneSorted( pDoc, NULL );
+    pArenaClone = JSON_Clone( pDoc, pArena );
+
+    JSON_Free( pDoc );
+
+    failures += TestCheck( JSON_Equal( pClone, pExpected ),
+                           "clone outlives the original" );
+    failures += TestCheck( JSON_Equal( pSorted, pExpected ),
+                           "sorted clone outlives the original" );
+    failures += TestCheck( JSON_Equal( pArenaClone, pExpected ),
+                           "arena clone outlives the original" );
+    failures += TestCheck( JSON_Attribute( (JObject *)pSorted, "f" ) != NULL,
+                           "sorted clone lookup" );
+
+    failures += TestCheck( JSON_SetNum( pClone, "g", 1 ) == EPERM,
+                           "clone is read-only" );
+    pNode = (JNode *)JSON_Num( strdup( "g" ), 1 );
+    failures += TestCheck( JSON_ObjectAdd( (JObject *)pSorted,
+                                           pNode ) == EPERM,
+                           "sorted clone is read-only" );
+    JSON_Free( pNode );
+
+    /* an arena clone is freed with its arena */
+    JSON_Free( pArenaClone );
+    JSON_Free( pClone );
+    JSON_Free( pSorted );
+    JSON_ArenaDestroy( pArena );
+
+    pArenaDoc = JSON_ProcessBufferArena( memoryDoc );
+    failures += TestCheck( JSON_Equal( pArenaDoc, pExpected ),
+                           "document parsed into an arena" );
+    JSON_Free( pArenaDoc );
+
+    JSON_Free( pExpected );
+
+    return ( failures == 0 ) ? 0 : 1;
+}
+
+/*==========================================================================*/
+/*  BenchSmall                                                              */
+/*!
+    Benchmark packed small containers
+
+    The BenchSmall function compares documents whose small records were
+    packed into single allocations by the parser against the same
+    records parsed with packing disabled, and built one node at a time
+    with JSON_Object and JSON_ObjectAdd, which are not packed.  The
+    parse times show the cost of packing, and the lookup and free times
+    its benefit.  Each layout is measured on a fresh heap, and again
+    after the heap has been fragmented by freeing a random half of many
+    small blocks, which is the state of a long running process.
+
+============================================================================*/
+static void BenchSmall( void )
+{
+    char *buf;
+    char *p;
+    size_t i;
+    void **fragments;
+
+    buf = malloc( BENCH_RECORDS * 64 + 3 );
+    if( buf != NULL )
+    {
+        p = buf;
+        *p++ = '[';
+        for( i = 0; i < BENCH_RECORDS; i++ )
+        {
+            p += sprintf( p,
+                          "%s{\"ct\":%zu,\"p_W\":915,\"q_VAR\":-82,"
+                          "\"v_V\":120}",
+                          ( i == 0 ) ? "" : ",",
+                          i % 1000 );
+        }
+
+        *p++ = ']';
+        *p = 0;
+
+        printf( "%-12s%-10s%12s%12s%12s\n",
+                "heap",
+                "layout",
+                "load ms",
+                "lookup ms",
+                "free ms" );
+
+        BenchSmallRun( "fresh", "packed", buf, BENCH_SMALL_MAX );
+        BenchSmallRun( "fresh", "unpacked", buf, 0 );
+        BenchSmallRun( "fresh", "separate", NULL, 0 );
+
+        fragments = BenchFragment();
+
+        BenchSmallRun( "fragmented", "packed", buf, BENCH_SMALL_MAX );
+        BenchSmallRun( "fragmented", "unpacked", buf, 0 );
+        BenchSmallRun( "fragmented", "separate", NULL, 0 );
+
+        JSON_SetSmallContainerMax( BENCH_SMALL_MAX );
+
+        if( fragments != NULL )
+        {
+            for( i = 0; i < BENCH_FRAGMENTS; i++ )
+            {
+                free( fragments[i] );
+            }
+
+            free( fragments );
+        }
+
+        free( buf );
+    }
+}
+
+/*==========================================================================*/
+/*  BenchSmallRun                                                           */
+/*!
+    Measure one layout of the benchmark records
+
+    The BenchSmallRun function parses or builds the benchmark records,
+    looks up the last member of every record BENCH_PASSES times, then
+    frees the document, and prints the time taken by each step.
+
+    @param[in]
+        heap
+            description of the heap state
+
+    @param[in]
+        layout
+            description of the document layout
+
+    @param[in]
+        buf
+            pointer to the text of the records to parse, or NULL to
+            build them with BenchSmallBuild
+
+    @param[in]
+        max
+            largest container to pack when parsing, or 0 to disable
+            packing
+
+============================================================================*/
+static void BenchSmallRun( char *heap,
+                           char *layout,
+                           char *buf,
+                           size_t max )
+{
+    JNode *pDoc;
+    JNode *pRecord;
+    double start;
+    double load;
+    double lookup;
+    long sum = 0;
+    int val;
+    int i;
+
+    start = BenchTime();
+    if( buf != NULL )
+    {
+        JSON_SetSmallContainerMax( max );
+        pDoc = JSON_ProcessBuffer( buf );
+    }
+    else
+    {
+        pDoc = BenchSmallBuild();
+    }
+
+    load = BenchTime() - start;
+
+    if( ( pDoc != NULL ) &&
+        ( pDoc->type == JSON_ARRAY ) )
+    {
+        start = BenchTime();
+        for( i = 0; i < BENCH_PASSES; i++ )
+        {
+            pRecord = ((JArray *)pDoc)->pFirst;
+            while( pRecord != NULL )
+            {
+                if( JSON_GetNum( pRecord, "v_V", &val ) == EOK )
+                {
+                    sum += val;
+                }
+
+                pRecord = pRecord->pNext;
+            }
+        }
+
+        lookup = BenchTime() - start;
+
+        start = BenchTime();
+        JSON_Free( pDoc );
+
+        printf( "%-12s%-10s%12.1f%12.1f%12.1f\n",
+                heap,
+                layout,
+                load * 1000.0,
+                lookup * 1000.0,
+                ( BenchTime() - start ) * 1000.0 );
+
+        if( sum != (long)BENCH_PASSES * BENCH_RECORDS * 120 )
+        {
+            printf( "unexpected lookup result\n" );
+        }
+    }
+}
+
+/*==========================================================================*/
+/*  BenchSmallBuild                                                         */
+/*!
+    Build the benchmark records without packing
+
+    The BenchSmallBuild function builds the same records that BenchSmall
+    parses, using the node constructors, so every node and name is a
+    separate allocation as it is when the parser does not pack them.
+
+    @retval pointer to the array of records
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static JNode *BenchSmallBuild( void )
+{
+    char *names[] = { "ct", "p_W", "q_VAR", "v_V" };
+    int values[] = { 0, 915, -82, 120 };
+    JArray *pArray;
+    JObject *pRecord;
+    JVar *pVar;
+    size_t i;
+    int j;
+
+    pArray = JSON_Array( NULL );
+    for( i = 0; ( pArray != NULL ) && ( i < BENCH_RECORDS ); i++ )
+    {
+        pRecord = JSON_Object( NULL );
+        if( pRecord != NULL )
+        {
+            values[0] = i % 1000;
+            for( j = 0; j < 4; j++ )
+            {
+                pVar = JSON_Num( strdup( names[j] ), values[j] );
+                JSON_ObjectAdd( pRecord, (JNode *)pVar );
+            }
+
+            JSON_ArrayAdd( pArray, pRecord );
+        }
+    }
+
+    return (JNode *)pArray;
+}
+
+/*==========================================================================*/
+/*  BenchFragment                                                           */
+/*!
+    Fragment the heap
+
+    The BenchFragment function allocates BENCH_FRAGMENTS blocks of
+    random sizes similar to JSON nodes and frees a random half of them,
+    leaving small holes throughout the heap.
+
+    @retval array of the blocks still allocated, to be freed by the caller
+    @retval NULL memory allocation failure
+
+============================================================================*/
+static void **BenchFragment( void )
+{
+    void **fragments;
+    size_t i;
+
+    fragments = calloc( BENCH_FRAGMENTS, sizeof( void * ) );
+    if( fragments != NULL )
+    {
+        srand( 1 );
+
+        for( i = 0; i < BENCH_FRAGMENTS; i++ )
+        {
+            fragments[i] = malloc( 16 + ( rand() % 112 ) );
+        }
+
+        for( i = 0; i < BENCH_FRAGMENTS; i++ )
+        {
+            if( rand() & 1 )
+            {
+                free( fragments[i] );
+                fragments[i] = NULL;
+            }
+        }
+    }
+
+    return fragments;
+}
+
+/*==========================================================================*/
+/*  BenchTime                                                               */
+/*!
+    Get the current time
+
+    @retval monotonic time in seconds
+
+============================================================================*/
+static double BenchTime( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ts.tv_sec + ( ts.tv_nsec / 1e9 );
+}
+
 /*! @}
  * end of json_test group */